@@ -1,15 +1,66 @@
+import gzip
+import hashlib
+import ipaddress
+from pathlib import Path
+
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.const import CONF_ID
+import esphome.final_validate as fv
+from esphome.components import time as time_, uart
+from esphome.const import (
+    CONF_DAYS_OF_WEEK,
+    CONF_HOUR,
+    CONF_ID,
+    CONF_MINUTE,
+    CONF_RX_BUFFER_SIZE,
+    CONF_TIME_ID,
+    CONF_UART_ID,
+)
 from esphome import pins, automation
 
+DEPENDENCIES = ["uart"]
 AUTO_LOAD = ["sensor", "text_sensor", "binary_sensor", "web_server_base"]
+MULTI_CONF = True
 
 CONF_FINGERPRINT_DOORBELL_ID = "fingerprint_doorbell_id"
 CONF_TOUCH_PIN = "touch_pin"
 CONF_DOORBELL_PIN = "doorbell_pin"
+CONF_UNLOCK_PIN = "unlock_pin"
+CONF_UNLOCK_DURATION = "unlock_duration"
+CONF_ACCESS_WINDOWS = "access_windows"
+CONF_IDS = "ids"
+CONF_START = "start"
+CONF_END = "end"
 CONF_IGNORE_TOUCH_RING = "ignore_touch_ring"
 CONF_API_TOKEN = "api_token"
+CONF_PREFERENCES_NAMESPACE = "preferences_namespace"
+CONF_REST_PREFIX = "rest_prefix"
+CONF_REST_API = "rest_api"
+CONF_TEMPLATE_TRANSFER = "template_transfer"
+CONF_WEB_UI = "web_ui"
+CONF_WEB_UI_DATA_ID = "web_ui_data_id"
+CONF_AUTO_ENROLL = "auto_enroll"
+CONF_ENROLL_VERIFY_TOUCHES = "enroll_verify_touches"
+CONF_ENROLL_MIN_QUALITY = "enroll_min_quality"
+CONF_ENROLL_RETRIES = "enroll_retries"
+CONF_TEMPLATE_REFRESH = "template_refresh"
+CONF_TEMPLATE_REFRESH_MIN_CONFIDENCE = "template_refresh_min_confidence"
+CONF_TEMPLATE_REFRESH_INTERVAL = "template_refresh_interval"
+CONF_TRACE_BUFFER_SIZE = "trace_buffer_size"
+CONF_CAPTURE_BUFFER_SIZE = "capture_buffer_size"
+CONF_TEMPLATE_TRANSFER_RETRIES = "template_transfer_retries"
+CONF_TEMPLATE_VERIFY_UPLOAD = "template_verify_upload"
+CONF_VERIFY_MIN_CONFIDENCE = "verify_min_confidence"
+CONF_MAX_FINGERPRINTS = "max_fingerprints"
+CONF_COLD_STORAGE_PARTITION = "cold_storage_partition"
+CONF_HOT_SLOTS = "hot_slots"
+CONF_CACHE_SLOTS = "cache_slots"
+CONF_COLD_SEARCH_MAX = "cold_search_max"
+CONF_COLD_SEARCH_BUDGET = "cold_search_budget"
+CONF_EVENT_MULTICAST = "event_multicast"
+CONF_EVENT_MULTICAST_ADDRESS = "event_multicast_address"
+CONF_EVENT_MULTICAST_PORT = "event_multicast_port"
+CONF_EVENT_MULTICAST_KEY = "event_multicast_key"
 
 # LED configuration constants
 CONF_LED_READY_COLOR = "led_ready_color"
@@ -31,6 +82,18 @@ CONF_LED_NO_MATCH_COLOR = "led_no_match_color"
 CONF_LED_NO_MATCH_MODE = "led_no_match_mode"
 CONF_LED_NO_MATCH_SPEED = "led_no_match_speed"
 
+# Access window days as bits, Sunday = bit 0 (ESPTime day_of_week - 1)
+WEEK_DAYS = {
+    "sun": 0,
+    "mon": 1,
+    "tue": 2,
+    "wed": 3,
+    "thu": 4,
+    "fri": 5,
+    "sat": 6,
+}
+MAX_ACCESS_WINDOWS = 7
+
 # LED color enum values (matching Adafruit library)
 LED_COLORS = {
     "red": 1,
@@ -50,23 +113,188 @@ LED_MODES = {
 
 fingerprint_doorbell_ns = cg.esphome_ns.namespace("fingerprint_doorbell")
 FingerprintDoorbell = fingerprint_doorbell_ns.class_(
-    "FingerprintDoorbell", cg.Component
+    "FingerprintDoorbell", cg.Component, uart.UARTDevice
+)
+
+# A template data packet is up to 256 + 11 bytes and must fit while we parse it
+MIN_RX_BUFFER_SIZE = 512
+
+# IDs the sensor's own library holds; more need cold_storage_partition
+SENSOR_ID_LIMIT = 200
+MAX_ID_LIMIT = 1000
+
+
+def validate_rest_prefix(value):
+    value = cv.string_strict(value)
+    if not value.startswith("/") or value.endswith("/"):
+        raise cv.Invalid("rest_prefix must start with '/' and must not end with '/'")
+    return value
+
+def _window_is_always_open(window):
+    start = window.get(CONF_START)
+    end = window.get(CONF_END)
+    return len(set(window[CONF_DAYS_OF_WEEK])) == len(WEEK_DAYS) and start == end
+
+
+def _minutes(time_of_day):
+    return time_of_day[CONF_HOUR] * 60 + time_of_day[CONF_MINUTE]
+
+
+ACCESS_WINDOW_SCHEMA = cv.Schema(
+    {
+        # Slots allowed in this window by default, empty = every slot
+        cv.Optional(CONF_IDS, default=[]): cv.ensure_list(cv.int_range(min=1, max=MAX_ID_LIMIT)),
+        cv.Optional(CONF_DAYS_OF_WEEK, default=list(WEEK_DAYS)): cv.ensure_list(
+            cv.one_of(*WEEK_DAYS, lower=True)
+        ),
+        cv.Inclusive(CONF_START, "time_range"): cv.time_of_day,
+        cv.Inclusive(CONF_END, "time_range"): cv.time_of_day,
+    }
 )
 
+
+def validate_unlock(config):
+    windows = config.get(CONF_ACCESS_WINDOWS, [])
+    if windows and CONF_UNLOCK_PIN not in config:
+        raise cv.Invalid("access_windows need an unlock_pin", path=[CONF_ACCESS_WINDOWS])
+    if CONF_TIME_ID not in config and not all(_window_is_always_open(w) for w in windows):
+        raise cv.Invalid("access_windows limited by day or time need a time_id", path=[CONF_ACCESS_WINDOWS])
+    if not config[CONF_REST_API] and config[CONF_CAPTURE_BUFFER_SIZE]:
+        raise cv.Invalid("capture_buffer_size needs rest_api to download the capture", path=[CONF_CAPTURE_BUFFER_SIZE])
+    return config
+
+
+def validate_tiers(config):
+    max_ids = config[CONF_MAX_FINGERPRINTS]
+    if CONF_COLD_STORAGE_PARTITION not in config:
+        if max_ids > SENSOR_ID_LIMIT:
+            raise cv.Invalid(
+                f"more than {SENSOR_ID_LIMIT} fingerprints need a cold_storage_partition",
+                path=[CONF_MAX_FINGERPRINTS],
+            )
+        return config
+    if config[CONF_HOT_SLOTS] >= max_ids:
+        raise cv.Invalid("hot_slots must be below max_fingerprints", path=[CONF_HOT_SLOTS])
+    if config[CONF_HOT_SLOTS] + config[CONF_CACHE_SLOTS] >= SENSOR_ID_LIMIT:
+        raise cv.Invalid(
+            f"hot_slots + cache_slots must fit the sensor's library (below {SENSOR_ID_LIMIT})",
+            path=[CONF_CACHE_SLOTS],
+        )
+    return config
+
+
+def multicast_address(value):
+    value = cv.string_strict(value)
+    try:
+        address = ipaddress.IPv4Address(value)
+    except ValueError as err:
+        raise cv.Invalid(f"'{value}' is not an IPv4 address") from err
+    if not address.is_multicast:
+        raise cv.Invalid(f"'{value}' is not a multicast address (224.0.0.0-239.255.255.255)")
+    return value
+
+
+def multicast_key(value):
+    value = cv.string_strict(value)
+    try:
+        key = bytes.fromhex(value)
+    except ValueError as err:
+        raise cv.Invalid("event_multicast_key must be hexadecimal") from err
+    if len(key) != 32:
+        raise cv.Invalid(f"event_multicast_key must be 64 hex digits (32 bytes), got {len(key)} bytes")
+    return value
+
+
+def validate_event_multicast(config):
+    # Unsigned datagrams could be forged; without a key of its own, the key comes from the token
+    if config[CONF_EVENT_MULTICAST] and CONF_API_TOKEN not in config and CONF_EVENT_MULTICAST_KEY not in config:
+        raise cv.Invalid(
+            "event_multicast needs an api_token or an event_multicast_key to sign the datagrams",
+            path=[CONF_EVENT_MULTICAST],
+        )
+    return config
+
 # Actions for automations
 EnrollAction = fingerprint_doorbell_ns.class_("EnrollAction", automation.Action)
+EnrollSessionAction = fingerprint_doorbell_ns.class_("EnrollSessionAction", automation.Action)
 CancelEnrollAction = fingerprint_doorbell_ns.class_("CancelEnrollAction", automation.Action)
 DeleteAction = fingerprint_doorbell_ns.class_("DeleteAction", automation.Action)
+DeleteBatchAction = fingerprint_doorbell_ns.class_("DeleteBatchAction", automation.Action)
 DeleteAllAction = fingerprint_doorbell_ns.class_("DeleteAllAction", automation.Action)
 RenameAction = fingerprint_doorbell_ns.class_("RenameAction", automation.Action)
+RenameBatchAction = fingerprint_doorbell_ns.class_("RenameBatchAction", automation.Action)
+VerifyAction = fingerprint_doorbell_ns.class_("VerifyAction", automation.Action)
 
 CONFIG_SCHEMA = cv.Schema(
     {
         cv.GenerateID(): cv.declare_id(FingerprintDoorbell),
         cv.Optional(CONF_TOUCH_PIN): pins.gpio_input_pin_schema,
         cv.Optional(CONF_DOORBELL_PIN): pins.gpio_output_pin_schema,
+        # Door relay driven straight from a match, gated by access_windows
+        cv.Optional(CONF_UNLOCK_PIN): pins.gpio_output_pin_schema,
+        cv.Optional(CONF_UNLOCK_DURATION, default="1s"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(min=cv.TimePeriod(milliseconds=100), max=cv.TimePeriod(seconds=30)),
+        ),
+        cv.Optional(CONF_ACCESS_WINDOWS): cv.All(
+            cv.ensure_list(ACCESS_WINDOW_SCHEMA), cv.Length(min=1, max=MAX_ACCESS_WINDOWS)
+        ),
+        cv.Optional(CONF_TIME_ID): cv.use_id(time_.RealTimeClock),
         cv.Optional(CONF_IGNORE_TOUCH_RING, default=False): cv.boolean,
         cv.Optional(CONF_API_TOKEN): cv.string,
+        # Per-instance storage keys and REST path, needed when several sensors share one ESP32
+        cv.Optional(CONF_PREFERENCES_NAMESPACE, default=""): cv.string_strict,
+        cv.Optional(CONF_REST_PREFIX, default="/fingerprint"): validate_rest_prefix,
+        # Left out of the build when false: REST API, jobs, image capture, pairing endpoints
+        cv.Optional(CONF_REST_API, default=True): cv.boolean,
+        # Template export/import over REST (base64 codec, chunked import, transfer jobs)
+        cv.Optional(CONF_TEMPLATE_TRANSFER, default=True): cv.boolean,
+        # Management page at <rest_prefix>/ui, about 3 KB of flash
+        cv.Optional(CONF_WEB_UI, default=True): cv.boolean,
+        cv.GenerateID(CONF_WEB_UI_DATA_ID): cv.declare_id(cg.uint8),
+        # Use the sensor's AutoEnroll command instead of host-driven enrollment
+        cv.Optional(CONF_AUTO_ENROLL, default=False): cv.boolean,
+        # Enrollment quality gate (extra touches matched against the stored model)
+        cv.Optional(CONF_ENROLL_VERIFY_TOUCHES, default=0): cv.int_range(min=0, max=5),
+        cv.Optional(CONF_ENROLL_MIN_QUALITY, default=50): cv.int_range(min=0, max=400),
+        cv.Optional(CONF_ENROLL_RETRIES, default=1): cv.int_range(min=0, max=5),
+        # Adaptive template refresh on high-confidence matches
+        cv.Optional(CONF_TEMPLATE_REFRESH, default=False): cv.boolean,
+        cv.Optional(CONF_TEMPLATE_REFRESH_MIN_CONFIDENCE, default=200): cv.int_range(min=1, max=400),
+        cv.Optional(CONF_TEMPLATE_REFRESH_INTERVAL, default="24h"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(min=cv.TimePeriod(minutes=1), max=cv.TimePeriod(days=30)),
+        ),
+        # Template export/import: retries after link errors, read-back check after import
+        cv.Optional(CONF_TEMPLATE_TRANSFER_RETRIES, default=2): cv.int_range(min=0, max=5),
+        cv.Optional(CONF_TEMPLATE_VERIFY_UPLOAD, default=True): cv.boolean,
+        # Minimum 1:1 match score for verifying a claimed identity
+        cv.Optional(CONF_VERIFY_MIN_CONFIDENCE, default=100): cv.int_range(min=0, max=400),
+        # Highest fingerprint ID; above the sensor's library only with tiered storage
+        cv.Optional(CONF_MAX_FINGERPRINTS, default=SENSOR_ID_LIMIT): cv.int_range(min=1, max=MAX_ID_LIMIT),
+        # Tiered storage: IDs above hot_slots live in this data partition, the most recently
+        # matched of them in cache_slots sensor slots
+        cv.Optional(CONF_COLD_STORAGE_PARTITION): cv.All(cv.string_strict, cv.Length(min=1, max=16)),
+        cv.Optional(CONF_HOT_SLOTS, default=170): cv.int_range(min=1, max=MAX_ID_LIMIT - 1),
+        cv.Optional(CONF_CACHE_SLOTS, default=20): cv.int_range(min=1, max=32),
+        # Cold fallback per touch: at most this many templates, within this time
+        cv.Optional(CONF_COLD_SEARCH_MAX, default=8): cv.int_range(min=1, max=32),
+        cv.Optional(CONF_COLD_SEARCH_BUDGET, default="2s"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(min=cv.TimePeriod(milliseconds=300), max=cv.TimePeriod(seconds=10)),
+        ),
+        # Ring and match events as signed UDP multicast datagrams for LAN listeners
+        cv.Optional(CONF_EVENT_MULTICAST, default=False): cv.boolean,
+        cv.Optional(CONF_EVENT_MULTICAST_ADDRESS, default="239.255.70.68"): multicast_address,
+        cv.Optional(CONF_EVENT_MULTICAST_PORT, default=47068): cv.port,
+        # Datagram key for receivers, 64 hex digits; derived from api_token when left out
+        cv.Optional(CONF_EVENT_MULTICAST_KEY): multicast_key,
+        # Trace recorder ring size in events (16 bytes each), 0 disables tracing
+        cv.Optional(CONF_TRACE_BUFFER_SIZE, default=0): cv.int_range(min=0, max=4096),
+        # Sensor traffic capture ring in bytes (power of two, e.g. 32768), 0 disables it
+        cv.Optional(CONF_CAPTURE_BUFFER_SIZE, default=0): cv.Any(
+            cv.one_of(0, int=True), cv.int_range(min=1024, max=262144)
+        ),
         # LED Ready state (idle, waiting for finger)
         cv.Optional(CONF_LED_READY_COLOR): cv.one_of(*LED_COLORS, lower=True),
         cv.Optional(CONF_LED_READY_MODE): cv.one_of(*LED_MODES, lower=True),
@@ -92,18 +320,60 @@ CONFIG_SCHEMA = cv.Schema(
         cv.Optional(CONF_LED_NO_MATCH_MODE): cv.one_of(*LED_MODES, lower=True),
         cv.Optional(CONF_LED_NO_MATCH_SPEED): cv.int_range(min=0, max=255),
     }
-).extend(cv.COMPONENT_SCHEMA)
+).extend(cv.COMPONENT_SCHEMA).extend(uart.UART_DEVICE_SCHEMA).add_extra(validate_unlock).add_extra(validate_tiers).add_extra(validate_event_multicast)
+
+
+def _final_validate(config):
+    uart.final_validate_device_schema(
+        "fingerprint_doorbell", baud_rate=57600, require_rx=True, require_tx=True
+    )(config)
+
+    full_config = fv.full_config.get()
+    for uart_config in full_config.get("uart", []):
+        if uart_config[CONF_ID] == config[CONF_UART_ID]:
+            if uart_config[CONF_RX_BUFFER_SIZE] < MIN_RX_BUFFER_SIZE:
+                raise cv.Invalid(
+                    f"fingerprint_doorbell needs rx_buffer_size >= {MIN_RX_BUFFER_SIZE} on uart "
+                    f"'{config[CONF_UART_ID]}'"
+                )
+
+    # Instances must not share names, pairing password or REST endpoints
+    instances = full_config.get("fingerprint_doorbell", [])
+    for key in (CONF_PREFERENCES_NAMESPACE, CONF_REST_PREFIX):
+        if [instance[key] for instance in instances].count(config[key]) > 1:
+            raise cv.Invalid(
+                f"Each fingerprint_doorbell needs its own {key}, '{config[key]}' is used more than once",
+                path=[key],
+            )
+    # The ID limit sizes shared tables at compile time
+    if any(instance[CONF_MAX_FINGERPRINTS] != config[CONF_MAX_FINGERPRINTS] for instance in instances):
+        raise cv.Invalid(
+            "All fingerprint_doorbell instances need the same max_fingerprints", path=[CONF_MAX_FINGERPRINTS]
+        )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = _final_validate
 
 
 # Action schemas for automations
 ENROLL_ACTION_SCHEMA = automation.maybe_simple_id(
     {
         cv.GenerateID(): cv.use_id(FingerprintDoorbell),
-        cv.Required("finger_id"): cv.templatable(cv.int_range(min=1, max=200)),
+        cv.Required("finger_id"): cv.templatable(cv.int_range(min=1, max=MAX_ID_LIMIT)),
         cv.Required("name"): cv.templatable(cv.string),
     }
 )
 
+ENROLL_SESSION_ACTION_SCHEMA = automation.maybe_simple_id(
+    {
+        cv.GenerateID(): cv.use_id(FingerprintDoorbell),
+        cv.Required("names"): cv.templatable(
+            cv.All(cv.ensure_list(cv.string), cv.Length(min=1, max=MAX_ID_LIMIT))
+        ),
+    }
+)
+
 CANCEL_ENROLL_ACTION_SCHEMA = automation.maybe_simple_id(
     {
         cv.GenerateID(): cv.use_id(FingerprintDoorbell),
@@ -113,7 +383,40 @@ CANCEL_ENROLL_ACTION_SCHEMA = automation.maybe_simple_id(
 DELETE_ACTION_SCHEMA = automation.maybe_simple_id(
     {
         cv.GenerateID(): cv.use_id(FingerprintDoorbell),
-        cv.Required("finger_id"): cv.templatable(cv.int_range(min=1, max=200)),
+        cv.Required("finger_id"): cv.templatable(cv.int_range(min=1, max=MAX_ID_LIMIT)),
+    }
+)
+
+# IDs and ranges like "1,3,5-9", the format parse_id_list() reads
+def validate_id_list(value):
+    value = cv.string_strict(value)
+    for entry in value.split(","):
+        first, _, last = entry.partition("-")
+        try:
+            first = int(first)
+            last = int(last) if last else first
+        except ValueError as err:
+            raise cv.Invalid(f"'{entry}' is not an ID or range like 5-9") from err
+        if not 1 <= first <= last <= MAX_ID_LIMIT:
+            raise cv.Invalid(f"'{entry}' must be an ID or ascending range within 1-{MAX_ID_LIMIT}")
+    return value
+
+
+# id:name or range:name entries like "1:Alice,10-15:Guest"
+def validate_name_list(value):
+    value = cv.string_strict(value)
+    for entry in value.split(","):
+        ids, _, name = entry.partition(":")
+        if not name:
+            raise cv.Invalid(f"'{entry}' must look like id:name or range:name")
+        validate_id_list(ids)
+    return value
+
+
+DELETE_BATCH_ACTION_SCHEMA = automation.maybe_simple_id(
+    {
+        cv.GenerateID(): cv.use_id(FingerprintDoorbell),
+        cv.Required("ids"): cv.templatable(validate_id_list),
     }
 )
 
@@ -126,11 +429,32 @@ DELETE_ALL_ACTION_SCHEMA = automation.maybe_simple_id(
 RENAME_ACTION_SCHEMA = automation.maybe_simple_id(
     {
         cv.GenerateID(): cv.use_id(FingerprintDoorbell),
-        cv.Required("finger_id"): cv.templatable(cv.int_range(min=1, max=200)),
+        cv.Required("finger_id"): cv.templatable(cv.int_range(min=1, max=MAX_ID_LIMIT)),
         cv.Required("name"): cv.templatable(cv.string),
     }
 )
 
+RENAME_BATCH_ACTION_SCHEMA = automation.maybe_simple_id(
+    {
+        cv.GenerateID(): cv.use_id(FingerprintDoorbell),
+        cv.Required("names"): cv.templatable(validate_name_list),
+    }
+)
+
+VERIFY_ACTION_SCHEMA = automation.maybe_simple_id(
+    {
+        cv.GenerateID(): cv.use_id(FingerprintDoorbell),
+        cv.Required("finger_id"): cv.templatable(cv.int_range(min=1, max=MAX_ID_LIMIT)),
+        cv.Optional("arm", default=True): cv.templatable(cv.boolean),
+        cv.Optional("timeout", default="10s"): cv.templatable(
+            cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(seconds=1), max=cv.TimePeriod(minutes=5)),
+            )
+        ),
+    }
+)
+
 
 @automation.register_action("fingerprint_doorbell.enroll", EnrollAction, ENROLL_ACTION_SCHEMA)
 async def enroll_action_to_code(config, action_id, template_arg, args):
@@ -146,6 +470,21 @@ async def enroll_action_to_code(config, action_id, template_arg, args):
     return var
 
 
+@automation.register_action("fingerprint_doorbell.enroll_session", EnrollSessionAction, ENROLL_SESSION_ACTION_SCHEMA)
+async def enroll_session_action_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    
+    names = config["names"]
+    if cg.is_template(names):
+        template_ = await cg.templatable(names, args, cg.std_vector.template(cg.std_string))
+        cg.add(var.set_names_template(template_))
+    else:
+        cg.add(var.set_names_static(names))
+    
+    return var
+
+
 @automation.register_action("fingerprint_doorbell.cancel_enroll", CancelEnrollAction, CANCEL_ENROLL_ACTION_SCHEMA)
 async def cancel_enroll_action_to_code(config, action_id, template_arg, args):
     var = cg.new_Pvariable(action_id, template_arg)
@@ -164,6 +503,17 @@ async def delete_action_to_code(config, action_id, template_arg, args):
     return var
 
 
+@automation.register_action("fingerprint_doorbell.delete_batch", DeleteBatchAction, DELETE_BATCH_ACTION_SCHEMA)
+async def delete_batch_action_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    
+    template_ = await cg.templatable(config["ids"], args, cg.std_string)
+    cg.add(var.set_ids(template_))
+    
+    return var
+
+
 @automation.register_action("fingerprint_doorbell.delete_all", DeleteAllAction, DELETE_ALL_ACTION_SCHEMA)
 async def delete_all_action_to_code(config, action_id, template_arg, args):
     var = cg.new_Pvariable(action_id, template_arg)
@@ -185,9 +535,40 @@ async def rename_action_to_code(config, action_id, template_arg, args):
     return var
 
 
+@automation.register_action("fingerprint_doorbell.rename_batch", RenameBatchAction, RENAME_BATCH_ACTION_SCHEMA)
+async def rename_batch_action_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    
+    template_ = await cg.templatable(config["names"], args, cg.std_string)
+    cg.add(var.set_names(template_))
+    
+    return var
+
+
+@automation.register_action("fingerprint_doorbell.verify", VerifyAction, VERIFY_ACTION_SCHEMA)
+async def verify_action_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    
+    template_ = await cg.templatable(config["finger_id"], args, cg.uint16)
+    cg.add(var.set_finger_id(template_))
+    
+    template_ = await cg.templatable(config["arm"], args, cg.bool_)
+    cg.add(var.set_arm(template_))
+    
+    template_ = await cg.templatable(config["timeout"], args, cg.uint32)
+    cg.add(var.set_timeout(template_))
+    
+    return var
+
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
+    await uart.register_uart_device(var, config)
+    cg.add(var.set_preferences_namespace(config[CONF_PREFERENCES_NAMESPACE]))
+    cg.add(var.set_rest_prefix(config[CONF_REST_PREFIX]))
 
     if CONF_TOUCH_PIN in config:
         touch_pin = await cg.gpio_pin_expression(config[CONF_TOUCH_PIN])
@@ -197,10 +578,79 @@ async def to_code(config):
         doorbell_pin = await cg.gpio_pin_expression(config[CONF_DOORBELL_PIN])
         cg.add(var.set_doorbell_pin(doorbell_pin))
 
+    if CONF_UNLOCK_PIN in config:
+        unlock_pin = await cg.gpio_pin_expression(config[CONF_UNLOCK_PIN])
+        cg.add(var.set_unlock_pin(unlock_pin))
+        cg.add(var.set_unlock_duration(config[CONF_UNLOCK_DURATION].total_milliseconds))
+        # Without windows any match unlocks
+        windows = config.get(CONF_ACCESS_WINDOWS, [{CONF_IDS: [], CONF_DAYS_OF_WEEK: list(WEEK_DAYS)}])
+        for window in windows:
+            days = 0
+            for day in window[CONF_DAYS_OF_WEEK]:
+                days |= 1 << WEEK_DAYS[day]
+            start = _minutes(window[CONF_START]) if CONF_START in window else 0
+            end = _minutes(window[CONF_END]) if CONF_END in window else 0
+            cg.add(var.add_access_window(days, start, end, window[CONF_IDS]))
+
+    if CONF_TIME_ID in config:
+        clock = await cg.get_variable(config[CONF_TIME_ID])
+        cg.add(var.set_time(clock))
+
     cg.add(var.set_ignore_touch_ring(config[CONF_IGNORE_TOUCH_RING]))
 
+    # Features left out of the build when no instance uses them. Defines are global, so
+    # one instance asking for a feature compiles it in for all of them. What an instance
+    # runs follows its own settings: these flags, an empty api_token, a zero
+    # capture_buffer_size, no cold_storage_partition or no event_multicast address.
+    cg.add(var.set_rest_api(config[CONF_REST_API]))
+    cg.add(var.set_template_transfer(config[CONF_REST_API] and config[CONF_TEMPLATE_TRANSFER]))
+    if config[CONF_REST_API]:
+        cg.add_define("USE_FINGERPRINT_DOORBELL_REST")
+        if config[CONF_TEMPLATE_TRANSFER]:
+            cg.add_define("USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER")
+            cg.add_define("USE_FINGERPRINT_DOORBELL_TEMPLATE_IO")
+        if CONF_API_TOKEN in config:
+            cg.add_define("USE_FINGERPRINT_DOORBELL_API_TOKEN")
+        if config[CONF_CAPTURE_BUFFER_SIZE]:
+            cg.add_define("USE_FINGERPRINT_DOORBELL_CAPTURE")
+
+    cg.add_define("FINGERPRINT_DOORBELL_MAX_ID", config[CONF_MAX_FINGERPRINTS])
+    if CONF_COLD_STORAGE_PARTITION in config:
+        # Cold templates are moved to and from the sensor with the template transfer code
+        cg.add_define("USE_FINGERPRINT_DOORBELL_TIERED")
+        cg.add_define("USE_FINGERPRINT_DOORBELL_TEMPLATE_IO")
+        cg.add(var.set_cold_storage_partition(config[CONF_COLD_STORAGE_PARTITION]))
+        cg.add(var.set_hot_slots(config[CONF_HOT_SLOTS]))
+        cg.add(var.set_cache_slots(config[CONF_CACHE_SLOTS]))
+        cg.add(var.set_cold_search_max(config[CONF_COLD_SEARCH_MAX]))
+        cg.add(var.set_cold_search_budget(config[CONF_COLD_SEARCH_BUDGET].total_milliseconds))
+
     if CONF_API_TOKEN in config:
         cg.add(var.set_api_token(config[CONF_API_TOKEN]))
+    if config[CONF_EVENT_MULTICAST]:
+        cg.add_define("USE_FINGERPRINT_DOORBELL_MULTICAST")
+        cg.add(var.set_event_multicast(config[CONF_EVENT_MULTICAST_ADDRESS], config[CONF_EVENT_MULTICAST_PORT]))
+        if CONF_EVENT_MULTICAST_KEY in config:
+            cg.add(var.set_event_multicast_key(list(bytes.fromhex(config[CONF_EVENT_MULTICAST_KEY]))))
+
+    if config[CONF_REST_API] and config[CONF_WEB_UI]:
+        # Compressed once at build time (mtime=0 keeps it reproducible) and served as is
+        page = gzip.compress((Path(__file__).parent / "web_ui.html").read_bytes(), 9, mtime=0)
+        data = cg.progmem_array(config[CONF_WEB_UI_DATA_ID], list(page))
+        cg.add(var.set_web_ui(data, len(page), hashlib.sha256(page).hexdigest()[:16]))
+
+    cg.add(var.set_auto_enroll(config[CONF_AUTO_ENROLL]))
+    cg.add(var.set_enroll_verify_touches(config[CONF_ENROLL_VERIFY_TOUCHES]))
+    cg.add(var.set_enroll_min_quality(config[CONF_ENROLL_MIN_QUALITY]))
+    cg.add(var.set_enroll_retries(config[CONF_ENROLL_RETRIES]))
+    cg.add(var.set_template_refresh(config[CONF_TEMPLATE_REFRESH]))
+    cg.add(var.set_template_refresh_min_confidence(config[CONF_TEMPLATE_REFRESH_MIN_CONFIDENCE]))
+    cg.add(var.set_template_refresh_interval(config[CONF_TEMPLATE_REFRESH_INTERVAL].total_milliseconds))
+    cg.add(var.set_trace_buffer_size(config[CONF_TRACE_BUFFER_SIZE]))
+    cg.add(var.set_capture_buffer_size(config[CONF_CAPTURE_BUFFER_SIZE]))
+    cg.add(var.set_template_transfer_retries(config[CONF_TEMPLATE_TRANSFER_RETRIES]))
+    cg.add(var.set_template_verify_upload(config[CONF_TEMPLATE_VERIFY_UPLOAD]))
+    cg.add(var.set_verify_min_confidence(config[CONF_VERIFY_MIN_CONFIDENCE]))
 
     # LED Ready configuration (only if any value specified)
     if CONF_LED_READY_COLOR in config or CONF_LED_READY_MODE in config or CONF_LED_READY_SPEED in config:
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// Weekly time window. days: bit 0 = Sunday ... bit 6 = Saturday. start/end are minutes
+// since midnight; start == end is all day, start > end runs past midnight (the part
+// after midnight counts for the day the window started).
+struct AccessWindow {
+  uint8_t days;
+  uint16_t start;
+  uint16_t end;
+};
+
+static const uint8_t ACCESS_ALL_DAYS = 0x7F;
+
+// Which slots may unlock when. Windows come from YAML, and so does the default set of
+// windows per slot (its allowlist); a slot's set can be overridden at runtime. Checking
+// a slot is a table lookup and a few compares, cheap enough for the match path.
+template<uint16_t MaxId> class AccessPolicy {
+ public:
+  static constexpr uint8_t MAX_WINDOWS = 7;
+  static constexpr uint8_t USE_DEFAULT = 0xFF;  // Override value: follow the YAML allowlist
+  using Overrides = std::array<uint8_t, MaxId + 1>;
+
+  AccessPolicy() { this->overrides_.fill(USE_DEFAULT); }
+
+  // Returns the window index, or -1 when all windows are taken
+  int add_window(uint8_t days, uint16_t start, uint16_t end) {
+    if (this->window_count_ >= MAX_WINDOWS)
+      return -1;
+    this->windows_[this->window_count_] = {days, start, end};
+    return this->window_count_++;
+  }
+  void allow_by_default(uint8_t window, uint16_t id) {
+    if (id <= MaxId && window < this->window_count_)
+      this->defaults_[id] |= 1 << window;
+  }
+
+  uint8_t window_count() const { return this->window_count_; }
+  const AccessWindow &window(uint8_t index) const { return this->windows_[index]; }
+
+  // Bitmask of windows slot `id` may unlock in
+  uint8_t windows_for(uint16_t id) const {
+    if (id > MaxId)
+      return 0;
+    return this->overrides_[id] != USE_DEFAULT ? this->overrides_[id] : this->defaults_[id];
+  }
+  bool is_overridden(uint16_t id) const { return id <= MaxId && this->overrides_[id] != USE_DEFAULT; }
+  void set_override(uint16_t id, uint8_t windows) {
+    if (id <= MaxId)
+      this->overrides_[id] = windows == USE_DEFAULT ? USE_DEFAULT : windows & ((1 << MAX_WINDOWS) - 1);
+  }
+  Overrides &overrides() { return this->overrides_; }
+
+  // day: 0 = Sunday, -1 if the time is not known (only always-open windows apply then)
+  bool allowed(uint16_t id, int day, uint16_t minute) const {
+    uint8_t mask = this->windows_for(id);
+    while (mask != 0) {
+      uint8_t index = __builtin_ctz(mask);
+      mask &= mask - 1;
+      if (is_open(this->windows_[index], day, minute))
+        return true;
+    }
+    return false;
+  }
+
+ protected:
+  static bool is_open(const AccessWindow &w, int day, uint16_t minute) {
+    bool all_day = w.start == w.end;
+    if (all_day && w.days == ACCESS_ALL_DAYS)
+      return true;
+    if (day < 0)
+      return false;
+    if (all_day)
+      return (w.days >> day) & 1;
+    if (w.start < w.end)
+      return ((w.days >> day) & 1) && minute >= w.start && minute < w.end;
+    if (minute >= w.start)
+      return (w.days >> day) & 1;
+    return minute < w.end && ((w.days >> ((day + 6) % 7)) & 1);
+  }
+
+  std::array<AccessWindow, MAX_WINDOWS> windows_{};
+  uint8_t window_count_{0};
+  std::array<uint8_t, MaxId + 1> defaults_{};
+  Overrides overrides_;
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
@@ -3,6 +3,7 @@ import esphome.config_validation as cv
 from esphome.components import binary_sensor
 from esphome.const import (
     CONF_ID,
+    DEVICE_CLASS_LOCK,
     DEVICE_CLASS_OCCUPANCY,
 )
 from . import FingerprintDoorbell, CONF_FINGERPRINT_DOORBELL_ID, fingerprint_doorbell_ns
@@ -11,6 +12,7 @@ DEPENDENCIES = ["fingerprint_doorbell"]
 
 CONF_RING = "ring"
 CONF_FINGER = "finger"
+CONF_UNLOCK = "unlock"
 
 CONFIG_SCHEMA = cv.Schema(
     {
@@ -21,6 +23,10 @@ CONFIG_SCHEMA = cv.Schema(
         cv.Optional(CONF_FINGER): binary_sensor.binary_sensor_schema(
             device_class=DEVICE_CLASS_OCCUPANCY,
         ),
+        # On while unlock_pin is driven (published after the relay switched)
+        cv.Optional(CONF_UNLOCK): binary_sensor.binary_sensor_schema(
+            device_class=DEVICE_CLASS_LOCK,
+        ),
     }
 )
 
@@ -35,3 +41,7 @@ async def to_code(config):
     if CONF_FINGER in config:
         sens = await binary_sensor.new_binary_sensor(config[CONF_FINGER])
         cg.add(parent.set_finger_sensor(sens))
+
+    if CONF_UNLOCK in config:
+        sens = await binary_sensor.new_binary_sensor(config[CONF_UNLOCK])
+        cg.add(parent.set_unlock_sensor(sens))
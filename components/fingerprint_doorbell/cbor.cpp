@@ -0,0 +1,80 @@
+#include "cbor.h"
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+void CborWriter::add_int(int64_t value) {
+  if (value >= 0) {
+    this->write_head(MAJOR_UNSIGNED, value);
+  } else {
+    // Negative integers are encoded as -1 - n
+    this->write_head(MAJOR_NEGATIVE, static_cast<uint64_t>(-1 - value));
+  }
+}
+
+void CborWriter::add_text(const char *text, size_t length) {
+  this->write_head(MAJOR_TEXT, length);
+  this->write(reinterpret_cast<const uint8_t *>(text), length);
+}
+
+void CborWriter::add_bytes(const uint8_t *data, size_t length) {
+  this->write_head(MAJOR_BYTES, length);
+  this->write(data, length);
+}
+
+void CborWriter::flush() {
+  if (this->used_ == 0)
+    return;
+  this->flush_fn_(this->context_, this->buffer_, this->used_);
+  this->used_ = 0;
+}
+
+void CborWriter::write_head(uint8_t major, uint64_t value) {
+  uint8_t head[9];
+  size_t size;
+  if (value < 24) {
+    head[0] = (major << 5) | value;
+    size = 1;
+  } else if (value <= 0xFF) {
+    head[0] = (major << 5) | 24;
+    size = 2;
+  } else if (value <= 0xFFFF) {
+    head[0] = (major << 5) | 25;
+    size = 3;
+  } else if (value <= 0xFFFFFFFF) {
+    head[0] = (major << 5) | 26;
+    size = 5;
+  } else {
+    head[0] = (major << 5) | 27;
+    size = 9;
+  }
+  // Argument follows big-endian in the remaining bytes
+  for (size_t i = size - 1; i > 0; i--) {
+    head[i] = value & 0xFF;
+    value >>= 8;
+  }
+  this->write(head, size);
+}
+
+void CborWriter::write_byte(uint8_t byte) {
+  if (this->used_ == sizeof(this->buffer_))
+    this->flush();
+  this->buffer_[this->used_++] = byte;
+}
+
+void CborWriter::write(const uint8_t *data, size_t length) {
+  while (length > 0) {
+    if (this->used_ == sizeof(this->buffer_))
+      this->flush();
+    size_t chunk = sizeof(this->buffer_) - this->used_;
+    if (chunk > length)
+      chunk = length;
+    memcpy(this->buffer_ + this->used_, data, chunk);
+    this->used_ += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+}
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// Minimal streaming CBOR (RFC 8949) encoder. Items are written into a small fixed
+// buffer that is handed to `flush` whenever it fills up, so a response of any size is
+// produced without building it in memory first. Maps and arrays are definite-length:
+// pass the number of pairs/items up front.
+class CborWriter {
+ public:
+  typedef void (*FlushFn)(void *context, const uint8_t *data, size_t length);
+
+  CborWriter(FlushFn flush, void *context) : flush_fn_(flush), context_(context) {}
+
+  void begin_map(size_t pairs) { this->write_head(MAJOR_MAP, pairs); }
+  void begin_array(size_t items) { this->write_head(MAJOR_ARRAY, items); }
+  void add_uint(uint64_t value) { this->write_head(MAJOR_UNSIGNED, value); }
+  void add_int(int64_t value);
+  void add_bool(bool value) { this->write_byte(value ? SIMPLE_TRUE : SIMPLE_FALSE); }
+  void add_null() { this->write_byte(SIMPLE_NULL); }
+  void add_text(const char *text) { this->add_text(text, strlen(text)); }
+  void add_text(const char *text, size_t length);
+  void add_bytes(const uint8_t *data, size_t length);
+
+  // Hands whatever is buffered to the flush function
+  void flush();
+
+ protected:
+  static const uint8_t MAJOR_UNSIGNED = 0;
+  static const uint8_t MAJOR_NEGATIVE = 1;
+  static const uint8_t MAJOR_BYTES = 2;
+  static const uint8_t MAJOR_TEXT = 3;
+  static const uint8_t MAJOR_ARRAY = 4;
+  static const uint8_t MAJOR_MAP = 5;
+  static const uint8_t SIMPLE_FALSE = 0xF4;
+  static const uint8_t SIMPLE_TRUE = 0xF5;
+  static const uint8_t SIMPLE_NULL = 0xF6;
+
+  void write_head(uint8_t major, uint64_t value);
+  void write_byte(uint8_t byte);
+  void write(const uint8_t *data, size_t length);
+
+  FlushFn flush_fn_;
+  void *context_;
+  uint8_t buffer_[256];
+  size_t used_{0};
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
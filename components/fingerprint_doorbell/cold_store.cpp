@@ -0,0 +1,155 @@
+#include "cold_store.h"
+#include "esphome/core/application.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include <algorithm>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+static const char *const TAG = "fingerprint_doorbell.cold";
+
+struct RecordHeader {
+  uint32_t magic;
+  uint16_t id;
+  uint16_t length;
+  uint16_t crc;
+  uint16_t reserved;
+};
+static_assert(sizeof(RecordHeader) == ColdStore::HEADER_SIZE, "record header layout");
+
+bool ColdStore::init(const char *label, uint16_t first_id, uint16_t last_id) {
+  this->partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  if (this->partition_ == nullptr) {
+    ESP_LOGE(TAG, "No data partition '%s' in the partition table", label);
+    return false;
+  }
+  this->first_id_ = first_id;
+  this->last_id_ = last_id;
+  size_t sectors = std::min<size_t>(this->partition_->size / SECTOR_SIZE, UINT16_MAX - 1);
+  this->sector_used_.assign(sectors, false);
+  this->sector_of_.assign(last_id + 1, 0);
+  this->count_ = 0;
+
+  uint16_t stranded = 0;
+  uint16_t unusable = 0;
+  for (size_t i = 0; i < sectors; i++) {
+    RecordHeader header;
+    if (esp_partition_read(this->partition_, i * SECTOR_SIZE, &header, sizeof(header)) != ESP_OK ||
+        header.magic != MAGIC || header.length > MAX_TEMPLATE_SIZE)
+      continue;
+    // A valid record keeps its sector even when it cannot be used, so nothing is overwritten
+    this->sector_used_[i] = true;
+    if (header.id == 0 || header.id > last_id || this->stored(header.id)) {
+      unusable++;
+      continue;
+    }
+    this->sector_of_[header.id] = i + 1;
+    if (header.id >= first_id) {
+      this->count_++;
+    } else {
+      stranded++;
+    }
+  }
+  ESP_LOGI(TAG, "Cold storage '%s': %u of %u templates stored", label, this->count_, (unsigned) sectors);
+  if (sectors < static_cast<size_t>(last_id - first_id + 1)) {
+    ESP_LOGW(TAG, "Partition '%s' has room for %u templates, fewer than the %u cold IDs", label,
+             (unsigned) sectors, (unsigned) (last_id - first_id + 1));
+  }
+  if (stranded > 0)
+    ESP_LOGW(TAG, "%u templates below ID %u are left from a smaller hot_slots", stranded, first_id);
+  if (unusable > 0)
+    ESP_LOGW(TAG, "%u records above max_fingerprints or duplicated, left untouched", unusable);
+  return true;
+}
+
+bool ColdStore::load(uint16_t id, uint8_t *data, uint16_t &length) {
+  if (!this->stored(id))
+    return false;
+  RecordHeader header;
+  size_t offset = this->offset(id);
+  if (esp_partition_read(this->partition_, offset, &header, sizeof(header)) != ESP_OK ||
+      header.magic != MAGIC || header.id != id || header.length > MAX_TEMPLATE_SIZE ||
+      esp_partition_read(this->partition_, offset + HEADER_SIZE, data, header.length) != ESP_OK)
+    return false;
+  if (crc16(data, header.length) != header.crc) {
+    ESP_LOGW(TAG, "Template %u is corrupted (CRC mismatch)", id);
+    return false;
+  }
+  length = header.length;
+  return true;
+}
+
+bool ColdStore::store(uint16_t id, const uint8_t *data, uint16_t length) {
+  if (!this->fits(id) || length > MAX_TEMPLATE_SIZE)
+    return false;
+  // An ID keeps its sector; a new one takes the first free sector
+  bool existing = this->stored(id);
+  size_t sector = existing ? this->sector_of_[id] - 1 : this->sector_used_.size();
+  for (size_t i = 0; !existing && i < this->sector_used_.size(); i++) {
+    if (!this->sector_used_[i]) {
+      sector = i;
+      break;
+    }
+  }
+  if (sector >= this->sector_used_.size()) {
+    ESP_LOGW(TAG, "Cold storage is full, template %u not stored", id);
+    return false;
+  }
+
+  size_t offset = sector * SECTOR_SIZE;
+  RecordHeader header{MAGIC, id, length, crc16(data, length), 0};
+  // Data first, header last: a write cut short by a reset leaves no valid record behind
+  if (esp_partition_erase_range(this->partition_, offset, SECTOR_SIZE) != ESP_OK ||
+      esp_partition_write(this->partition_, offset + HEADER_SIZE, data, length) != ESP_OK ||
+      esp_partition_write(this->partition_, offset, &header, sizeof(header)) != ESP_OK) {
+    ESP_LOGW(TAG, "Writing template %u failed", id);
+    if (existing) {
+      this->sector_of_[id] = 0;
+      this->sector_used_[sector] = false;
+      this->count_--;
+    }
+    return false;
+  }
+  if (!existing) {
+    this->sector_of_[id] = sector + 1;
+    this->sector_used_[sector] = true;
+    this->count_++;
+  }
+  return true;
+}
+
+bool ColdStore::erase(uint16_t id) {
+  if (!this->stored(id))
+    return true;
+  size_t sector = this->sector_of_[id] - 1;
+  if (esp_partition_erase_range(this->partition_, sector * SECTOR_SIZE, SECTOR_SIZE) != ESP_OK)
+    return false;
+  this->sector_of_[id] = 0;
+  this->sector_used_[sector] = false;
+  if (id >= this->first_id_)
+    this->count_--;
+  return true;
+}
+
+void ColdStore::erase_all() {
+  // Only the sectors in use, including unusable records; erasing the whole partition
+  // would take seconds. Each sector erase takes tens of ms, so the watchdog is fed.
+  for (size_t i = 0; i < this->sector_used_.size(); i++) {
+    if (!this->sector_used_[i])
+      continue;
+    App.feed_wdt();
+    if (esp_partition_erase_range(this->partition_, i * SECTOR_SIZE, SECTOR_SIZE) == ESP_OK)
+      this->sector_used_[i] = false;
+  }
+  for (uint16_t id = 0; id < this->sector_of_.size(); id++) {
+    if (this->stored(id) && !this->sector_used_[this->sector_of_[id] - 1]) {
+      this->sector_of_[id] = 0;
+      if (id >= this->first_id_)
+        this->count_--;
+    }
+  }
+}
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <esp_partition.h>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// Cold tier of tiered template storage: templates that do not fit the sensor's library,
+// kept in a flash data partition. Each template fills one 4 KB sector, so a write
+// erases nothing but its own sector:
+//
+//   magic(4) | id(2) | length(2) | crc16(2) | reserved(2) | template bytes
+//
+// A record is found by the ID in its header, not by its position, so the layout does
+// not depend on hot_slots. Records for IDs below first_id (hot_slots was raised) stay
+// readable until they are moved to the sensor. Only the sector of each stored ID is
+// held in RAM; templates are read when needed.
+class ColdStore {
+ public:
+  static const uint32_t SECTOR_SIZE = 4096;
+  static const uint32_t HEADER_SIZE = 12;
+  static const uint32_t MAGIC = 0x54504643;  // "CFPT"
+  static const uint16_t MAX_TEMPLATE_SIZE = 1536;
+
+  // Finds the partition and reads every record header; false if there is no such partition
+  bool init(const char *label, uint16_t first_id, uint16_t last_id);
+  bool enabled() const { return this->partition_ != nullptr; }
+
+  // Cold IDs are first_id..last_id; any of them fits while the partition has a free sector
+  uint16_t first_id() const { return this->first_id_; }
+  uint16_t last_id() const { return this->last_id_; }
+  bool fits(uint16_t id) const { return id >= this->first_id_ && id <= this->last_id_; }
+  bool has(uint16_t id) const { return this->fits(id) && this->stored(id); }
+  // Cold IDs stored, and how many templates the partition holds
+  uint16_t size() const { return this->count_; }
+  uint16_t capacity() const { return this->sector_used_.size(); }
+
+  // `data` must hold MAX_TEMPLATE_SIZE bytes. False if missing or corrupted. Also reads
+  // and erases records below first_id.
+  bool load(uint16_t id, uint8_t *data, uint16_t &length);
+  bool store(uint16_t id, const uint8_t *data, uint16_t length);
+  bool erase(uint16_t id);
+  void erase_all();
+
+  // Calls f(id) for every stored cold ID in ascending order
+  template<typename F> void for_each(F f) const {
+    for (uint16_t id = this->first_id_; id <= this->last_id_ && id < this->sector_of_.size(); id++) {
+      if (this->stored(id))
+        f(id);
+    }
+  }
+  // Calls f(id) for every record below first_id, written before hot_slots was raised
+  template<typename F> void for_each_stranded(F f) const {
+    for (uint16_t id = 1; id < this->first_id_ && id < this->sector_of_.size(); id++) {
+      if (this->stored(id))
+        f(id);
+    }
+  }
+
+ protected:
+  bool stored(uint16_t id) const { return id < this->sector_of_.size() && this->sector_of_[id] != 0; }
+  size_t offset(uint16_t id) const { return static_cast<size_t>(this->sector_of_[id] - 1) * SECTOR_SIZE; }
+
+  const esp_partition_t *partition_{nullptr};
+  uint16_t first_id_{0};
+  uint16_t last_id_{0};
+  std::vector<uint16_t> sector_of_;  // Per ID up to last_id: sector + 1, 0 = not stored
+  std::vector<bool> sector_used_;
+  uint16_t count_{0};
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// R503 packet: EF01 | addr(4) | type | len(2) | data | checksum(2)
+static const size_t FRAME_OVERHEAD = 11;
+
+// A complete command packet with N data bytes, ready to go out in a single write
+template<size_t N> using CommandFrame = std::array<uint8_t, N + FRAME_OVERHEAD>;
+
+// Writes a complete packet for the default address 0xFFFFFFFF into `out`
+// (length + FRAME_OVERHEAD bytes). constexpr so fixed frames cost nothing at runtime.
+constexpr size_t build_frame(uint8_t type, const uint8_t *data, size_t length, uint8_t *out) {
+  uint16_t packet_length = length + 2;  // data + checksum
+  out[0] = 0xEF;
+  out[1] = 0x01;
+  out[2] = 0xFF;
+  out[3] = 0xFF;
+  out[4] = 0xFF;
+  out[5] = 0xFF;
+  out[6] = type;
+  out[7] = packet_length >> 8;
+  out[8] = packet_length & 0xFF;
+  uint16_t sum = type + out[7] + out[8];
+  for (size_t i = 0; i < length; i++) {
+    out[9 + i] = data[i];
+    sum += data[i];
+  }
+  out[9 + length] = sum >> 8;
+  out[10 + length] = sum & 0xFF;
+  return length + FRAME_OVERHEAD;
+}
+
+template<size_t N> constexpr CommandFrame<N> make_command_frame(const std::array<uint8_t, N> &data) {
+  CommandFrame<N> frame{};
+  build_frame(0x01, data.data(), N, frame.data());  // 0x01 = command packet
+  return frame;
+}
+
+// AuraLedConfig (0x35) frame: mode, speed, color, cycle count (0 = endless)
+constexpr CommandFrame<5> make_led_frame(uint8_t mode, uint8_t speed, uint8_t color) {
+  return make_command_frame<5>({0x35, mode, speed, color, 0});
+}
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
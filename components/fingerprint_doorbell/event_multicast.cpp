@@ -0,0 +1,115 @@
+#include "event_multicast.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include <cstring>
+#include <sys/time.h>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+static const char *const TAG = "fingerprint_doorbell.multicast";
+
+// Without event_multicast_key, HMAC-SHA256(api_token, KEY_LABEL) is the datagram key.
+// Receivers get that key (event_listener.py --key), never the token itself.
+static const char KEY_LABEL[] = "fingerprint_doorbell multicast v1";
+static const uint8_t MULTICAST_TTL = 1;  // Stays on the local network
+// Before this, the clock has not been set yet (2020-09-13)
+static const time_t MIN_VALID_EPOCH = 1600000000;
+
+static void put_u16(uint8_t *out, uint16_t value) {
+  out[0] = value >> 8;
+  out[1] = value;
+}
+
+static void put_u32(uint8_t *out, uint32_t value) {
+  put_u16(out, value >> 16);
+  put_u16(out + 2, value);
+}
+
+bool EventMulticast::init(const std::string &api_token, const std::vector<uint8_t> &key, const std::string &address,
+                          uint16_t port, uint16_t source) {
+  this->destination_.sin_family = AF_INET;
+  this->destination_.sin_port = htons(port);
+  if (inet_aton(address.c_str(), &this->destination_.sin_addr) == 0) {
+    ESP_LOGE(TAG, "Invalid multicast address '%s'", address.c_str());
+    return false;
+  }
+
+  const mbedtls_md_info_t *sha256 = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+  uint8_t derived[KEY_SIZE];
+  bool keyed = key.size() == KEY_SIZE;
+  mbedtls_md_init(&this->hmac_);
+  if ((!keyed && mbedtls_md_hmac(sha256, reinterpret_cast<const uint8_t *>(api_token.data()), api_token.size(),
+                                 reinterpret_cast<const uint8_t *>(KEY_LABEL), sizeof(KEY_LABEL) - 1, derived) != 0) ||
+      mbedtls_md_setup(&this->hmac_, sha256, 1) != 0 ||
+      mbedtls_md_hmac_starts(&this->hmac_, keyed ? key.data() : derived, KEY_SIZE) != 0) {
+    ESP_LOGE(TAG, "Could not set up the datagram key");
+    mbedtls_md_free(&this->hmac_);
+    return false;
+  }
+
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock < 0) {
+    ESP_LOGE(TAG, "Could not open a UDP socket: errno %d", errno);
+    mbedtls_md_free(&this->hmac_);
+    return false;
+  }
+  uint8_t ttl = MULTICAST_TTL;
+  setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+
+  this->socket_ = sock;
+  this->address_ = address;
+  this->port_ = port;
+  this->source_ = source;
+  this->boot_ = random_uint32();
+  return true;
+}
+
+void EventMulticast::send(uint8_t type, uint16_t id, uint16_t confidence, uint16_t scan_ms) {
+  if (this->socket_ < 0)
+    return;
+  uint32_t start = micros();
+
+  uint64_t epoch_us = 0;
+  struct timeval now;
+  if (gettimeofday(&now, nullptr) == 0 && now.tv_sec >= MIN_VALID_EPOCH)
+    epoch_us = (uint64_t) now.tv_sec * 1000000 + now.tv_usec;
+
+  uint8_t datagram[DATAGRAM_SIZE];
+  datagram[0] = 'F';
+  datagram[1] = 'D';
+  datagram[2] = VERSION;
+  datagram[3] = type;
+  put_u16(datagram + 4, this->source_);
+  put_u32(datagram + 6, this->boot_);
+  put_u32(datagram + 10, ++this->seq_);
+  put_u32(datagram + 14, epoch_us >> 32);
+  put_u32(datagram + 18, epoch_us);
+  put_u16(datagram + 22, id);
+  put_u16(datagram + 24, confidence);
+  put_u16(datagram + 26, scan_ms);
+
+  uint8_t tag[32];
+  if (mbedtls_md_hmac_reset(&this->hmac_) != 0 || mbedtls_md_hmac_update(&this->hmac_, datagram, BODY_SIZE) != 0 ||
+      mbedtls_md_hmac_finish(&this->hmac_, tag) != 0) {
+    this->errors_++;
+    return;
+  }
+  memcpy(datagram + BODY_SIZE, tag, TAG_SIZE);
+
+  if (sendto(this->socket_, datagram, sizeof(datagram), MSG_DONTWAIT,
+             reinterpret_cast<const struct sockaddr *>(&this->destination_), sizeof(this->destination_)) < 0) {
+    // No IP yet or the stack is out of buffers; the HA entities still carry the event
+    this->errors_++;
+    ESP_LOGD(TAG, "Event datagram not sent: errno %d", errno);
+  } else {
+    this->sent_++;
+  }
+  uint32_t elapsed = micros() - start;
+  if (elapsed > this->max_send_us_)
+    this->max_send_us_ = elapsed;
+}
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
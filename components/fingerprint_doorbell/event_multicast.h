@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <lwip/sockets.h>
+#include <mbedtls/md.h>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// Ring and match events as one UDP multicast datagram each, for receivers on the LAN
+// that must not wait for Home Assistant (chimes, door displays). All fields are big
+// endian:
+//
+//   magic "FD"(2) | version(1) | type(1) | source(2) | boot(4) | seq(4) | epoch_us(8) |
+//   id(2) | confidence(2) | scan_ms(2) | tag(16)
+//
+// source tells several doorbells on one ESP32 apart (low 16 bits of the FNV-1 hash of
+// rest_prefix). boot is random per start and seq counts up from 1, so a receiver can
+// drop duplicates and replays. epoch_us is the sender's clock (0 until it is set),
+// scan_ms the time from the start of the scan to the send. tag is HMAC-SHA256 over all
+// bytes before it, truncated to 16 bytes. The 32-byte key is event_multicast_key, or
+// else derived from api_token (`tools/event_listener.py --print-key` shows it).
+class EventMulticast {
+ public:
+  static const uint8_t VERSION = 1;
+  static const uint8_t TYPE_RING = 1;
+  static const uint8_t TYPE_MATCH = 2;
+  static const size_t BODY_SIZE = 28;
+  static const size_t TAG_SIZE = 16;
+  static const size_t DATAGRAM_SIZE = BODY_SIZE + TAG_SIZE;
+  static const size_t KEY_SIZE = 32;
+
+  // Opens the socket and sets up the key: `key` if it holds KEY_SIZE bytes, else one
+  // derived from `api_token`. False (with a log) if either fails.
+  bool init(const std::string &api_token, const std::vector<uint8_t> &key, const std::string &address, uint16_t port,
+            uint16_t source);
+  bool enabled() const { return this->socket_ >= 0; }
+
+  // Never blocks: a datagram the network stack cannot take right now is counted and dropped
+  void send(uint8_t type, uint16_t id, uint16_t confidence, uint16_t scan_ms);
+
+  uint32_t sent() const { return this->sent_; }
+  uint32_t errors() const { return this->errors_; }
+  uint32_t max_send_us() const { return this->max_send_us_; }
+  const std::string &address() const { return this->address_; }
+  uint16_t port() const { return this->port_; }
+
+ protected:
+  int socket_{-1};
+  struct sockaddr_in destination_ {};
+  std::string address_;
+  uint16_t port_{0};
+  uint16_t source_{0};
+  uint32_t boot_{0};
+  uint32_t seq_{0};
+  mbedtls_md_context_t hmac_;
+  uint32_t sent_{0};
+  uint32_t errors_{0};
+  uint32_t max_send_us_{0};
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
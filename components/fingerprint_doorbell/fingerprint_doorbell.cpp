@@ -3,17 +3,85 @@
 #include "esphome/core/preferences.h"
 #include "esphome/core/helpers.h"
 #include "esphome/core/application.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
 
 namespace esphome {
 namespace fingerprint_doorbell {
 
 static const char *const TAG = "fingerprint_doorbell";
 
-// Use Serial2 exactly like the original working code
-#define mySerial Serial2
+// Link health / reconnect timing
+static const uint8_t LINK_ERROR_THRESHOLD = 3;
+static const uint32_t HEARTBEAT_INTERVAL_MS = 500;
+static const uint32_t HEARTBEAT_RETRY_MS = 100;
+static const uint16_t HEARTBEAT_TIMEOUT_MS = 100;
+static const uint32_t PROBE_TIMEOUT_MS = 200;
+static const uint32_t RECONNECT_BACKOFF_MIN_MS = 50;
+static const uint32_t RECONNECT_BACKOFF_MAX_MS = 1000;
+// GetImage is answered within the sensor's image acquisition time (under 200 ms)
+static const uint16_t GET_IMAGE_TIMEOUT_MS = 500;
+
+// Finger presence follows every scan; publish it at most this often
+static const uint32_t FINGER_PUBLISH_INTERVAL_MS = 250;
+
+// Names are user text; quote them for the string-built JSON replies
+static std::string json_escape(const std::string &text) {
+  std::string out;
+  out.reserve(text.size() + 2);
+  for (char c : text) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if ((uint8_t) c < 0x20) {
+          char escaped[7];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned) c);
+          out += escaped;
+        } else {
+          out += c;
+        }
+    }
+  }
+  return out;
+}
+
+// Fixed command packets for the scan path, built and checksummed at compile time
+static constexpr auto GET_IMAGE_FRAME = make_command_frame<1>({FINGERPRINT_GETIMAGE});
+static constexpr std::array<CommandFrame<2>, 6> IMAGE2TZ_FRAMES = {
+    make_command_frame<2>({FINGERPRINT_IMAGE2TZ, 1}), make_command_frame<2>({FINGERPRINT_IMAGE2TZ, 2}),
+    make_command_frame<2>({FINGERPRINT_IMAGE2TZ, 3}), make_command_frame<2>({FINGERPRINT_IMAGE2TZ, 4}),
+    make_command_frame<2>({FINGERPRINT_IMAGE2TZ, 5}), make_command_frame<2>({FINGERPRINT_IMAGE2TZ, 6}),
+};
+static_assert(GET_IMAGE_FRAME[10] == 0x00 && GET_IMAGE_FRAME[11] == 0x05, "GetImage checksum");
 
 void FingerprintDoorbell::setup() {
   ESP_LOGCONFIG(TAG, "Setting up Fingerprint Doorbell...");
+  // Runs on the loop task, so loop() events land on the trace's main thread
+  this->trace_.init(this->trace_buffer_size_);
+  if (this->trace_.enabled())
+    this->link_.set_trace(&this->trace_);
+#ifdef USE_FINGERPRINT_DOORBELL_CAPTURE
+  this->capture_.init(this->capture_buffer_size_);
+  if (this->capture_.enabled())
+    this->link_.set_capture(&this->capture_);
+#endif
 
   // Setup pins
   if (this->touch_pin_ != nullptr) {
@@ -27,40 +95,100 @@ void FingerprintDoorbell::setup() {
     this->doorbell_pin_->digital_write(false);
   }
 
-  // Initialize serial pointer (finger_ object created in connect_sensor with correct password)
-  this->hw_serial_ = &mySerial;
-  
-  ESP_LOGI(TAG, "Using Serial2 with default pins (RX=GPIO16, TX=GPIO17)");
+  if (this->unlock_pin_ != nullptr) {
+    this->unlock_pin_->setup();
+    this->unlock_pin_->pin_mode(gpio::FLAG_OUTPUT);
+    this->unlock_pin_->digital_write(false);
+    this->load_access_overrides();
+  }
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  this->setup_tiers();
+#endif
+#ifdef USE_FINGERPRINT_DOORBELL_MULTICAST
+  // source tells instances apart the same way their REST paths do
+  if (!this->multicast_address_.empty()) {
+    this->multicast_.init(this->api_token_, this->multicast_key_, this->multicast_address_, this->multicast_port_,
+                          fnv1_hash(this->rest_prefix_) & 0xFFFF);
+  }
+#endif
+
+  // All sensor traffic goes through the link on our UART (finger_ is created in init_link
+  // with the correct password)
+  this->link_.set_uart(this->parent_);
   this->sensor_connected_ = false;
   this->mode_ = Mode::SCAN;
   
+  // LED configs are final now; build their AuraLedConfig frames once
+  for (LedConfig *led : {&this->led_ready_, &this->led_error_, &this->led_enroll_, &this->led_match_,
+                         &this->led_scanning_, &this->led_no_match_}) {
+    led->frame = make_led_frame(led->mode, led->speed, led->color);
+  }
+  this->led_ready_solid_frame_ = make_led_frame(FINGERPRINT_LED_ON, 0, this->led_ready_.color);
+  
+  this->last_action_text_.reserve(64);
+  this->match_id_out_.init(this->match_id_sensor_);
+  this->confidence_out_.init(this->confidence_sensor_);
+  this->match_name_out_.init(this->match_name_sensor_);
+  this->match_name_out_.reserve(NAME_BUFFER_SIZE);
+  this->ring_out_.init(this->ring_sensor_);
+  this->finger_out_.init(this->finger_sensor_, FINGER_PUBLISH_INTERVAL_MS);
+  this->unlock_out_.init(this->unlock_sensor_);
+  
+#ifdef USE_FINGERPRINT_DOORBELL_REST
   // Setup REST API
-  this->setup_web_server();
+  if (this->rest_api_)
+    this->setup_web_server();
+#endif
 }
 
 void FingerprintDoorbell::loop() {
-  // Connect sensor if not connected (throttled to every 5 seconds)
+  TraceScope trace(&this->trace_, "loop");
+  this->process_loop();
+  this->flush_publications();
+  // The match LED and entities are out; only now spend sensor time on the template.
+  // Nothing has captured since, so the sensor's image buffer still holds the match.
+  if (this->refresh_id_ != 0) {
+    this->refresh_template(this->refresh_id_);
+    this->refresh_id_ = 0;
+  }
+}
+
+void FingerprintDoorbell::process_loop() {
+  this->process_event_resets();
+  this->update_access_clock();
+
+  // (Re)connect sensor if the link is down - never blocks, see process_reconnect()
   if (!this->sensor_connected_) {
-    uint32_t now = millis();
-    if (now - this->last_connect_attempt_ >= 5000) {
-      this->last_connect_attempt_ = now;
-      this->sensor_connected_ = this->connect_sensor();
-      if (this->sensor_connected_) {
-        ESP_LOGI(TAG, "Fingerprint sensor connected successfully");
-        this->load_fingerprint_names();
-        this->set_led_ring_ready();
-        this->publish_last_action("Sensor connected");
-      }
-    }
+    this->process_reconnect();
     return;
   }
 
   // Handle different modes
   if (this->mode_ == Mode::ENROLL) {
+#ifdef USE_FINGERPRINT_DOORBELL_REST
+    // Other jobs wait for the enrollment to end, but a cancel must get through
+    if (this->process_jobs(true))
+      return;
+#endif
     this->process_enrollment();
     return;
   }
 
+  // A command went unanswered: confirm with quick handshakes before anything slow, so
+  // a dead sensor is marked down about 0.7 s after its first miss
+  if (this->consecutive_errors_ > 0) {
+    this->send_heartbeat();
+    return;
+  }
+
+#ifdef USE_FINGERPRINT_DOORBELL_REST
+  // Queued REST work gets the sensor before the next scan. Jobs only run here, between
+  // scans: a scan's capture, search and match publication (with its template refresh)
+  // all happen in one pass below, so no job can touch the char buffers in between.
+  if (this->process_jobs())
+    return;
+#endif
+
   // Cooldown after no-match to keep LED visible
   if (this->last_ring_time_ > 0 && millis() - this->last_ring_time_ < 1000) {
     return;
@@ -79,76 +207,182 @@ void FingerprintDoorbell::loop() {
     this->set_led_ring_ready();
   }
 
+  // A claimed identity is waiting: the next touch is matched 1:1 instead of searched
+  if (this->last_verify_.state == VerifyState::ARMED) {
+    this->process_armed_verify();
+    return;
+  }
+
   // Normal scan mode
   Match match = this->scan_fingerprint();
 
   // Handle match found
   if (match.scan_result == ScanResult::MATCH_FOUND) {
-    ESP_LOGI(TAG, "Match: ID=%d, Name=%s, Confidence=%d", 
-             match.match_id, match.match_name.c_str(), match.match_confidence);
-    
-    // Set match LED here (after scan completes) to ensure it's visible
-    this->set_led_ring_match();
-    
-    if (this->match_id_sensor_ != nullptr)
-      this->match_id_sensor_->publish_state(match.match_id);
-    if (this->confidence_sensor_ != nullptr)
-      this->confidence_sensor_->publish_state(match.match_confidence);
-    if (this->match_name_sensor_ != nullptr)
-      this->match_name_sensor_->publish_state(match.match_name);
-    
-    this->publish_last_action("Match: " + match.match_name);
-    this->last_match_time_ = millis();
-    this->last_match_id_ = match.match_id;
-    
-    // Clear after 3 seconds
-    this->set_timeout(3000, [this]() {
-      if (this->match_id_sensor_ != nullptr)
-        this->match_id_sensor_->publish_state(-1);
-      if (this->match_name_sensor_ != nullptr)
-        this->match_name_sensor_->publish_state("");
-      if (this->confidence_sensor_ != nullptr)
-        this->confidence_sensor_->publish_state(0);
-    });
+    this->publish_match(match, "Match", this->should_refresh_template(match));
   }
   // Handle no match (doorbell ring)
   else if (match.scan_result == ScanResult::NO_MATCH_FOUND) {
+#ifdef USE_FINGERPRINT_DOORBELL_MULTICAST
+    // Chimes listening on the LAN hear it before anything else happens
+    this->multicast_.send(EventMulticast::TYPE_RING, 0, 0, this->scan_elapsed_ms());
+#endif
     ESP_LOGI(TAG, "No match - doorbell ring!");
     
     // Show no match LED
     this->set_led_ring_no_match();
     
-    if (this->ring_sensor_ != nullptr)
-      this->ring_sensor_->publish_state(true);
+    this->ring_out_.set(true, this->publish_stats_);
     if (this->doorbell_pin_ != nullptr)
       this->doorbell_pin_->digital_write(true);
     
-    this->publish_last_action("Doorbell ring");
+    this->publish_last_actionf("Doorbell ring");
     this->last_ring_time_ = millis();
     
     // Clear doorbell output after 1 second
-    this->set_timeout(1000, [this]() {
-      if (this->ring_sensor_ != nullptr)
-        this->ring_sensor_->publish_state(false);
-      if (this->doorbell_pin_ != nullptr)
-        this->doorbell_pin_->digital_write(false);
-      // LED ready state is handled by cooldown logic in loop()
-    });
+    this->ring_clear_time_ = millis() + 1000;
   }
 
   // Update finger detection sensor
-  if (this->finger_sensor_ != nullptr) {
-    bool finger_present = (match.scan_result != ScanResult::NO_FINGER);
-    this->finger_sensor_->publish_state(finger_present);
+  this->finger_out_.set(match.scan_result != ScanResult::NO_FINGER, this->publish_stats_);
+
+  // Nothing talked to the sensor for a while (touch ring idle) - check it is still there
+  uint32_t heartbeat_interval = this->consecutive_errors_ > 0 ? HEARTBEAT_RETRY_MS : HEARTBEAT_INTERVAL_MS;
+  if (this->sensor_connected_ && this->mode_ == Mode::SCAN &&
+      millis() - this->last_link_activity_ >= heartbeat_interval) {
+    this->send_heartbeat();
+  }
+}
+
+void FingerprintDoorbell::publish_match(const Match &match, const char *action, bool refresh) {
+  // Open the door before anything goes out over the network
+  bool unlocked = this->unlock_pin_ != nullptr && this->try_unlock(match.match_id);
+#ifdef USE_FINGERPRINT_DOORBELL_MULTICAST
+  this->multicast_.send(EventMulticast::TYPE_MATCH, match.match_id, match.match_confidence, this->scan_elapsed_ms());
+#endif
+  
+  // Merged at the end of this loop(), after the event has gone out
+  if (refresh)
+    this->refresh_id_ = match.match_id;
+  
+  ESP_LOGI(TAG, "%s: ID=%d, Name=%s, Confidence=%d", action,
+           match.match_id, match.match_name, match.match_confidence);
+  
+  // Set match LED here (after scan completes) to ensure it's visible
+  this->set_led_ring_match();
+  
+  this->match_id_out_.set(match.match_id, this->publish_stats_);
+  this->confidence_out_.set(match.match_confidence, this->publish_stats_);
+  this->match_name_out_.set(match.match_name, this->publish_stats_);
+  if (unlocked)
+    this->unlock_out_.set(true, this->publish_stats_);
+  
+  if (this->unlock_pin_ == nullptr) {
+    this->publish_last_actionf("%s: %s", action, match.match_name);
+  } else {
+    this->publish_last_actionf("%s: %s (%s)", action, match.match_name, unlocked ? "unlocked" : "no access now");
+  }
+  this->last_match_time_ = millis();
+  this->last_match_id_ = match.match_id;
+  
+  // Clear after 3 seconds
+  this->match_clear_time_ = millis() + 3000;
+}
+
+// Deadlines instead of set_timeout(): a scheduler item per event would be a heap
+// allocation on every match and ring
+void FingerprintDoorbell::process_event_resets() {
+  uint32_t now = millis();
+  
+  if (this->match_clear_time_ != 0 && (int32_t) (now - this->match_clear_time_) >= 0) {
+    this->match_clear_time_ = 0;
+    this->match_id_out_.set(-1, this->publish_stats_);
+    this->match_name_out_.set("", this->publish_stats_);
+    this->confidence_out_.set(0, this->publish_stats_);
+  }
+  
+  if (this->ring_clear_time_ != 0 && (int32_t) (now - this->ring_clear_time_) >= 0) {
+    this->ring_clear_time_ = 0;
+    this->ring_out_.set(false, this->publish_stats_);
+    if (this->doorbell_pin_ != nullptr)
+      this->doorbell_pin_->digital_write(false);
+    // LED ready state is handled by cooldown logic in loop()
+  }
+  
+  if (this->unlock_clear_time_ != 0 && (int32_t) (now - this->unlock_clear_time_) >= 0) {
+    this->unlock_clear_time_ = 0;
+    this->unlock_pin_->digital_write(false);
+    this->unlock_out_.set(false, this->publish_stats_);
   }
 }
 
+// One publish per changed entity per loop(). The match ID goes out last, so automations
+// triggered by it already see the new name and confidence.
+void FingerprintDoorbell::flush_publications() {
+  uint32_t now = millis();
+  this->match_name_out_.flush(now, this->publish_stats_);
+  this->confidence_out_.flush(now, this->publish_stats_);
+  this->unlock_out_.flush(now, this->publish_stats_);
+  this->ring_out_.flush(now, this->publish_stats_);
+  this->finger_out_.flush(now, this->publish_stats_);
+  this->match_id_out_.flush(now, this->publish_stats_);
+}
+
 void FingerprintDoorbell::dump_config() {
   ESP_LOGCONFIG(TAG, "Fingerprint Doorbell:");
   LOG_PIN("  Touch Pin: ", this->touch_pin_);
   LOG_PIN("  Doorbell Pin: ", this->doorbell_pin_);
+  if (this->unlock_pin_ != nullptr) {
+    LOG_PIN("  Unlock Pin: ", this->unlock_pin_);
+    ESP_LOGCONFIG(TAG, "  Unlock Duration: %u ms", (unsigned) this->unlock_duration_);
+    for (uint8_t i = 0; i < this->access_policy_.window_count(); i++) {
+      const AccessWindow &window = this->access_policy_.window(i);
+      ESP_LOGCONFIG(TAG, "  Access Window %d: days=0x%02X %02d:%02d-%02d:%02d", i, window.days, window.start / 60,
+                    window.start % 60, window.end / 60, window.end % 60);
+    }
+  }
+#ifdef USE_FINGERPRINT_DOORBELL_REST
+  if (this->rest_api_) {
+    ESP_LOGCONFIG(TAG, "  REST Prefix: %s", this->rest_prefix_.c_str());
+    ESP_LOGCONFIG(TAG, "  Template Transfer: %s", YESNO(this->template_transfer_));
+  } else {
+    ESP_LOGCONFIG(TAG, "  REST API: disabled");
+  }
+#else
+  ESP_LOGCONFIG(TAG, "  REST API: disabled");
+#endif
+  if (!this->preferences_namespace_.empty())
+    ESP_LOGCONFIG(TAG, "  Preferences Namespace: %s", this->preferences_namespace_.c_str());
   ESP_LOGCONFIG(TAG, "  Ignore Touch Ring: %s", YESNO(this->ignore_touch_ring_));
+  ESP_LOGCONFIG(TAG, "  Auto Enroll: %s", YESNO(this->auto_enroll_));
+  if (this->template_refresh_) {
+    ESP_LOGCONFIG(TAG, "  Template Refresh: confidence >= %d, every %u s per slot",
+                  this->template_refresh_min_confidence_, (unsigned) (this->template_refresh_interval_ / 1000));
+  }
+  if (this->enroll_verify_touches_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Enroll Verification: %d touches, min quality %d, %d retries",
+                  this->enroll_verify_touches_, this->enroll_min_quality_, this->enroll_retries_);
+  }
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  if (this->cold_.enabled()) {
+    ESP_LOGCONFIG(TAG, "  Tiered Storage: IDs 1-%u on the sensor, %u-%u in partition '%s' (%u stored)",
+                  this->hot_slots_, this->cold_.first_id(), this->cold_.last_id(), this->cold_partition_.c_str(),
+                  this->cold_.size());
+    ESP_LOGCONFIG(TAG, "  Promotion Cache: %u slots, fallback up to %u templates / %u ms per touch",
+                  this->cache_slots_, this->cold_search_max_, (unsigned) this->cold_search_budget_ms_);
+  } else if (!this->cold_partition_.empty()) {
+    ESP_LOGCONFIG(TAG, "  Tiered Storage: partition '%s' not found", this->cold_partition_.c_str());
+  }
+#endif
+#ifdef USE_FINGERPRINT_DOORBELL_MULTICAST
+  if (this->multicast_.enabled()) {
+    ESP_LOGCONFIG(TAG, "  Event Multicast: %s:%u, key %s", this->multicast_.address().c_str(), this->multicast_.port(),
+                  this->multicast_key_.empty() ? "derived from api_token" : "from event_multicast_key");
+  } else if (!this->multicast_address_.empty()) {
+    ESP_LOGCONFIG(TAG, "  Event Multicast: setup failed");
+  }
+#endif
   ESP_LOGCONFIG(TAG, "  Sensor Connected: %s", YESNO(this->sensor_connected_));
+  this->check_uart_settings(57600);
   
   // LED configuration debug
   ESP_LOGCONFIG(TAG, "  LED Ready: color=%d, mode=%d, speed=%d", this->led_ready_.color, this->led_ready_.mode, this->led_ready_.speed);
@@ -164,72 +398,241 @@ void FingerprintDoorbell::dump_config() {
   }
 }
 
-bool FingerprintDoorbell::connect_sensor() {
-  ESP_LOGI(TAG, "Connecting to fingerprint sensor (attempt %d)...", this->connect_attempts_ + 1);
+// ==================== LINK HEALTH ====================
+// The link is considered down after LINK_ERROR_THRESHOLD consecutive failed
+// exchanges. Reconnecting is a small state machine driven from loop(): send a
+// VerifyPassword probe, pick up the answer on a later iteration, and retry with a
+// jittered exponential backoff. Nothing in here waits for the sensor.
 
-  // Only initialize serial and load password on first attempt
-  if (this->connect_attempts_ == 0) {
-    // Load stored password from preferences
-    this->load_sensor_password();
-    
-    // Explicitly initialize Serial2 with pins for ESP-IDF framework
-    // RX=GPIO16, TX=GPIO17 are the default Serial2 pins on ESP32
-    mySerial.begin(57600, SERIAL_8N1, 16, 17);
-    delay(100);  // Give serial time to initialize
-    App.feed_wdt();
+// HandShake command (not in Arduino library), answered with an empty ack
+#define FINGERPRINT_HANDSHAKE 0x40
+static constexpr auto HANDSHAKE_FRAME = make_command_frame<1>({FINGERPRINT_HANDSHAKE});
+
+void FingerprintDoorbell::init_link() {
+  // Load stored password from preferences
+  this->load_sensor_password();
+  
+  // Create Adafruit_Fingerprint with the appropriate password. Its begin() is not
+  // called on purpose: the UART is already open and begin() sleeps for a second.
+  uint32_t password = this->sensor_paired_ ? this->sensor_password_ : 0x00000000;
+  this->finger_ = new Adafruit_Fingerprint(&this->link_, password);
+  
+  if (this->sensor_paired_) {
+    ESP_LOGI(TAG, "Using stored password for paired sensor");
+  } else {
+    ESP_LOGI(TAG, "Using default password (sensor unpaired)");
+  }
+}
+
+void FingerprintDoorbell::process_reconnect() {
+  if (this->finger_ == nullptr) {
+    this->init_link();
+  }
+  
+  uint32_t now = millis();
+  
+  if (!this->probe_pending_) {
+    if ((int32_t) (now - this->next_connect_attempt_) < 0)
+      return;
     
-    // Create Adafruit_Fingerprint with the appropriate password
+    // Send VerifyPassword and pick up the answer on a later loop() iteration
+    this->link_.drain();
     uint32_t password = this->sensor_paired_ ? this->sensor_password_ : 0x00000000;
-    if (this->finger_ != nullptr) {
-      delete this->finger_;
-    }
-    this->finger_ = new Adafruit_Fingerprint(this->hw_serial_, password);
+    uint8_t cmd_data[] = {FINGERPRINT_VERIFYPASSWORD,
+                          (uint8_t)(password >> 24), (uint8_t)(password >> 16),
+                          (uint8_t)(password >> 8), (uint8_t)(password & 0xFF)};
+    uint8_t frame[sizeof(cmd_data) + FRAME_OVERHEAD];
+    this->link_.write(frame, build_frame(FINGERPRINT_COMMANDPACKET, cmd_data, sizeof(cmd_data), frame));
     
+    this->connect_attempts_++;
+    this->probe_pending_ = true;
+    this->probe_sent_time_ = now;
+    ESP_LOGV(TAG, "Connecting to fingerprint sensor (attempt %u)...", (unsigned) this->connect_attempts_);
+    return;
+  }
+  
+  // Ack to VerifyPassword: 9 header bytes + confirmation code + 2 checksum bytes
+  if (this->link_.available() < 12) {
+    if (now - this->probe_sent_time_ >= PROBE_TIMEOUT_MS) {
+      this->probe_pending_ = false;
+      this->schedule_reconnect();
+    }
+    return;
+  }
+  
+  this->probe_pending_ = false;
+  Adafruit_Fingerprint_Packet ack_packet(FINGERPRINT_ACKPACKET, 0, nullptr);
+  if (this->finger_->getStructuredPacket(&ack_packet, 20) != FINGERPRINT_OK ||
+      ack_packet.type != FINGERPRINT_ACKPACKET) {
+    this->schedule_reconnect();
+    return;
+  }
+  
+  if (ack_packet.data[0] != FINGERPRINT_OK) {
+    // The sensor answers, but not to our password
     if (this->sensor_paired_) {
-      ESP_LOGI(TAG, "Using stored password for paired sensor");
+      ESP_LOGW(TAG, "Password verification failed - sensor may have been swapped!");
     } else {
-      ESP_LOGI(TAG, "Using default password (sensor unpaired)");
+      ESP_LOGW(TAG, "Password verification failed: 0x%02X", ack_packet.data[0]);
     }
-    
-    // Now tell Adafruit library what baud rate we're using
-    this->finger_->begin(57600);
-    App.feed_wdt();
+    this->reconnect_backoff_ms_ = RECONNECT_BACKOFF_MAX_MS;
+    this->schedule_reconnect();
+    return;
   }
   
-  this->connect_attempts_++;
-  
-  // Try to verify password (non-blocking - just one attempt per call)
-  if (this->finger_->verifyPassword()) {
-    ESP_LOGI(TAG, "Found fingerprint sensor!");
-    
-    // Startup LED signal
-    this->finger_->LEDcontrol(FINGERPRINT_LED_FLASHING, 25, FINGERPRINT_LED_BLUE, 0);
+  this->on_link_up();
+}
 
-    // Read sensor parameters
-    ESP_LOGI(TAG, "Reading sensor parameters");
-    this->finger_->getParameters();
-    ESP_LOGI(TAG, "Status: 0x%02X, Capacity: %d, Security: %d", 
-             this->finger_->status_reg, this->finger_->capacity, this->finger_->security_level);
+void FingerprintDoorbell::schedule_reconnect() {
+  // "Equal jitter": wait between half and the full backoff, then double it
+  uint32_t backoff = this->reconnect_backoff_ms_;
+  uint32_t wait = backoff / 2 + random_uint32() % (backoff / 2 + 1);
+  this->next_connect_attempt_ = millis() + wait;
+  this->reconnect_backoff_ms_ = std::min(backoff * 2, RECONNECT_BACKOFF_MAX_MS);
+  
+  if (this->connect_attempts_ % 50 == 0) {
+    ESP_LOGW(TAG, "Did not find fingerprint sensor after %u attempts", (unsigned) this->connect_attempts_);
+  }
+}
 
-    this->finger_->getTemplateCount();
-    ESP_LOGI(TAG, "Sensor contains %d templates", this->finger_->templateCount);
-    
-    this->connect_attempts_ = 0;  // Reset for future reconnects
-    return true;
+void FingerprintDoorbell::on_link_up() {
+  bool reconnect = this->ever_connected_;
+  ESP_LOGI(TAG, "Found fingerprint sensor after %u attempt(s)!", (unsigned) this->connect_attempts_);
+  
+  this->sensor_connected_ = true;
+  this->ever_connected_ = true;
+  this->connect_attempts_ = 0;
+  this->consecutive_errors_ = 0;
+  this->reconnect_backoff_ms_ = RECONNECT_BACKOFF_MIN_MS;
+  this->last_link_activity_ = millis();
+  this->status_clear_warning();
+  
+  // Read sensor parameters
+  this->finger_->getParameters();
+  ESP_LOGI(TAG, "Status: 0x%02X, Capacity: %d, Security: %d", 
+           this->finger_->status_reg, this->finger_->capacity, this->finger_->security_level);
+  this->finger_->getTemplateCount();
+  ESP_LOGI(TAG, "Sensor contains %d templates", this->finger_->templateCount);
+  
+  // Search the whole library, starting at slot 0, with the fingerprint in char buffer 1
+  uint16_t capacity = this->finger_->capacity != 0 ? this->finger_->capacity : MAX_FINGERPRINT_ID + 1;
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  // Only hot IDs and the promotion cache; cold templates are matched by search_cold()
+  if (this->cold_.enabled()) {
+    this->check_tiers(capacity);
+    capacity = this->hot_slots_ + this->cache_slots_ + 1;
   }
+#endif
+  this->search_frame_ = make_command_frame<6>(
+      {FINGERPRINT_SEARCH, 0x01, 0x00, 0x00, (uint8_t)(capacity >> 8), (uint8_t)(capacity & 0xFF)});
   
-  // If we're paired but verification failed, it could be a different sensor
-  if (this->sensor_paired_) {
-    ESP_LOGW(TAG, "Password verification failed - sensor may have been swapped!");
+  // Names and qualities live in our flash; only load them once
+  if (!reconnect) {
+    this->load_fingerprint_names();
+    this->load_fingerprint_quality();
   }
   
-  // Allow up to 10 attempts (5 seconds interval * 10 = 50 seconds total)
-  if (this->connect_attempts_ >= 10) {
-    ESP_LOGE(TAG, "Did not find fingerprint sensor after %d attempts", this->connect_attempts_);
-    this->connect_attempts_ = 0;  // Reset for future retries
+  // A browned-out sensor comes back with its LED off - restore the current state
+  if (this->mode_ == Mode::ENROLL) {
+    this->set_led_ring_enroll();
+  } else {
+    this->set_led_ring_ready();
   }
+  this->last_touch_state_ = false;
+  this->publish_last_action(reconnect ? "Sensor reconnected" : "Sensor connected");
+}
+
+void FingerprintDoorbell::mark_link_down() {
+  if (!this->sensor_connected_)
+    return;
   
-  return false;
+  ESP_LOGW(TAG, "Fingerprint sensor stopped responding, reconnecting");
+  this->sensor_connected_ = false;
+  this->link_down_count_++;
+  this->consecutive_errors_ = 0;
+  this->probe_pending_ = false;
+  this->reconnect_backoff_ms_ = RECONNECT_BACKOFF_MIN_MS;
+  this->next_connect_attempt_ = millis();
+  this->status_set_warning();
+  this->publish_last_action("Sensor disconnected");
+  
+  // Whatever the sensor was doing for an enrollment is lost
+  if (this->mode_ == Mode::ENROLL && this->enroll_step_ != EnrollStep::IDLE) {
+    this->publish_enroll_status("Error: Sensor disconnected");
+    this->finish_enrollment("failed", true);
+  }
+}
+
+void FingerprintDoorbell::track_link(uint8_t result) {
+  // The Arduino library reports timeouts and garbled packets as PACKETRECIEVEERR
+  if (result == FINGERPRINT_PACKETRECIEVEERR || result == FINGERPRINT_TIMEOUT ||
+      result == FINGERPRINT_BADPACKET) {
+    if (++this->consecutive_errors_ >= LINK_ERROR_THRESHOLD) {
+      this->mark_link_down();
+    }
+    return;
+  }
+  this->consecutive_errors_ = 0;
+  this->last_link_activity_ = millis();
+}
+
+void FingerprintDoorbell::send_heartbeat() {
+  Adafruit_Fingerprint_Packet reply(FINGERPRINT_ACKPACKET, 0, nullptr);
+  // Any answer proves the link is alive, even an "unsupported command" error
+  this->send_frame(HANDSHAKE_FRAME, reply, HEARTBEAT_TIMEOUT_MS);
+}
+
+uint8_t FingerprintDoorbell::send_command(uint8_t *data, uint16_t length, Adafruit_Fingerprint_Packet &reply,
+                                          uint16_t timeout_ms) {
+  uint8_t frame[64 + FRAME_OVERHEAD];
+  if (length > 64)
+    return FINGERPRINT_BADPACKET;
+  return this->send_frame(frame, build_frame(FINGERPRINT_COMMANDPACKET, data, length, frame), reply, timeout_ms);
+}
+
+uint8_t FingerprintDoorbell::send_frame(const uint8_t *frame, size_t size, Adafruit_Fingerprint_Packet &reply,
+                                        uint16_t timeout_ms) {
+  this->link_.write(frame, size);
+  
+  if (this->finger_->getStructuredPacket(&reply, timeout_ms) != FINGERPRINT_OK ||
+      reply.type != FINGERPRINT_ACKPACKET) {
+    this->track_link(FINGERPRINT_TIMEOUT);
+    return FINGERPRINT_PACKETRECIEVEERR;
+  }
+  this->track_link(FINGERPRINT_OK);
+  return reply.data[0];
+}
+
+uint8_t FingerprintDoorbell::get_image() {
+  Adafruit_Fingerprint_Packet reply(FINGERPRINT_ACKPACKET, 0, nullptr);
+  return this->send_frame(GET_IMAGE_FRAME, reply, GET_IMAGE_TIMEOUT_MS);
+}
+
+uint8_t FingerprintDoorbell::image_to_template(uint8_t slot) {
+  Adafruit_Fingerprint_Packet reply(FINGERPRINT_ACKPACKET, 0, nullptr);
+  if (slot < 1 || slot > IMAGE2TZ_FRAMES.size())
+    return FINGERPRINT_BADPACKET;
+  return this->send_frame(IMAGE2TZ_FRAMES[slot - 1], reply);
+}
+
+uint8_t FingerprintDoorbell::search_templates(uint16_t &id, uint16_t &confidence) {
+  Adafruit_Fingerprint_Packet reply(FINGERPRINT_ACKPACKET, 0, nullptr);
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  uint32_t start = micros();
+  uint8_t result = this->send_frame(this->search_frame_, reply);
+  uint32_t elapsed = micros() - start;
+  this->tier_stats_.search_count++;
+  this->tier_stats_.search_us += elapsed;
+  if (elapsed > this->tier_stats_.search_max_us)
+    this->tier_stats_.search_max_us = elapsed;
+#else
+  uint8_t result = this->send_frame(this->search_frame_, reply);
+#endif
+  if (result == FINGERPRINT_OK) {
+    id = (reply.data[1] << 8) | reply.data[2];
+    confidence = (reply.data[3] << 8) | reply.data[4];
+  }
+  return result;
 }
 
 Match FingerprintDoorbell::scan_fingerprint() {
@@ -254,9 +657,14 @@ Match FingerprintDoorbell::scan_fingerprint() {
     }
   }
 
+  this->scan_start_ms_ = millis();
+
   // Multi-pass scanning (up to 5 attempts) - exactly like original
   bool do_another_scan = true;
   int scan_pass = 0;
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  bool cold_searched = false;
+#endif
   
   while (do_another_scan) {
     do_another_scan = false;
@@ -270,7 +678,12 @@ Match FingerprintDoorbell::scan_fingerprint() {
       do_imaging = false;
       imaging_pass++;
       
-      match.return_code = this->finger_->getImage();
+      match.return_code = this->get_image();
+      // A missed answer is confirmed by process_loop()'s handshakes, not more GetImages
+      if (!this->sensor_connected_ || this->consecutive_errors_ > 0) {
+        match.scan_result = ScanResult::ERROR;
+        return match;
+      }
       
       switch (match.return_code) {
         case FINGERPRINT_OK:
@@ -311,7 +724,7 @@ Match FingerprintDoorbell::scan_fingerprint() {
     }
 
     // STEP 2: Convert Image
-    match.return_code = this->finger_->image2Tz();
+    match.return_code = this->image_to_template(1);
     
     switch (match.return_code) {
       case FINGERPRINT_OK:
@@ -333,19 +746,29 @@ Match FingerprintDoorbell::scan_fingerprint() {
     }
 
     // STEP 3: Search DB
-    match.return_code = this->finger_->fingerSearch();
+    match.return_code = this->search_templates(match.match_id, match.match_confidence);
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+    // The library holds sensor slots; a slot that maps to no ID is no match
+    if (match.return_code == FINGERPRINT_OK) {
+      match.match_id = this->resolve_slot(match.match_id);
+      if (match.match_id == 0)
+        match.return_code = FINGERPRINT_NOTFOUND;
+    }
+    // Cold templates get one bounded pass per touch, on the first capture the library misses
+    if (match.return_code == FINGERPRINT_NOTFOUND && !cold_searched) {
+      cold_searched = true;
+      if (this->search_cold(match))
+        match.return_code = FINGERPRINT_OK;
+    }
+#endif
     
     if (match.return_code == FINGERPRINT_OK) {
       // Match found - LED is set in loop() after scan returns
       match.scan_result = ScanResult::MATCH_FOUND;
-      match.match_id = this->finger_->fingerID;
-      match.match_confidence = this->finger_->confidence;
       
-      auto it = this->fingerprint_names_.find(match.match_id);
-      if (it != this->fingerprint_names_.end()) {
-        match.match_name = it->second;
-      } else {
-        match.match_name = "unknown";
+      const char *name = this->fingerprint_names_.get(match.match_id);
+      if (name != nullptr) {
+        memcpy(match.match_name, name, sizeof(match.match_name));
       }
       
     } else if (match.return_code == FINGERPRINT_PACKETRECIEVEERR) {
@@ -366,35 +789,151 @@ Match FingerprintDoorbell::scan_fingerprint() {
   return match;
 }
 
+// ==================== TEMPLATE REFRESH ====================
+// Skin changes over time, so confidence for old templates drifts down. After a
+// high-confidence match the matched image is still in the sensor's image buffer;
+// merging it with the stored template and writing the result back keeps the template
+// current. The per-slot rate limit is millis() in RAM: after a reboot every slot may
+// refresh once.
+
+bool FingerprintDoorbell::should_refresh_template(const Match &match) {
+  if (!this->template_refresh_ || match.match_id == 0 || match.match_id > MAX_FINGERPRINT_ID ||
+      !this->in_sensor(match.match_id))
+    return false;
+  if (match.match_confidence < this->template_refresh_min_confidence_)
+    return false;
+  
+  uint32_t last = this->last_refresh_time_[match.match_id];
+  return last == 0 || millis() - last >= this->template_refresh_interval_;
+}
+
+void FingerprintDoorbell::refresh_template(uint16_t id) {
+  TraceScope trace(&this->trace_, "template_refresh");
+  uint32_t start = millis();
+  
+  // The LED command after the match may have reused char buffer 1, so convert the
+  // matched image into it again rather than trusting what is left there
+  uint8_t result = this->image_to_template(1);
+  if (result != FINGERPRINT_OK) {
+    ESP_LOGW(TAG, "Template refresh: could not convert the image for ID %d: %d", id, result);
+    return;
+  }
+  
+  // Load the stored template into char buffer 2, next to the fresh capture in buffer 1
+  uint8_t cmd_data[] = {FINGERPRINT_LOAD, 0x02, (uint8_t)(id >> 8), (uint8_t)(id & 0xFF)};
+  Adafruit_Fingerprint_Packet ack_packet(FINGERPRINT_ACKPACKET, 0, nullptr);
+  if (this->send_command(cmd_data, sizeof(cmd_data), ack_packet, 1000) != FINGERPRINT_OK) {
+    ESP_LOGW(TAG, "Template refresh: could not load template %d", id);
+    return;
+  }
+  
+  // createModel() refuses captures that don't belong to the template (ENROLLMISMATCH)
+  result = this->finger_->createModel();
+  if (result != FINGERPRINT_OK) {
+    ESP_LOGW(TAG, "Template refresh: merge failed for ID %d: %d", id, result);
+    return;
+  }
+  
+  result = this->finger_->storeModel(id);
+  if (result != FINGERPRINT_OK) {
+    ESP_LOGW(TAG, "Template refresh: store failed for ID %d: %d", id, result);
+    return;
+  }
+  
+  uint32_t now = millis();
+  this->last_refresh_time_[id] = now != 0 ? now : 1;
+  ESP_LOGI(TAG, "Template %d refreshed in %u ms", id, (unsigned) (now - start));
+}
+
 // ==================== ENROLLMENT ====================
 
-void FingerprintDoorbell::start_enrollment(uint16_t id, const std::string &name) {
+// R503 commands not exposed by the Arduino library
+#define FINGERPRINT_CANCEL 0x30
+#define FINGERPRINT_AUTOENROLL 0x31
+static constexpr auto CANCEL_FRAME = make_command_frame<1>({FINGERPRINT_CANCEL});
+
+// AutoEnroll parameter flags. The sensor's polarity differs per bit: bit 3 set allows
+// overwriting an occupied ID, bit 4 set rejects a finger already enrolled under another ID.
+static const uint16_t AUTO_ENROLL_ALLOW_OVERWRITE = 1 << 3;
+static const uint16_t AUTO_ENROLL_REJECT_DUPLICATE = 1 << 4;
+
+// AutoEnroll progress steps, reported in parameter 1 of every ack packet
+static const uint8_t AUTO_ENROLL_STEP_CHECK = 0x00;
+static const uint8_t AUTO_ENROLL_STEP_IMAGE = 0x01;
+static const uint8_t AUTO_ENROLL_STEP_FEATURE = 0x02;
+static const uint8_t AUTO_ENROLL_STEP_LEAVE = 0x03;
+static const uint8_t AUTO_ENROLL_STEP_MERGE = 0x04;
+static const uint8_t AUTO_ENROLL_STEP_DUPLICATE = 0x05;
+static const uint8_t AUTO_ENROLL_STEP_STORE = 0x06;
+
+static const uint8_t ENROLL_SAMPLES = 5;
+
+// ReadIndexTable returns a 32-byte occupancy bitmap per page of 256 slots
+#define FINGERPRINT_READINDEXTABLE 0x1F
+
+// Pause between two entries of an enrollment session
+static const uint32_t SESSION_NEXT_DELAY_MS = 2000;
+
+bool FingerprintDoorbell::start_enrollment(uint16_t id, const std::string &name) {
+  if (this->session_active_) {
+    ESP_LOGW(TAG, "Cannot enroll: enrollment session in progress");
+    this->publish_last_action("Enroll failed: session in progress");
+    return false;
+  }
+  return this->begin_enrollment(id, name);
+}
+
+bool FingerprintDoorbell::begin_enrollment(uint16_t id, const std::string &name, uint8_t attempt) {
   if (!this->sensor_connected_) {
     ESP_LOGW(TAG, "Cannot enroll: sensor not connected");
     this->publish_enroll_status("Error: Sensor not connected");
     this->publish_last_action("Enroll failed: no sensor");
-    return;
+    return false;
   }
   
-  if (id < 1 || id > 200) {
-    ESP_LOGW(TAG, "Invalid ID %d (must be 1-200)", id);
-    this->publish_enroll_status("Error: Invalid ID (1-200)");
+  if (id < 1 || id > MAX_FINGERPRINT_ID) {
+    ESP_LOGW(TAG, "Invalid ID %d (must be 1-%u)", id, MAX_FINGERPRINT_ID);
+    this->publish_enroll_status("Error: Invalid ID (1-" + std::to_string(MAX_FINGERPRINT_ID) + ")");
     this->publish_last_action("Enroll failed: invalid ID");
-    return;
+    return false;
+  }
+  
+  uint16_t slot = id;
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  // A cold ID is enrolled into a cache slot and copied to cold storage once it is complete
+  if (this->is_cold_id(id)) {
+    int index = this->cold_.fits(id) ? this->release_cache_slot(id) : -1;
+    if (index < 0) {
+      ESP_LOGW(TAG, "Cannot enroll ID %d: no room in cold storage or no cache slot", id);
+      this->publish_enroll_status("Error: No room for ID " + std::to_string(id));
+      this->publish_last_action("Enroll failed: no room");
+      return false;
+    }
+    slot = this->cache_slot(index);
   }
+#endif
   
   ESP_LOGI(TAG, "Starting enrollment for ID %d, name: %s", id, name.c_str());
+  this->cancel_timeout("led_ready");
   
   this->mode_ = Mode::ENROLL;
   this->enroll_step_ = EnrollStep::WAITING_FOR_FINGER;
   this->enroll_id_ = id;
+  this->enroll_slot_ = slot;
   this->enroll_name_ = name;
   this->enroll_sample_ = 1;
+  this->enroll_attempt_ = attempt;
   this->enroll_timeout_ = millis() + 60000;  // 60 second timeout
   
   this->set_led_ring_enroll();
   this->publish_enroll_status("Place finger (1/5)");
   this->publish_last_action("Enrollment started for ID " + std::to_string(id));
+
+  // Let the sensor run capture/merge/store itself if it supports AutoEnroll
+  if (this->auto_enroll_ && this->auto_enroll_supported_) {
+    this->start_auto_enroll();
+  }
+  return true;
 }
 
 void FingerprintDoorbell::cancel_enrollment() {
@@ -403,22 +942,33 @@ void FingerprintDoorbell::cancel_enrollment() {
   }
   
   ESP_LOGI(TAG, "Enrollment cancelled");
-  this->mode_ = Mode::SCAN;
-  this->enroll_step_ = EnrollStep::IDLE;
+  if (this->enroll_step_ == EnrollStep::AUTO_RUNNING) {
+    this->cancel_auto_enroll();
+  }
+  this->cancel_timeout("enroll_next");
   this->set_led_ring_ready();
   this->publish_enroll_status("Cancelled");
   this->publish_last_action("Enrollment cancelled");
+  this->finish_enrollment("cancelled", true);
 }
 
 void FingerprintDoorbell::process_enrollment() {
+  // Between two session entries: the next one is started by a timeout
+  if (this->enroll_step_ == EnrollStep::IDLE) {
+    return;
+  }
+
   // Check timeout
   if (millis() > this->enroll_timeout_) {
     ESP_LOGW(TAG, "Enrollment timeout");
-    this->mode_ = Mode::SCAN;
-    this->enroll_step_ = EnrollStep::IDLE;
+    if (this->enroll_step_ == EnrollStep::AUTO_RUNNING) {
+      this->cancel_auto_enroll();
+    }
     this->set_led_ring_ready();
     this->publish_enroll_status("Timeout");
     this->publish_last_action("Enrollment timeout");
+    // Nobody is at the sensor any more, so don't keep a session waiting either
+    this->finish_enrollment("timeout", true);
     return;
   }
 
@@ -426,7 +976,7 @@ void FingerprintDoorbell::process_enrollment() {
   
   switch (this->enroll_step_) {
     case EnrollStep::WAITING_FOR_FINGER:
-      result = this->finger_->getImage();
+      result = this->get_image();
       if (result == FINGERPRINT_OK) {
         ESP_LOGI(TAG, "Image captured for sample %d", this->enroll_sample_);
         this->enroll_step_ = EnrollStep::CONVERTING;
@@ -436,7 +986,7 @@ void FingerprintDoorbell::process_enrollment() {
       break;
       
     case EnrollStep::CONVERTING:
-      result = this->finger_->image2Tz(this->enroll_sample_);
+      result = this->image_to_template(this->enroll_sample_);
       if (result == FINGERPRINT_OK) {
         ESP_LOGI(TAG, "Image converted for sample %d", this->enroll_sample_);
         
@@ -447,24 +997,27 @@ void FingerprintDoorbell::process_enrollment() {
           result = this->finger_->createModel();
           if (result == FINGERPRINT_OK) {
             ESP_LOGI(TAG, "Model created successfully");
-            this->enroll_step_ = EnrollStep::STORING;
-            this->publish_enroll_status("Storing...");
+            if (this->enroll_verify_touches_ > 0) {
+              // Verified from buffer 1 before it replaces what the slot holds now
+              this->start_enroll_verification(false);
+            } else {
+              this->enroll_step_ = EnrollStep::STORING;
+              this->publish_enroll_status("Storing...");
+            }
           } else if (result == FINGERPRINT_ENROLLMISMATCH) {
             ESP_LOGW(TAG, "Fingerprints did not match");
-            this->mode_ = Mode::SCAN;
-            this->enroll_step_ = EnrollStep::IDLE;
             this->set_led_ring_error();
             this->publish_enroll_status("Error: prints don't match");
             this->publish_last_action("Enrollment failed: mismatch");
-            this->set_timeout(2000, [this]() { this->set_led_ring_ready(); });
+            this->set_timeout("led_ready", 2000, [this]() { this->set_led_ring_ready(); });
+            this->finish_enrollment("mismatch");
           } else {
             ESP_LOGW(TAG, "Error creating model: %d", result);
-            this->mode_ = Mode::SCAN;
-            this->enroll_step_ = EnrollStep::IDLE;
             this->set_led_ring_error();
             this->publish_enroll_status("Error creating model");
             this->publish_last_action("Enrollment failed");
-            this->set_timeout(2000, [this]() { this->set_led_ring_ready(); });
+            this->set_timeout("led_ready", 2000, [this]() { this->set_led_ring_ready(); });
+            this->finish_enrollment("failed");
           }
         } else {
           // Need more samples - show LED feedback for successful scan
@@ -481,7 +1034,7 @@ void FingerprintDoorbell::process_enrollment() {
       break;
       
     case EnrollStep::WAITING_REMOVE:
-      result = this->finger_->getImage();
+      result = this->get_image();
       if (result == FINGERPRINT_NOFINGER) {
         this->enroll_sample_++;
         ESP_LOGI(TAG, "Ready for sample %d", this->enroll_sample_);
@@ -492,37 +1045,47 @@ void FingerprintDoorbell::process_enrollment() {
       break;
       
     case EnrollStep::STORING:
-      result = this->finger_->storeModel(this->enroll_id_);
+      result = this->finger_->storeModel(this->enroll_slot_);
       if (result == FINGERPRINT_OK) {
-        ESP_LOGI(TAG, "Fingerprint stored at ID %d", this->enroll_id_);
-        this->save_fingerprint_name(this->enroll_id_, this->enroll_name_);
-        this->finger_->getTemplateCount();
-        
-        // Show success LED and wait for finger to be removed
-        this->enroll_step_ = EnrollStep::DONE;
-        this->set_led_ring_match();  // Purple glow for success
-        this->publish_enroll_status("Success! Remove finger");
-        this->publish_last_action("Enrolled: " + this->enroll_name_ + " (ID " + std::to_string(this->enroll_id_) + ")");
+        this->on_enrollment_stored();
       } else {
         ESP_LOGW(TAG, "Error storing model: %d", result);
-        this->mode_ = Mode::SCAN;
-        this->enroll_step_ = EnrollStep::IDLE;
         this->set_led_ring_error();
         this->publish_enroll_status("Error storing");
         this->publish_last_action("Enrollment failed: storage error");
-        this->set_timeout(2000, [this]() { this->set_led_ring_ready(); });
+        this->set_timeout("led_ready", 2000, [this]() { this->set_led_ring_ready(); });
+        this->finish_enrollment("failed");
+      }
+      break;
+
+    case EnrollStep::AUTO_RUNNING:
+      this->process_auto_enroll();
+      break;
+
+    case EnrollStep::VERIFY_WAIT_REMOVE:
+      result = this->get_image();
+      if (result == FINGERPRINT_NOFINGER) {
+        this->enroll_step_ = EnrollStep::VERIFY_WAITING_FOR_FINGER;
+        // LED commands can corrupt the char buffers, so an unstored model gets none
+        if (this->verify_stored_)
+          this->set_led_ring_enroll();
+        this->publish_enroll_status("Verify: place finger (" + std::to_string(this->verify_touch_) + "/" +
+                                    std::to_string(this->enroll_verify_touches_) + ")");
       }
       break;
+
+    case EnrollStep::VERIFY_WAITING_FOR_FINGER:
+      this->process_verify_touch();
+      break;
     
     case EnrollStep::DONE:
       // Wait for finger to be removed before returning to scan mode
-      result = this->finger_->getImage();
+      result = this->get_image();
       if (result == FINGERPRINT_NOFINGER) {
         ESP_LOGI(TAG, "Enrollment complete, finger removed");
-        this->mode_ = Mode::SCAN;
-        this->enroll_step_ = EnrollStep::IDLE;
         this->set_led_ring_ready();
         this->publish_enroll_status("Complete");
+        this->finish_enrollment("enrolled");
       }
       break;
       
@@ -531,43 +1094,697 @@ void FingerprintDoorbell::process_enrollment() {
   }
 }
 
-// ==================== DELETE / RENAME ====================
-
-bool FingerprintDoorbell::delete_fingerprint(uint16_t id) {
-  if (!this->sensor_connected_ || this->finger_ == nullptr) {
-    this->publish_last_action("Delete failed: no sensor");
-    return false;
+void FingerprintDoorbell::finish_enrollment(const char *result, bool abort_session) {
+  this->enroll_step_ = EnrollStep::IDLE;
+  
+  if (this->session_active_) {
+    this->session_entries_[this->session_index_].result = result;
+    this->session_index_++;
+    
+    if (!abort_session && this->session_index_ < this->session_entries_.size()) {
+      // Stay in enroll mode so no scan runs between two people
+      this->set_timeout("enroll_next", SESSION_NEXT_DELAY_MS, [this]() { this->start_session_entry(); });
+      return;
+    }
+    
+    for (size_t i = this->session_index_; i < this->session_entries_.size(); i++) {
+      this->session_entries_[i].result = "skipped";
+    }
+    this->session_active_ = false;
+    
+    int enrolled = 0;
+    for (const auto &entry : this->session_entries_) {
+      if (entry.result == "enrolled")
+        enrolled++;
+    }
+    std::string summary = "Session complete: " + std::to_string(enrolled) + "/" +
+                          std::to_string(this->session_entries_.size()) + " enrolled";
+    this->publish_enroll_status(summary);
+    this->publish_last_action(summary);
   }
   
-  if (this->finger_->deleteModel(id) == FINGERPRINT_OK) {
-    std::string name = this->get_fingerprint_name(id);
-    this->delete_fingerprint_name(id);
-    this->finger_->getTemplateCount();
-    ESP_LOGI(TAG, "Deleted fingerprint ID %d", id);
-    this->publish_last_action("Deleted: " + name + " (ID " + std::to_string(id) + ")");
+  this->mode_ = Mode::SCAN;
+}
+
+// ==================== ENROLLMENT SESSION ====================
+
+bool FingerprintDoorbell::read_slot_occupancy(std::vector<bool> &occupied) {
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  if (this->cold_.enabled()) {
+    if (!this->read_index_table(occupied, this->hot_slots_))
+      return false;
+    occupied.resize(MAX_FINGERPRINT_ID + 1, false);
+    this->cold_.for_each([&occupied](uint16_t id) {
+      if (id <= MAX_FINGERPRINT_ID)
+        occupied[id] = true;
+    });
     return true;
   }
-  this->publish_last_action("Delete failed for ID " + std::to_string(id));
-  return false;
+#endif
+  return this->read_index_table(occupied, MAX_FINGERPRINT_ID);
 }
 
-bool FingerprintDoorbell::delete_all_fingerprints() {
-  if (!this->sensor_connected_ || this->finger_ == nullptr) {
-    this->publish_last_action("Delete all failed: no sensor");
-    return false;
-  }
+// Sensor slots 0..last_slot
+bool FingerprintDoorbell::read_index_table(std::vector<bool> &occupied, uint16_t last_slot) {
+  occupied.assign(last_slot + 1, false);
   
-  if (this->finger_->emptyDatabase() == FINGERPRINT_OK) {
-    // Collect IDs first to avoid modifying map while iterating
-    std::vector<uint16_t> ids_to_delete;
-    for (auto const& pair : this->fingerprint_names_) {
-      ids_to_delete.push_back(pair.first);
-    }
-    // Now delete each name from preferences
-    for (uint16_t id : ids_to_delete) {
-      this->delete_fingerprint_name(id);
+  for (uint8_t page = 0; page <= last_slot / 256; page++) {
+    uint8_t cmd_data[] = {FINGERPRINT_READINDEXTABLE, page};
+    Adafruit_Fingerprint_Packet ack_packet(FINGERPRINT_ACKPACKET, 0, nullptr);
+    if (this->send_command(cmd_data, sizeof(cmd_data), ack_packet, 1000) != FINGERPRINT_OK) {
+      return false;
     }
+    
+    // Bit n of byte k marks slot page*256 + k*8 + n as occupied
+    for (uint16_t bit = 0; bit < 256; bit++) {
+      uint16_t id = page * 256 + bit;
+      if (id > last_slot)
+        break;
+      occupied[id] = (ack_packet.data[1 + bit / 8] >> (bit % 8)) & 0x01;
+    }
+  }
+  return true;
+}
+
+bool FingerprintDoorbell::start_enrollment_session(const std::vector<std::string> &names) {
+  if (!this->sensor_connected_ || this->finger_ == nullptr) {
+    ESP_LOGW(TAG, "Cannot start enrollment session: sensor not connected");
+    this->publish_last_action("Enroll session failed: no sensor");
+    return false;
+  }
+  if (this->mode_ == Mode::ENROLL) {
+    ESP_LOGW(TAG, "Cannot start enrollment session: enrollment in progress");
+    this->publish_last_action("Enroll session failed: busy");
+    return false;
+  }
+  if (names.empty()) {
+    return false;
+  }
+  
+  // Allocate from the sensor's real occupancy; fall back to our name table
+  std::vector<bool> occupied;
+  if (!this->read_slot_occupancy(occupied)) {
+    ESP_LOGW(TAG, "Could not read sensor index table, using stored names for slot allocation");
+    occupied.assign(MAX_FINGERPRINT_ID + 1, false);
+    this->fingerprint_names_.for_each([&occupied](uint16_t id, const char *) { occupied[id] = true; });
+  }
+  
+  std::vector<EnrollSessionEntry> entries;
+  uint16_t next_id = 1;
+  for (const auto &name : names) {
+    while (next_id <= MAX_FINGERPRINT_ID && occupied[next_id])
+      next_id++;
+    if (next_id > MAX_FINGERPRINT_ID) {
+      ESP_LOGW(TAG, "Not enough free slots for %d names", (int) names.size());
+      this->publish_last_action("Enroll session failed: sensor full");
+      return false;
+    }
+    EnrollSessionEntry entry;
+    entry.name = name;
+    entry.id = next_id++;
+    entries.push_back(entry);
+  }
+  
+  ESP_LOGI(TAG, "Starting enrollment session with %d entries", (int) entries.size());
+  this->session_entries_ = std::move(entries);
+  this->session_index_ = 0;
+  this->session_active_ = true;
+  this->mode_ = Mode::ENROLL;
+  this->start_session_entry();
+  return true;
+}
+
+void FingerprintDoorbell::start_session_entry() {
+  const auto &entry = this->session_entries_[this->session_index_];
+  this->session_entries_[this->session_index_].result = "enrolling";
+  this->publish_last_action("Session " + std::to_string(this->session_index_ + 1) + "/" +
+                            std::to_string(this->session_entries_.size()) + ": " + entry.name +
+                            " (ID " + std::to_string(entry.id) + ")");
+  if (!this->begin_enrollment(entry.id, entry.name)) {
+    this->finish_enrollment("failed", true);
+  }
+}
+
+std::string FingerprintDoorbell::get_enroll_session_json() {
+  std::string json = "{\"active\":" + std::string(this->session_active_ ? "true" : "false") + ",\"entries\":[";
+  bool first = true;
+  for (const auto &entry : this->session_entries_) {
+    if (!first) json += ",";
+    json += "{\"id\":" + std::to_string(entry.id) + ",\"name\":\"" + json_escape(entry.name) + "\",\"result\":\"" + entry.result + "\"}";
+    first = false;
+  }
+  json += "]}";
+  return json;
+}
+
+void FingerprintDoorbell::encode_enroll_session(CborWriter &writer) {
+  writer.begin_map(2);
+  writer.add_text("active");
+  writer.add_bool(this->session_active_);
+  writer.add_text("entries");
+  writer.begin_array(this->session_entries_.size());
+  for (const auto &entry : this->session_entries_) {
+    writer.begin_map(3);
+    writer.add_text("id");
+    writer.add_uint(entry.id);
+    writer.add_text("name");
+    writer.add_text(entry.name.c_str(), entry.name.size());
+    writer.add_text("result");
+    writer.add_text(entry.result.c_str(), entry.result.size());
+  }
+}
+
+void FingerprintDoorbell::on_enrollment_stored() {
+  ESP_LOGI(TAG, "Fingerprint stored at ID %d", this->enroll_id_);
+  
+  // Host-driven enrollment verified the model before storing it
+  if (this->enroll_verify_touches_ == 0 || this->enroll_step_ == EnrollStep::STORING) {
+    this->complete_enrollment(this->enroll_verify_touches_ == 0 ? 0 : this->verify_min_score_);
+    return;
+  }
+  
+  // AutoEnroll stores the model itself, so its touches are matched against the slot
+  this->start_enroll_verification(true);
+}
+
+// Quality gate: match extra touches 1:1 against the new model. An unstored model
+// stays in char buffer 1 and only replaces the slot's template once it passes.
+void FingerprintDoorbell::start_enroll_verification(bool stored) {
+  this->verify_stored_ = stored;
+  this->verify_touch_ = 1;
+  this->verify_min_score_ = UINT16_MAX;
+  this->enroll_timeout_ = millis() + 60000;
+  this->enroll_step_ = EnrollStep::VERIFY_WAIT_REMOVE;
+  if (stored)
+    this->set_led_ring_match();
+  this->publish_enroll_status("Verify: remove finger");
+}
+
+void FingerprintDoorbell::complete_enrollment(uint16_t quality) {
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  if (this->is_cold_id(this->enroll_id_) && !this->persist_cold(this->enroll_id_, this->enroll_slot_)) {
+    this->finger_->deleteModel(this->enroll_slot_);
+    this->set_led_ring_error();
+    this->publish_enroll_status("Error storing");
+    this->publish_last_action("Enrollment failed: storage error");
+    this->set_timeout("led_ready", 2000, [this]() { this->set_led_ring_ready(); });
+    this->finish_enrollment("failed");
+    return;
+  }
+#endif
+  this->save_fingerprint_name(this->enroll_id_, this->enroll_name_);
+  this->save_fingerprint_quality(this->enroll_id_, quality);
+  this->finger_->getTemplateCount();
+  
+  // Show success LED and wait for finger to be removed
+  this->enroll_step_ = EnrollStep::DONE;
+  this->set_led_ring_match();  // Purple glow for success
+  this->publish_enroll_status("Success! Remove finger");
+  this->publish_last_action("Enrolled: " + this->enroll_name_ + " (ID " + std::to_string(this->enroll_id_) + ")");
+}
+
+// ==================== ENROLLMENT VERIFICATION ====================
+
+// Match command (not in Arduino library): compares char buffers 1 and 2
+#define FINGERPRINT_MATCH 0x03
+static constexpr auto MATCH_FRAME = make_command_frame<1>({FINGERPRINT_MATCH});
+
+uint8_t FingerprintDoorbell::match_char_buffers(uint16_t &score) {
+  score = 0;
+  Adafruit_Fingerprint_Packet ack_packet(FINGERPRINT_ACKPACKET, 0, nullptr);
+  uint8_t result = this->send_frame(MATCH_FRAME, ack_packet);
+  if (result == FINGERPRINT_OK) {
+    score = (ack_packet.data[1] << 8) | ack_packet.data[2];
+  }
+  return result;
+}
+
+void FingerprintDoorbell::process_verify_touch() {
+  uint8_t result = this->get_image();
+  if (result != FINGERPRINT_OK) {
+    if (result != FINGERPRINT_NOFINGER)
+      ESP_LOGW(TAG, "Error capturing verification image: %d", result);
+    return;
+  }
+  
+  // Fresh capture goes to buffer 2; buffer 1 holds the new model, reloaded from the
+  // slot when the sensor already stored it
+  result = this->image_to_template(2);
+  if (result == FINGERPRINT_OK && this->verify_stored_)
+    result = this->finger_->loadModel(this->enroll_slot_);
+  
+  uint16_t score = 0;
+  if (result == FINGERPRINT_OK) {
+    result = this->match_char_buffers(score);
+    if (result == FINGERPRINT_NOMATCH)
+      result = FINGERPRINT_OK;  // A miss is a valid measurement with score 0
+  }
+  
+  if (result != FINGERPRINT_OK) {
+    ESP_LOGW(TAG, "Verification touch failed: %d", result);
+    this->publish_enroll_status("Error, try again");
+    this->enroll_step_ = EnrollStep::VERIFY_WAIT_REMOVE;
+    return;
+  }
+  
+  ESP_LOGI(TAG, "Verification touch %d/%d: score %d", this->verify_touch_, this->enroll_verify_touches_, score);
+  if (score < this->verify_min_score_)
+    this->verify_min_score_ = score;
+  
+  if (this->verify_touch_ < this->enroll_verify_touches_) {
+    this->verify_touch_++;
+    this->enroll_step_ = EnrollStep::VERIFY_WAIT_REMOVE;
+    if (this->verify_stored_)
+      this->set_led_ring_match();
+    this->publish_enroll_status("Verify: remove finger");
+    return;
+  }
+  
+  // All touches done - the weakest match is the template's quality
+  uint16_t quality = this->verify_min_score_;
+  if (quality >= this->enroll_min_quality_) {
+    ESP_LOGI(TAG, "Enrollment verified with quality %d", quality);
+    if (this->verify_stored_) {
+      this->complete_enrollment(quality);
+    } else {
+      this->enroll_step_ = EnrollStep::STORING;
+      this->publish_enroll_status("Storing...");
+    }
+    return;
+  }
+  
+  ESP_LOGW(TAG, "Enrollment quality %d below threshold %d", quality, this->enroll_min_quality_);
+  // Only AutoEnroll put the rejected model into the slot; otherwise the slot's
+  // previous template was never touched
+  if (this->verify_stored_)
+    this->finger_->deleteModel(this->enroll_slot_);
+  
+  if (this->enroll_attempt_ < this->enroll_retries_) {
+    this->publish_last_action("Low enrollment quality (" + std::to_string(quality) + "), retrying");
+    this->begin_enrollment(this->enroll_id_, this->enroll_name_, this->enroll_attempt_ + 1);
+    return;
+  }
+  
+  this->set_led_ring_error();
+  this->publish_enroll_status("Error: low quality (" + std::to_string(quality) + ")");
+  this->publish_last_action("Enrollment failed: low quality");
+  this->set_timeout("led_ready", 2000, [this]() { this->set_led_ring_ready(); });
+  this->finish_enrollment("low_quality");
+}
+
+// ==================== 1:1 VERIFICATION ====================
+// When the user already claimed an identity (keypad, NFC tag, HA app), matching the
+// capture against that one slot is quicker than a search and is held to
+// verify_min_confidence instead of the sensor's search threshold.
+
+#ifdef USE_FINGERPRINT_DOORBELL_REST
+static const char *verify_state_name(VerifyState state) {
+  switch (state) {
+    case VerifyState::ARMED: return "armed";
+    case VerifyState::MATCHED: return "matched";
+    case VerifyState::NO_MATCH: return "no_match";
+    case VerifyState::NO_FINGER: return "no_finger";
+    case VerifyState::TIMEOUT: return "timeout";
+    case VerifyState::ERROR: return "error";
+    default: return "none";
+  }
+}
+#endif
+
+// Loop task only (the action, or a REST job): the finger must already be on the sensor
+bool FingerprintDoorbell::verify_fingerprint(uint16_t id) {
+  if (!this->sensor_connected_ || this->finger_ == nullptr || this->mode_ == Mode::ENROLL ||
+      id < 1 || id > MAX_FINGERPRINT_ID) {
+    ESP_LOGW(TAG, "Cannot verify ID %d now", id);
+    return false;
+  }
+  
+  this->last_verify_ = {VerifyState::NONE, id, 0};
+  this->scan_start_ms_ = millis();
+  
+  uint16_t confidence = 0;
+  uint8_t result = this->get_image();
+  if (result == FINGERPRINT_OK)
+    result = this->match_claimed(id, confidence);
+  this->finish_verify(result, confidence);
+  return true;
+}
+
+bool FingerprintDoorbell::arm_verify(uint16_t id, uint32_t timeout_ms) {
+  if (this->mode_ == Mode::ENROLL || id < 1 || id > MAX_FINGERPRINT_ID) {
+    ESP_LOGW(TAG, "Cannot arm verification of ID %d now", id);
+    return false;
+  }
+  
+  this->verify_deadline_ = millis() + timeout_ms;
+  this->last_verify_ = {VerifyState::ARMED, id, 0};
+  ESP_LOGI(TAG, "Next touch verifies ID %d (%u ms)", id, (unsigned) timeout_ms);
+  this->publish_last_actionf("Verify armed: ID %u", (unsigned) id);
+  return true;
+}
+
+// Matches the image in the sensor's image buffer against slot `id`
+uint8_t FingerprintDoorbell::match_claimed(uint16_t id, uint16_t &confidence) {
+  confidence = 0;
+  
+  // Capture goes to buffer 2, the claimed slot is loaded into buffer 1
+  uint8_t result = this->image_to_template(2);
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  // A cold ID is matched from its cache slot, or straight from cold storage
+  if (this->is_cold_id(id)) {
+    int index = this->find_cache(id);
+    if (index < 0) {
+      if (result == FINGERPRINT_OK)
+        result = this->load_cold(id, 1);
+      if (result == FINGERPRINT_OK)
+        result = this->match_char_buffers(confidence);
+      return result;
+    }
+    id = this->cache_slot(index);
+  }
+#endif
+  if (result == FINGERPRINT_OK)
+    result = this->finger_->loadModel(id);
+  if (result == FINGERPRINT_OK)
+    result = this->match_char_buffers(confidence);
+  return result;
+}
+
+void FingerprintDoorbell::process_armed_verify() {
+  VerifyResult &verify = this->last_verify_;
+  if ((int32_t) (millis() - this->verify_deadline_) >= 0) {
+    ESP_LOGI(TAG, "Verification of ID %d timed out", verify.id);
+    verify.state = VerifyState::TIMEOUT;
+    this->publish_last_actionf("Verify timed out: ID %u", (unsigned) verify.id);
+    return;
+  }
+  
+  if (!this->ignore_touch_ring_ && !this->is_ring_touched())
+    return;
+  
+  this->scan_start_ms_ = millis();
+  uint8_t result = this->get_image();
+  if (result == FINGERPRINT_NOFINGER || !this->sensor_connected_)
+    return;  // Keep waiting for the touch
+  
+  uint16_t confidence = 0;
+  if (result == FINGERPRINT_OK) {
+    this->set_led_ring_scanning();
+    result = this->match_claimed(verify.id, confidence);
+  }
+  this->finish_verify(result, confidence);
+}
+
+void FingerprintDoorbell::finish_verify(uint8_t result, uint16_t confidence) {
+  VerifyResult &verify = this->last_verify_;
+  verify.confidence = confidence;
+  
+  if (result == FINGERPRINT_NOFINGER) {
+    verify.state = VerifyState::NO_FINGER;
+  } else if (result == FINGERPRINT_OK && confidence >= this->verify_min_confidence_) {
+    verify.state = VerifyState::MATCHED;
+  } else if (result == FINGERPRINT_OK || result == FINGERPRINT_NOMATCH) {
+    verify.state = VerifyState::NO_MATCH;
+  } else {
+    verify.state = VerifyState::ERROR;
+  }
+  
+  switch (verify.state) {
+    case VerifyState::MATCHED: {
+      Match match;
+      match.scan_result = ScanResult::MATCH_FOUND;
+      match.match_id = verify.id;
+      match.match_confidence = confidence;
+      const char *name = this->fingerprint_names_.get(verify.id);
+      if (name != nullptr)
+        memcpy(match.match_name, name, sizeof(match.match_name));
+      this->publish_match(match, "Verified");
+      break;
+    }
+    case VerifyState::NO_MATCH:
+      // A failed claim is not a doorbell ring: no-match LED and its cooldown only
+      ESP_LOGI(TAG, "Verification of ID %d failed (confidence %d)", verify.id, confidence);
+      this->set_led_ring_no_match();
+      this->last_ring_time_ = millis();
+      this->publish_last_actionf("Verify failed: ID %u", (unsigned) verify.id);
+      break;
+    case VerifyState::NO_FINGER:
+      this->publish_last_actionf("Verify: no finger on sensor");
+      break;
+    default:
+      ESP_LOGW(TAG, "Verification of ID %d failed: error %d", verify.id, result);
+      this->publish_last_actionf("Verify error: ID %u", (unsigned) verify.id);
+      break;
+  }
+}
+
+// ==================== UNLOCK POLICY ====================
+// A match drives unlock_pin directly when the slot's access windows allow it. The
+// windows and each slot's default allowlist come from YAML; REST can override a
+// slot's windows, and the overrides are kept in flash.
+
+void FingerprintDoorbell::add_access_window(uint8_t days, uint16_t start, uint16_t end,
+                                            const std::vector<uint16_t> &ids) {
+  int window = this->access_policy_.add_window(days, start, end);
+  if (window < 0) {
+    ESP_LOGE(TAG, "Too many access windows, max %d", AccessPolicy<MAX_FINGERPRINT_ID>::MAX_WINDOWS);
+    return;
+  }
+  if (ids.empty()) {
+    for (uint16_t id = 1; id <= MAX_FINGERPRINT_ID; id++)
+      this->access_policy_.allow_by_default(window, id);
+  }
+  for (uint16_t id : ids)
+    this->access_policy_.allow_by_default(window, id);
+}
+
+bool FingerprintDoorbell::set_access_windows(uint16_t id, uint8_t windows) {
+  if (id < 1 || id > MAX_FINGERPRINT_ID)
+    return false;
+  this->access_policy_.set_override(id, windows);
+  this->access_pref_.save(&this->access_policy_.overrides());
+  ESP_LOGI(TAG, "Access windows for ID %d: 0x%02X%s", id, this->access_policy_.windows_for(id),
+           this->access_policy_.is_overridden(id) ? "" : " (default)");
+  return true;
+}
+
+void FingerprintDoorbell::load_access_overrides() {
+  this->access_pref_ = global_preferences->make_preference<AccessPolicy<MAX_FINGERPRINT_ID>::Overrides>(
+      this->pref_hash("fp_access"));
+  if (!this->access_pref_.load(&this->access_policy_.overrides()))
+    this->access_policy_.overrides().fill(AccessPolicy<MAX_FINGERPRINT_ID>::USE_DEFAULT);
+}
+
+void FingerprintDoorbell::update_access_clock() {
+#ifdef USE_TIME
+  if (this->time_ == nullptr || this->unlock_pin_ == nullptr)
+    return;
+  uint32_t now = millis();
+  if (this->clock_updated_ != 0 && now - this->clock_updated_ < 1000)
+    return;
+  this->clock_updated_ = now != 0 ? now : 1;
+  
+  ESPTime time = this->time_->now();
+  if (!time.is_valid()) {
+    this->clock_day_ = -1;  // Not synced yet: only always-open windows unlock
+    return;
+  }
+  this->clock_day_ = time.day_of_week - 1;
+  this->clock_minute_ = time.hour * 60 + time.minute;
+#endif
+}
+
+bool FingerprintDoorbell::try_unlock(uint16_t id) {
+  TraceScope trace(&this->trace_, "unlock_policy");
+  int64_t start = esp_timer_get_time();
+  bool allowed = this->access_policy_.allowed(id, this->clock_day_, this->clock_minute_);
+  uint32_t elapsed = esp_timer_get_time() - start;
+  this->unlock_eval_last_us_ = elapsed;
+  if (elapsed > this->unlock_eval_max_us_)
+    this->unlock_eval_max_us_ = elapsed;
+  
+  if (!allowed) {
+    this->unlock_denied_count_++;
+    ESP_LOGI(TAG, "ID %d is outside its access windows, not unlocking", id);
+    return false;
+  }
+  
+  this->unlock_pin_->digital_write(true);
+  uint32_t clear_time = millis() + this->unlock_duration_;
+  this->unlock_clear_time_ = clear_time != 0 ? clear_time : 1;
+  this->unlock_count_++;
+  return true;
+}
+
+// ==================== AUTO ENROLLMENT ====================
+// The R503 AutoEnroll command runs the whole capture/merge/store sequence on the
+// sensor and sends one ack packet per step. We only send the command once and then
+// pick up progress packets as they arrive, one per loop() iteration.
+
+void FingerprintDoorbell::start_auto_enroll() {
+  // Flush any leftover data so the first progress packet parses cleanly
+  this->link_.drain();
+  
+  // Re-enrolling an ID replaces it, and the same finger may sit under several IDs, like
+  // host-driven enrollment; AUTO_ENROLL_REJECT_DUPLICATE stays clear
+  uint16_t flags = AUTO_ENROLL_ALLOW_OVERWRITE;
+  uint8_t cmd_data[] = {
+    FINGERPRINT_AUTOENROLL,
+    (uint8_t)(this->enroll_slot_ >> 8), (uint8_t)(this->enroll_slot_ & 0xFF),
+    ENROLL_SAMPLES,
+    (uint8_t)(flags >> 8), (uint8_t)(flags & 0xFF),
+  };
+  uint8_t frame[sizeof(cmd_data) + FRAME_OVERHEAD];
+  this->link_.write(frame, build_frame(FINGERPRINT_COMMANDPACKET, cmd_data, sizeof(cmd_data), frame));
+  
+  this->enroll_step_ = EnrollStep::AUTO_RUNNING;
+  this->auto_enroll_acked_ = false;
+  this->auto_enroll_started_ = millis();
+  ESP_LOGI(TAG, "AutoEnroll started for ID %d", this->enroll_id_);
+}
+
+void FingerprintDoorbell::process_auto_enroll() {
+  // Nothing to do until the sensor reports its next step
+  if (!this->link_.available()) {
+    if (!this->auto_enroll_acked_ && millis() - this->auto_enroll_started_ > 1000) {
+      ESP_LOGW(TAG, "Sensor did not answer AutoEnroll, falling back to manual enrollment");
+      this->auto_enroll_supported_ = false;
+      this->enroll_step_ = EnrollStep::WAITING_FOR_FINGER;
+    }
+    return;
+  }
+  
+  Adafruit_Fingerprint_Packet packet(FINGERPRINT_ACKPACKET, 0, nullptr);
+  if (this->finger_->getStructuredPacket(&packet, 200) != FINGERPRINT_OK || packet.type != FINGERPRINT_ACKPACKET) {
+    ESP_LOGW(TAG, "Malformed AutoEnroll progress packet");
+    return;
+  }
+  
+  uint8_t code = packet.data[0];
+  uint8_t step = packet.data[1];
+  uint8_t sample = packet.data[2];
+  ESP_LOGD(TAG, "AutoEnroll: code=0x%02X step=0x%02X param=0x%02X", code, step, sample);
+  
+  if (code != FINGERPRINT_OK) {
+    if (!this->auto_enroll_acked_) {
+      // Rejected outright - most likely a sensor without AutoEnroll support
+      ESP_LOGW(TAG, "AutoEnroll rejected (0x%02X), falling back to manual enrollment", code);
+      this->auto_enroll_supported_ = false;
+      this->enroll_step_ = EnrollStep::WAITING_FOR_FINGER;
+      this->set_led_ring_enroll();
+      return;
+    }
+    
+    ESP_LOGW(TAG, "AutoEnroll failed at step %d: error 0x%02X", step, code);
+    this->set_led_ring_error();
+    if (code == FINGERPRINT_ENROLLMISMATCH) {
+      this->publish_enroll_status("Error: prints don't match");
+      this->publish_last_action("Enrollment failed: mismatch");
+    } else {
+      char status[40];
+      snprintf(status, sizeof(status), "Error: sensor code 0x%02X", code);
+      this->publish_enroll_status(status);
+      this->publish_last_action("Enrollment failed");
+    }
+    this->set_timeout("led_ready", 2000, [this]() { this->set_led_ring_ready(); });
+    this->finish_enrollment(code == FINGERPRINT_ENROLLMISMATCH ? "mismatch" : "failed");
+    return;
+  }
+  
+  this->auto_enroll_acked_ = true;
+  
+  switch (step) {
+    case AUTO_ENROLL_STEP_CHECK:
+      ESP_LOGI(TAG, "AutoEnroll accepted by sensor");
+      break;
+    case AUTO_ENROLL_STEP_IMAGE:
+      this->enroll_sample_ = sample;
+      ESP_LOGI(TAG, "Image captured for sample %d", sample);
+      break;
+    case AUTO_ENROLL_STEP_FEATURE:
+      if (sample < ENROLL_SAMPLES) {
+        this->publish_enroll_status("Remove finger");
+      }
+      break;
+    case AUTO_ENROLL_STEP_LEAVE:
+      this->enroll_sample_ = sample + 1;
+      this->publish_enroll_status("Place finger (" + std::to_string(this->enroll_sample_) + "/5)");
+      break;
+    case AUTO_ENROLL_STEP_MERGE:
+      this->publish_enroll_status("Creating model...");
+      break;
+    case AUTO_ENROLL_STEP_DUPLICATE:
+      this->publish_enroll_status("Storing...");
+      break;
+    case AUTO_ENROLL_STEP_STORE:
+      this->on_enrollment_stored();
+      break;
+    default:
+      break;
+  }
+}
+
+void FingerprintDoorbell::cancel_auto_enroll() {
+  this->link_.write(CANCEL_FRAME.data(), CANCEL_FRAME.size());
+  
+  // Drain the cancel ack and any progress packet that was already in flight
+  Adafruit_Fingerprint_Packet ack_packet(FINGERPRINT_ACKPACKET, 0, nullptr);
+  for (int i = 0; i < 3; i++) {
+    if (this->finger_->getStructuredPacket(&ack_packet, 200) != FINGERPRINT_OK)
+      break;
+  }
+  this->link_.drain();
+}
+
+// ==================== DELETE / RENAME ====================
+
+bool FingerprintDoorbell::delete_fingerprint(uint16_t id) {
+  if (!this->sensor_connected_ || this->finger_ == nullptr) {
+    this->publish_last_action("Delete failed: no sensor");
+    return false;
+  }
+  
+  if (this->delete_template(id) == FINGERPRINT_OK) {
+    std::string name = this->get_fingerprint_name(id);
+    this->delete_fingerprint_name(id);
+    this->save_fingerprint_quality(id, 0);
+    if (this->access_policy_.is_overridden(id))
+      this->set_access_windows(id, AccessPolicy<MAX_FINGERPRINT_ID>::USE_DEFAULT);
+    this->finger_->getTemplateCount();
+    ESP_LOGI(TAG, "Deleted fingerprint ID %d", id);
+    this->publish_last_action("Deleted: " + name + " (ID " + std::to_string(id) + ")");
+    return true;
+  }
+  this->publish_last_action("Delete failed for ID " + std::to_string(id));
+  return false;
+}
+
+bool FingerprintDoorbell::delete_all_fingerprints() {
+  if (!this->sensor_connected_ || this->finger_ == nullptr) {
+    this->publish_last_action("Delete all failed: no sensor");
+    return false;
+  }
+  
+  if (this->finger_->emptyDatabase() == FINGERPRINT_OK) {
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+    if (this->cold_.enabled()) {
+      this->cold_.erase_all();
+      this->cache_ids_.fill(0);
+      this->cache_last_match_.fill(0);
+      std::fill(this->cold_last_match_.begin(), this->cold_last_match_.end(), 0);
+      this->save_cache_map();
+    }
+#endif
+    // Clear each stored name in preferences (erasing the current bit is safe while iterating)
+    this->fingerprint_names_.for_each([this](uint16_t id, const char *) { this->delete_fingerprint_name(id); });
     this->fingerprint_names_.clear();
+    global_preferences->sync();
+    this->fingerprint_quality_.fill(0);
+    this->quality_pref_.save(&this->fingerprint_quality_);
+    if (this->unlock_pin_ != nullptr) {
+      this->access_policy_.overrides().fill(AccessPolicy<MAX_FINGERPRINT_ID>::USE_DEFAULT);
+      this->access_pref_.save(&this->access_policy_.overrides());
+    }
     this->finger_->getTemplateCount();
     ESP_LOGI(TAG, "Deleted all fingerprints");
     this->publish_last_action("Deleted all fingerprints");
@@ -577,6 +1794,15 @@ bool FingerprintDoorbell::delete_all_fingerprints() {
   return false;
 }
 
+// Removes the template behind `id` from whichever tier holds it
+uint8_t FingerprintDoorbell::delete_template(uint16_t id) {
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  if (this->is_cold_id(id))
+    return this->delete_cold(id);
+#endif
+  return this->finger_->deleteModel(id);
+}
+
 bool FingerprintDoorbell::rename_fingerprint(uint16_t id, const std::string &new_name) {
   std::string old_name = this->get_fingerprint_name(id);
   this->save_fingerprint_name(id, new_name);
@@ -585,180 +1811,231 @@ bool FingerprintDoorbell::rename_fingerprint(uint16_t id, const std::string &new
   return true;
 }
 
+// Erasing many slots takes the sensor longer than one command
+static const uint16_t DELETE_RANGE_TIMEOUT_MS = 2000;
+
+// DeleteChar (0x0C) removes `count` templates starting at `first` in one command
+uint8_t FingerprintDoorbell::delete_range(uint16_t first, uint16_t count) {
+  uint8_t cmd_data[] = {FINGERPRINT_DELETE, (uint8_t) (first >> 8), (uint8_t) (first & 0xFF), (uint8_t) (count >> 8),
+                        (uint8_t) (count & 0xFF)};
+  Adafruit_Fingerprint_Packet reply(FINGERPRINT_ACKPACKET, 0, nullptr);
+  return this->send_command(cmd_data, sizeof(cmd_data), reply, DELETE_RANGE_TIMEOUT_MS);
+}
+
+uint16_t FingerprintDoorbell::delete_fingerprints(const std::vector<uint16_t> &ids) {
+  if (ids.empty()) {
+    this->publish_last_action("Delete failed: no valid IDs");
+    return 0;
+  }
+  if (!this->sensor_connected_ || this->finger_ == nullptr) {
+    this->publish_last_action("Delete failed: no sensor");
+    return 0;
+  }
+  
+  uint16_t deleted = 0;
+  bool access_changed = false;
+  size_t run = 0;
+  while (run < ids.size()) {
+    size_t end = run + 1;
+    // Cold IDs are not sensor slots, so they are deleted one at a time
+    while (end < ids.size() && ids[end] == ids[end - 1] + 1 && this->in_sensor(ids[end]))
+      end++;
+    uint16_t first = ids[run];
+    uint16_t count = end - run;
+    uint8_t result = this->in_sensor(first) ? this->delete_range(first, count) : this->delete_template(first);
+    
+    if (result == FINGERPRINT_OK) {
+      // Names are saved one by one but reach flash in the single sync below;
+      // quality and access overrides are one preference each
+      for (size_t i = run; i < end; i++) {
+        uint16_t id = ids[i];
+        if (this->fingerprint_names_.has(id))
+          this->delete_fingerprint_name(id);
+        this->fingerprint_quality_[id] = 0;
+        if (this->access_policy_.is_overridden(id)) {
+          this->access_policy_.set_override(id, AccessPolicy<MAX_FINGERPRINT_ID>::USE_DEFAULT);
+          access_changed = true;
+        }
+      }
+      deleted += count;
+    } else {
+      ESP_LOGW(TAG, "Deleting IDs %u-%u failed", (unsigned) first, (unsigned) (first + count - 1));
+    }
+    run = end;
+  }
+  
+  if (deleted > 0) {
+    this->quality_pref_.save(&this->fingerprint_quality_);
+    if (access_changed)
+      this->access_pref_.save(&this->access_policy_.overrides());
+    global_preferences->sync();
+    this->finger_->getTemplateCount();
+  }
+  ESP_LOGI(TAG, "Deleted %u of %u fingerprints", (unsigned) deleted, (unsigned) ids.size());
+  this->publish_last_actionf("Deleted %u of %u fingerprints", (unsigned) deleted, (unsigned) ids.size());
+  return deleted;
+}
+
+uint16_t FingerprintDoorbell::rename_fingerprints(const std::vector<std::pair<uint16_t, std::string>> &names,
+                                                  std::vector<uint16_t> *skipped) {
+  if (names.empty()) {
+    this->publish_last_action("Rename failed: no valid names");
+    return 0;
+  }
+  uint16_t renamed = 0;
+  for (const auto &entry : names) {
+    // A name on an empty slot would make it look enrolled
+    if (!this->has_fingerprint(entry.first)) {
+      ESP_LOGW(TAG, "Rename: ID %u is not enrolled, skipped", (unsigned) entry.first);
+      if (skipped != nullptr)
+        skipped->push_back(entry.first);
+      continue;
+    }
+    this->save_fingerprint_name(entry.first, entry.second);
+    renamed++;
+  }
+  if (renamed > 0)
+    global_preferences->sync();
+  ESP_LOGI(TAG, "Renamed %u of %u fingerprints", (unsigned) renamed, (unsigned) names.size());
+  this->publish_last_actionf("Renamed %u of %u fingerprints", (unsigned) renamed, (unsigned) names.size());
+  return renamed;
+}
+
 // ==================== TEMPLATE TRANSFER ====================
+#if defined(USE_FINGERPRINT_DOORBELL_REST) || defined(USE_FINGERPRINT_DOORBELL_TEMPLATE_IO)
 
 // Define FINGERPRINT_DOWNLOAD command (not in Arduino library)
 #define FINGERPRINT_DOWNLOAD 0x09
+static constexpr std::array<CommandFrame<2>, 2> DOWNCHAR_FRAMES = {
+    make_command_frame<2>({FINGERPRINT_DOWNLOAD, 0x01}), make_command_frame<2>({FINGERPRINT_DOWNLOAD, 0x02}),
+};
 
-bool FingerprintDoorbell::get_template(uint16_t id, std::vector<uint8_t> &template_data) {
-  if (!this->sensor_connected_ || this->finger_ == nullptr) {
-    ESP_LOGW(TAG, "Cannot get template: sensor not connected");
-    return false;
+// R503 templates are 1536 bytes, split into packets of the sensor's packet length (32..256)
+static const size_t TEMPLATE_MAX_SIZE = 1536;
+static const uint16_t TEMPLATE_PACKET_MAX = 256;
+static const uint32_t DATA_PACKET_TIMEOUT_MS = 1000;
+// After a failed attempt, let the rest of the aborted transfer arrive before draining it
+static const uint32_t TRANSFER_RETRY_DELAY_MS = 300;
+
+// Reads one data packet of an UpChar transfer. Returns FINGERPRINT_OK, FINGERPRINT_TIMEOUT,
+// or FINGERPRINT_BADPACKET for an impossible length or a checksum mismatch.
+uint8_t FingerprintDoorbell::read_data_packet(uint8_t *data, uint16_t &length, uint8_t &type) {
+  uint32_t start = millis();
+  auto read_byte = [&](uint8_t &byte) -> bool {
+    while (!this->link_.available()) {
+      if (millis() - start >= DATA_PACKET_TIMEOUT_MS)
+        return false;
+      delay(1);
+    }
+    byte = this->link_.read();
+    return true;
+  };
+  
+  // Hunt for the 0xEF01 start code
+  uint8_t previous = 0;
+  uint8_t byte = 0;
+  do {
+    previous = byte;
+    if (!read_byte(byte))
+      return FINGERPRINT_TIMEOUT;
+  } while (previous != 0xEF || byte != 0x01);
+  
+  // 4 (addr) + 1 (type) + 2 (len), where len covers data + 2 checksum bytes
+  uint8_t header[7];
+  for (uint8_t &b : header) {
+    if (!read_byte(b))
+      return FINGERPRINT_TIMEOUT;
   }
+  type = header[4];
+  uint16_t packet_length = (header[5] << 8) | header[6];
+  if (packet_length < 2 || packet_length - 2 > TEMPLATE_PACKET_MAX)
+    return FINGERPRINT_BADPACKET;
+  length = packet_length - 2;
   
-  // Temporarily pause scanning to avoid conflicts
-  Mode previous_mode = this->mode_;
-  this->mode_ = Mode::IDLE;
-  delay(200);  // Give sensor time to settle
+  uint16_t sum = type + header[5] + header[6];
+  for (uint16_t i = 0; i < length; i++) {
+    if (!read_byte(data[i]))
+      return FINGERPRINT_TIMEOUT;
+    sum += data[i];
+  }
   
+  uint8_t checksum_high;
+  uint8_t checksum_low;
+  if (!read_byte(checksum_high) || !read_byte(checksum_low))
+    return FINGERPRINT_TIMEOUT;
+  return ((checksum_high << 8) | checksum_low) == sum ? FINGERPRINT_OK : FINGERPRINT_BADPACKET;
+}
+
+#endif  // USE_FINGERPRINT_DOORBELL_REST || USE_FINGERPRINT_DOORBELL_TEMPLATE_IO
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_IO
+
+uint8_t FingerprintDoorbell::read_template_once(uint16_t id, std::vector<uint8_t> &template_data,
+                                                TransferStats &stats) {
   // Flush any leftover data in serial buffer
-  while (mySerial.available()) {
-    mySerial.read();
-  }
+  this->link_.drain();
   
   // Load template from flash into character buffer
   uint8_t result = this->finger_->loadModel(id);
   if (result != FINGERPRINT_OK) {
     ESP_LOGW(TAG, "Failed to load template %d: error %d", id, result);
-    this->mode_ = previous_mode;
-    return false;
+    return result;
   }
-  
-  ESP_LOGI(TAG, "Template %d loaded, requesting data transfer...", id);
-  
+  return this->read_char_buffer(template_data, stats);
+}
+
+// Reads char buffer 1 back with UpChar
+uint8_t FingerprintDoorbell::read_char_buffer(std::vector<uint8_t> &template_data, TransferStats &stats) {
   // Request template data transfer using UPCHAR command (getModel)
-  result = this->finger_->getModel();
+  uint8_t result = this->finger_->getModel();
   if (result != FINGERPRINT_OK) {
     ESP_LOGW(TAG, "Failed to start template transfer: error %d", result);
-    this->mode_ = previous_mode;
-    return false;
+    return result;
   }
   
-  // R503 template = 1536 bytes, sent in packets
-  // With 128-byte packet data: 1536 / 128 = 12 packets
-  // Each packet: 2 (start) + 4 (addr) + 1 (type) + 2 (len) + 128 (data) + 2 (checksum) = 139 bytes
-  const int PACKET_DATA_SIZE = 128;
-  const int PACKET_OVERHEAD = 11;  // 2+4+1+2+2
-  const int MAX_TEMPLATE_SIZE = 1536;
-  const int MAX_PACKETS = MAX_TEMPLATE_SIZE / PACKET_DATA_SIZE;  // 12
-  
   template_data.clear();
-  template_data.reserve(MAX_TEMPLATE_SIZE);
-  
-  ESP_LOGI(TAG, "Reading template data (expecting up to %d packets)...", MAX_PACKETS);
+  template_data.reserve(TEMPLATE_MAX_SIZE);
   
-  // Read packets by parsing raw serial data
-  uint32_t start_time = millis();
-  const uint32_t TIMEOUT_MS = 10000;
+  uint8_t packet[TEMPLATE_PACKET_MAX];
   int packets_read = 0;
-  bool end_received = false;
-  
-  while (!end_received && packets_read < MAX_PACKETS && (millis() - start_time < TIMEOUT_MS)) {
-    // Wait for packet start code 0xEF01
-    bool found_start = false;
-    uint32_t pkt_start_time = millis();
-    
-    while (!found_start && (millis() - pkt_start_time < 2000)) {
-      if (mySerial.available() >= 2) {
-        uint8_t b1 = mySerial.read();
-        if (b1 == 0xEF) {
-          uint8_t b2 = mySerial.peek();
-          if (b2 == 0x01) {
-            mySerial.read();  // consume 0x01
-            found_start = true;
-          }
-        }
-      }
-    }
-    
-    if (!found_start) {
-      ESP_LOGW(TAG, "Timeout waiting for packet %d start code", packets_read + 1);
-      break;
-    }
-    
-    // Read rest of header: 4 (addr) + 1 (type) + 2 (len) = 7 bytes
-    uint8_t header[7];
-    int header_read = 0;
-    uint32_t header_start = millis();
-    
-    while (header_read < 7 && (millis() - header_start < 1000)) {
-      if (mySerial.available()) {
-        header[header_read++] = mySerial.read();
-      }
-    }
-    
-    if (header_read < 7) {
-      ESP_LOGW(TAG, "Timeout reading packet %d header (got %d bytes)", packets_read + 1, header_read);
-      break;
-    }
-    
-    uint8_t pkt_type = header[4];
-    uint16_t pkt_len = (header[5] << 8) | header[6];  // includes 2-byte checksum
-    uint16_t data_len = (pkt_len > 2) ? (pkt_len - 2) : 0;
-    
-    if (data_len > 256) {
-      ESP_LOGW(TAG, "Invalid packet %d data length: %d", packets_read + 1, data_len);
-      break;
+  while (true) {
+    uint16_t length = 0;
+    uint8_t type = 0;
+    result = this->read_data_packet(packet, length, type);
+    if (result == FINGERPRINT_TIMEOUT) {
+      stats.timeouts++;
+      ESP_LOGW(TAG, "Timeout reading template packet %d", packets_read + 1);
+      return result;
     }
-    
-    // Read data + checksum
-    uint8_t payload[258];  // max 256 data + 2 checksum
-    int payload_read = 0;
-    uint32_t payload_start = millis();
-    
-    while (payload_read < pkt_len && (millis() - payload_start < 1000)) {
-      if (mySerial.available()) {
-        payload[payload_read++] = mySerial.read();
-      }
+    if (result != FINGERPRINT_OK) {
+      stats.checksum_errors++;
+      ESP_LOGW(TAG, "Corrupted template packet %d (bad checksum or length)", packets_read + 1);
+      return result;
     }
-    
-    if (payload_read < pkt_len) {
-      ESP_LOGW(TAG, "Timeout reading packet %d payload (got %d/%d bytes)", 
-               packets_read + 1, payload_read, pkt_len);
-      break;
+    if (template_data.size() + length > TEMPLATE_MAX_SIZE) {
+      ESP_LOGW(TAG, "Template data exceeds %d bytes", (int) TEMPLATE_MAX_SIZE);
+      return FINGERPRINT_BADPACKET;
     }
     
     packets_read++;
-    
-    // Extract data bytes (exclude checksum)
-    for (uint16_t i = 0; i < data_len; i++) {
-      template_data.push_back(payload[i]);
-    }
-    
+    template_data.insert(template_data.end(), packet, packet + length);
     ESP_LOGD(TAG, "Packet %d: type=0x%02X, data_len=%d, total=%d bytes", 
-             packets_read, pkt_type, data_len, (int)template_data.size());
+             packets_read, type, length, (int)template_data.size());
     
-    // Check for end packet
-    if (pkt_type == FINGERPRINT_ENDDATAPACKET) {
-      end_received = true;
-      ESP_LOGD(TAG, "Received end packet");
-    }
-  }
-  
-  ESP_LOGI(TAG, "Downloaded template %d: %d bytes in %d packets", 
-           id, (int)template_data.size(), packets_read);
-  
-  if (template_data.size() < 512) {
-    ESP_LOGW(TAG, "Template too small (%d bytes), expected at least 512", (int)template_data.size());
-    this->mode_ = previous_mode;
-    return false;
-  }
-  
-  this->mode_ = previous_mode;
-  return true;
-}
-
-bool FingerprintDoorbell::upload_template(uint16_t id, const std::string &name, const std::vector<uint8_t> &template_data) {
-  if (!this->sensor_connected_ || this->finger_ == nullptr) {
-    ESP_LOGW(TAG, "Cannot upload template: sensor not connected");
-    return false;
+    if (type == FINGERPRINT_ENDDATAPACKET)
+      break;
   }
   
-  // R503 templates are 1536 bytes, but we also accept 512 bytes (feature file) for compatibility
-  if (template_data.size() != 512 && template_data.size() != 1536) {
-    ESP_LOGW(TAG, "Invalid template size: %d bytes (expected 512 or 1536)", (int)template_data.size());
-    return false;
+  if (template_data.size() < 512) {
+    ESP_LOGW(TAG, "Template too small (%d bytes), expected at least 512", (int)template_data.size());
+    return FINGERPRINT_BADPACKET;
   }
-  
-  // Temporarily pause scanning to avoid conflicts
-  Mode previous_mode = this->mode_;
-  this->mode_ = Mode::IDLE;
-  delay(200);  // Give sensor time to settle
-  
+  return FINGERPRINT_OK;
+}
+
+// Streams a template into char buffer `buffer` (1 or 2) with DownChar
+uint8_t FingerprintDoorbell::send_template(uint8_t buffer, TemplateStream &tmpl, TransferStats &stats) {
   // Flush any leftover data in serial buffer
-  while (mySerial.available()) {
-    mySerial.read();
-  }
+  this->link_.drain();
   
   // Use sensor's configured packet length
   uint16_t packet_len = this->finger_->packet_len;
@@ -766,37 +2043,33 @@ bool FingerprintDoorbell::upload_template(uint16_t id, const std::string &name,
     packet_len = 128;  // Safe default
   }
   
-  ESP_LOGI(TAG, "Uploading template to ID %d (%d bytes, %d-byte packets)", 
-           id, (int)template_data.size(), packet_len);
-  
-
-  
-  // Send DownChar command to start receiving template into buffer 1
-  uint8_t cmd_data[] = {FINGERPRINT_DOWNLOAD, 0x01};  // Buffer 1
-  Adafruit_Fingerprint_Packet cmd_packet(FINGERPRINT_COMMANDPACKET, sizeof(cmd_data), cmd_data);
-  this->finger_->writeStructuredPacket(cmd_packet);
+  // Send DownChar command to start receiving the template
+  const CommandFrame<2> &downchar = DOWNCHAR_FRAMES[buffer == 2 ? 1 : 0];
+  this->link_.write(downchar.data(), downchar.size());
   
   // Wait for acknowledgment
   Adafruit_Fingerprint_Packet ack_packet(FINGERPRINT_ACKPACKET, 0, nullptr);
   if (this->finger_->getStructuredPacket(&ack_packet, 2000) != FINGERPRINT_OK) {
     ESP_LOGW(TAG, "No acknowledgment for DOWNCHAR command");
-    this->mode_ = previous_mode;
-    return false;
+    stats.timeouts++;
+    return FINGERPRINT_TIMEOUT;
   }
   
   if (ack_packet.data[0] != FINGERPRINT_OK) {
     ESP_LOGW(TAG, "DOWNCHAR failed: 0x%02X", ack_packet.data[0]);
-    this->mode_ = previous_mode;
-    return false;
+    return ack_packet.data[0];
   }
   
   ESP_LOGD(TAG, "Sensor ready to receive template data");
   delay(10);
-  while (mySerial.available()) mySerial.read();
+  this->link_.drain();
   
-  // Send template data in packets
-  const uint32_t addr = 0xFFFFFFFF;
-  size_t total_size = template_data.size();
+  // Send template data in packets, each built in one buffer and written at once.
+  // Data is pulled from the stream per packet, so compressed input is never expanded whole.
+  uint8_t chunk[TEMPLATE_PACKET_MAX];
+  uint8_t frame[TEMPLATE_PACKET_MAX + FRAME_OVERHEAD];
+  tmpl.rewind();
+  size_t total_size = tmpl.size();
   size_t written = 0;
   int pkt_num = 0;
   
@@ -808,33 +2081,8 @@ bool FingerprintDoorbell::upload_template(uint16_t id, const std::string &name,
     
     // Packet type: 0x02 for data, 0x08 for final packet
     uint8_t pkt_type = is_last ? FINGERPRINT_ENDDATAPACKET : FINGERPRINT_DATAPACKET;
-    
-    // Length field: data bytes + 2 checksum bytes
-    uint16_t total_len = chunk_size + 2;
-    
-    // Calculate checksum
-    uint16_t checksum = (total_len >> 8) + (total_len & 0xFF) + pkt_type;
-    for (size_t i = 0; i < chunk_size; i++) {
-      checksum += template_data[written + i];
-    }
-    
-    // Write packet header byte-by-byte
-    mySerial.write((uint8_t)(0xEF01 >> 8));
-    mySerial.write((uint8_t)(0xEF01 & 0xFF));
-    mySerial.write((uint8_t)(addr >> 24));
-    mySerial.write((uint8_t)(addr >> 16));
-    mySerial.write((uint8_t)(addr >> 8));
-    mySerial.write((uint8_t)(addr & 0xFF));
-    mySerial.write(pkt_type);
-    mySerial.write((uint8_t)(total_len >> 8));
-    mySerial.write((uint8_t)(total_len & 0xFF));
-    
-    // Write payload data
-    mySerial.write(template_data.data() + written, chunk_size);
-    
-    // Write checksum
-    mySerial.write((uint8_t)(checksum >> 8));
-    mySerial.write((uint8_t)(checksum & 0xFF));
+    tmpl.read(chunk, chunk_size);
+    this->link_.write(frame, build_frame(pkt_type, chunk, chunk_size, frame));
     
     ESP_LOGD(TAG, "PKT%d: type=0x%02X, len=%d, total_written=%d", 
              pkt_num, pkt_type, (int)chunk_size, (int)(written + chunk_size));
@@ -843,20 +2091,60 @@ bool FingerprintDoorbell::upload_template(uint16_t id, const std::string &name,
     delay(1);  // Small yield between packets
   }
   
-  ESP_LOGI(TAG, "Sent all %d packets (%d bytes total)", pkt_num, (int)written);
+  ESP_LOGD(TAG, "Sent all %d packets (%d bytes total)", pkt_num, (int)written);
   
   delay(100);
-  while (mySerial.available()) mySerial.read();
+  this->link_.drain();
+  return FINGERPRINT_OK;
+}
+
+// True if the meaningful part of the decoded template equals `stored`. Sensors may fill
+// the trailing padding differently, so only tmpl.content_size() bytes are compared.
+static bool template_matches(TemplateStream &tmpl, const std::vector<uint8_t> &stored) {
+  size_t content = tmpl.content_size();
+  if (stored.size() < content)
+    return false;
+  uint8_t chunk[64];
+  size_t offset = 0;
+  tmpl.rewind();
+  while (offset < content) {
+    size_t count = tmpl.read(chunk, std::min(sizeof(chunk), content - offset));
+    if (count == 0 || memcmp(chunk, stored.data() + offset, count) != 0)
+      return false;
+    offset += count;
+  }
+  return true;
+}
+
+uint8_t FingerprintDoorbell::write_template_once(uint16_t id, TemplateStream &tmpl, TransferStats &stats) {
+  ESP_LOGI(TAG, "Uploading template to ID %d (%d bytes)", id, (int)tmpl.size());
+  uint8_t result = this->send_template(1, tmpl, stats);
+  if (result != FINGERPRINT_OK)
+    return result;
+  
+  // Read the buffer back before it replaces the slot's template; DownChar data packets
+  // are never acked, so this is the only way to notice one the sensor took in corrupted
+  if (this->template_verify_upload_) {
+    std::vector<uint8_t> buffer_data;
+    result = this->read_char_buffer(buffer_data, stats);
+    if (result == FINGERPRINT_OK && !template_matches(tmpl, buffer_data)) {
+      ESP_LOGW(TAG, "Read-back of template %d does not match the uploaded data", id);
+      stats.verify_mismatches++;
+      result = FINGERPRINT_BADPACKET;
+    }
+    stats.verified = result == FINGERPRINT_OK;
+    if (result != FINGERPRINT_OK)
+      return result;
+  }
   
   // Delete any existing template at this ID
   this->finger_->deleteModel(id);
 
   delay(100);
-  while (mySerial.available()) mySerial.read();
+  this->link_.drain();
   
   // Store the template to flash
-  uint8_t result = this->finger_->storeModel(id);
-
+  result = this->finger_->storeModel(id);
   
   if (result != FINGERPRINT_OK) {
     const char* error_desc = "unknown";
@@ -869,30 +2157,725 @@ bool FingerprintDoorbell::upload_template(uint16_t id, const std::string &name,
       case 0x18: error_desc = "FLASHERR"; break;
     }
     ESP_LOGW(TAG, "Failed to store template at ID %d: error 0x%02X (%s)", id, result, error_desc);
-    this->mode_ = previous_mode;
+  }
+  return result;
+}
+
+#endif  // USE_FINGERPRINT_DOORBELL_TEMPLATE_IO
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
+
+// Failures a fresh attempt can fix, as opposed to sensor answers like "empty slot"
+static bool is_link_error(uint8_t result) {
+  return result == FINGERPRINT_PACKETRECIEVEERR || result == FINGERPRINT_TIMEOUT || result == FINGERPRINT_BADPACKET;
+}
+
+bool FingerprintDoorbell::get_template(uint16_t id, std::vector<uint8_t> &template_data, TransferStats &stats) {
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  // Cold templates come from flash, without the sensor
+  if (this->is_cold_id(id)) {
+    uint16_t length = 0;
+    stats.attempts = 1;
+    if (!this->cold_.load(id, this->cold_buffer_.data(), length)) {
+      ESP_LOGW(TAG, "No template for ID %d in cold storage", id);
+      template_data.clear();
+      return false;
+    }
+    template_data.assign(this->cold_buffer_.begin(), this->cold_buffer_.begin() + length);
+    ESP_LOGI(TAG, "Read template %d from cold storage: %d bytes", id, (int) length);
+    return true;
+  }
+#endif
+  
+  if (!this->sensor_connected_ || this->finger_ == nullptr) {
+    ESP_LOGW(TAG, "Cannot get template: sensor not connected");
+    return false;
+  }
+  
+  uint8_t result = FINGERPRINT_PACKETRECIEVEERR;
+  while (stats.attempts <= this->template_transfer_retries_) {
+    stats.attempts++;
+    result = this->read_template_once(id, template_data, stats);
+    if (!is_link_error(result))
+      break;
+    ESP_LOGW(TAG, "Template %d export attempt %d failed", id, stats.attempts);
+    delay(TRANSFER_RETRY_DELAY_MS);
+  }
+  
+  if (result != FINGERPRINT_OK) {
+    template_data.clear();
+    return false;
+  }
+  ESP_LOGI(TAG, "Downloaded template %d: %d bytes (attempt %d)", id, (int)template_data.size(), stats.attempts);
+  return true;
+}
+
+bool FingerprintDoorbell::upload_template(uint16_t id, const std::string &name, TemplateStream &tmpl,
+                                          TransferStats &stats) {
+  if (!this->sensor_connected_ || this->finger_ == nullptr) {
+    ESP_LOGW(TAG, "Cannot upload template: sensor not connected");
+    return false;
+  }
+  
+  // R503 templates are 1536 bytes, but we also accept 512 bytes (feature file) for compatibility
+  if (tmpl.size() != 512 && tmpl.size() != 1536) {
+    ESP_LOGW(TAG, "Invalid template size: %d bytes (expected 512 or 1536)", (int)tmpl.size());
     return false;
   }
   
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  // Cold templates go to flash; a cached copy on the sensor would be stale
+  if (this->is_cold_id(id)) {
+    stats.attempts = 1;
+    tmpl.rewind();
+    size_t length = tmpl.read(this->cold_buffer_.data(), tmpl.size());
+    int index = this->find_cache(id);
+    if (index >= 0) {
+      this->finger_->deleteModel(this->cache_slot(index));
+      this->uncache(index);
+      this->save_cache_map();
+    }
+    if (!this->cold_.store(id, this->cold_buffer_.data(), length)) {
+      ESP_LOGW(TAG, "Failed to store template %d in cold storage", id);
+      return false;
+    }
+    this->save_fingerprint_name(id, name);
+    this->save_fingerprint_quality(id, 0);
+    ESP_LOGI(TAG, "Template stored in cold storage at ID %d with name '%s'", id, name.c_str());
+    this->publish_last_action("Imported: " + name + " (ID " + std::to_string(id) + ")");
+    return true;
+  }
+#endif
+  
+  // A failed attempt never reaches storeModel(), so the slot keeps its old template
+  uint8_t result = FINGERPRINT_PACKETRECIEVEERR;
+  while (stats.attempts <= this->template_transfer_retries_) {
+    stats.attempts++;
+    result = this->write_template_once(id, tmpl, stats);
+    if (!is_link_error(result))
+      break;
+    ESP_LOGW(TAG, "Template %d import attempt %d failed", id, stats.attempts);
+    delay(TRANSFER_RETRY_DELAY_MS);
+  }
+  
+  if (result != FINGERPRINT_OK)
+    return false;
+  
   // Save the name
   this->save_fingerprint_name(id, name);
+  this->save_fingerprint_quality(id, 0);  // Imported templates were not verified here
   this->finger_->getTemplateCount();
   
-  ESP_LOGI(TAG, "Template uploaded and stored at ID %d with name '%s'", id, name.c_str());
+  ESP_LOGI(TAG, "Template uploaded and stored at ID %d with name '%s' (attempt %d%s)", id, name.c_str(),
+           stats.attempts, stats.verified ? ", verified" : "");
   this->publish_last_action("Imported: " + name + " (ID " + std::to_string(id) + ")");
+  return true;
+}
+
+#endif  // USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
+
+// ==================== TIERED STORAGE ====================
+// With cold_storage_partition, IDs above hot_slots live in a flash partition instead of
+// the sensor's library. The library search covers hot IDs and a small promotion cache
+// of recently matched cold templates; when it misses, search_cold() streams a bounded
+// number of cold templates into char buffer 2 and matches each 1:1 against the capture.
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+
+// millis() for "last matched" stamps, where 0 means never
+static uint32_t match_stamp() {
+  uint32_t now = millis();
+  return now != 0 ? now : 1;
+}
+
+void FingerprintDoorbell::setup_tiers() {
+  if (this->cold_partition_.empty())
+    return;
+  if (!this->cold_.init(this->cold_partition_.c_str(), this->hot_slots_ + 1, MAX_FINGERPRINT_ID)) {
+    ESP_LOGE(TAG, "Tiered storage disabled, IDs above %u cannot be enrolled", this->hot_slots_);
+    return;
+  }
+  this->cold_buffer_.resize(ColdStore::MAX_TEMPLATE_SIZE);
+  this->cold_last_match_.assign(MAX_FINGERPRINT_ID - this->hot_slots_, 0);
+  
+  // The map only means something for the slot layout it was written with
+  this->cache_pref_ = global_preferences->make_preference<CacheMap>(this->pref_hash("fp_cache"));
+  CacheMap map{};
+  this->cache_ids_.fill(0);
+  if (this->cache_pref_.load(&map)) {
+    this->saved_cache_first_ = map.hot_slots + 1;
+    this->saved_cache_last_ = map.hot_slots + map.cache_slots;
+    if (map.hot_slots == this->hot_slots_) {
+      this->cache_ids_ = map.ids;
+    } else {
+      ESP_LOGW(TAG, "hot_slots changed from %u to %u, the promotion cache starts over", map.hot_slots,
+               this->hot_slots_);
+    }
+  }
+  for (uint8_t i = 0; i < MAX_CACHE_SLOTS; i++) {
+    if (i >= this->cache_slots_ || !this->cold_.has(this->cache_ids_[i]))
+      this->cache_ids_[i] = 0;
+  }
+}
+
+// Runs on the first connect: fits the cache into the sensor's library and moves
+// templates to where the current hot_slots puts them. Sensor templates above hot_slots
+// (enrolled before tiering, or with a larger hot_slots) go to cold storage; cold records
+// below it (written with a smaller hot_slots) go to the sensor. Slow only when there is
+// something to move.
+void FingerprintDoorbell::check_tiers(uint16_t capacity) {
+  if (this->tiers_checked_)
+    return;
+  if (this->hot_slots_ + 1 >= capacity) {
+    ESP_LOGE(TAG, "hot_slots %u leaves no cache slot in a %u-template sensor", this->hot_slots_, capacity);
+    this->cache_slots_ = 0;
+  } else if (this->hot_slots_ + this->cache_slots_ >= capacity) {
+    this->cache_slots_ = capacity - this->hot_slots_ - 1;
+    ESP_LOGW(TAG, "Sensor holds %u templates, promotion cache shrunk to %u slots", capacity, this->cache_slots_);
+  }
+  
+  std::vector<bool> occupied;
+  if (!this->read_index_table(occupied, capacity - 1)) {
+    ESP_LOGW(TAG, "Could not read the sensor's index table, tier check postponed");
+    return;
+  }
+  
+  // A mapped slot must hold its cold template: the map and the slot are written one
+  // after the other, so a reset in between leaves them apart
+  std::vector<uint8_t> data;
+  for (uint8_t i = 0; i < MAX_CACHE_SLOTS; i++) {
+    if (this->cache_ids_[i] == 0)
+      continue;
+    if (i >= this->cache_slots_ || !occupied[this->cache_slot(i)]) {
+      this->uncache(i);
+      continue;
+    }
+    App.feed_wdt();
+    TransferStats stats;
+    uint16_t length = 0;
+    if (this->read_template_once(this->cache_slot(i), data, stats) == FINGERPRINT_OK &&
+        this->cold_.load(this->cache_ids_[i], this->cold_buffer_.data(), length)) {
+      TemplateStream tmpl(this->cold_buffer_.data(), length, TemplateEncoding::RAW);
+      if (template_matches(tmpl, data))
+        continue;
+    }
+    ESP_LOGW(TAG, "Sensor slot %u does not hold cold template %u, dropped from the cache", this->cache_slot(i),
+             this->cache_ids_[i]);
+    this->uncache(i);
+    this->finger_->deleteModel(this->cache_slot(i));
+    occupied[this->cache_slot(i)] = false;
+  }
+  
+  // An unmapped template in what was a cache slot when the map was saved is a copy of
+  // some other cold ID (or a promotion cut short), never the template of ID `slot`.
+  // A raised hot_slots turns such slots into hot ones: their copies go, and the cold
+  // records below hot_slots take their place.
+  uint16_t dropped = 0;
+  uint16_t last_copy = std::min(this->saved_cache_last_, this->hot_slots_);
+  for (uint16_t slot = std::max<uint16_t>(this->saved_cache_first_, 1); slot <= last_copy; slot++) {
+    if (occupied[slot] && this->finger_->deleteModel(slot) == FINGERPRINT_OK)
+      dropped++;
+  }
+  uint16_t restored = 0;
+  this->cold_.for_each_stranded([this, &restored](uint16_t id) {
+    App.feed_wdt();
+    uint8_t result = this->load_cold(id, 1);
+    if (result == FINGERPRINT_OK)
+      result = this->finger_->storeModel(id, 1);
+    if (result != FINGERPRINT_OK || !this->cold_.erase(id)) {
+      ESP_LOGW(TAG, "Could not move template %u back to the sensor: %d", id, result);
+      return;
+    }
+    restored++;
+  });
+  if (restored > 0)
+    ESP_LOGI(TAG, "Moved %u templates from cold storage to the sensor", restored);
+  
+  uint16_t moved = 0;
+  for (uint16_t slot = this->hot_slots_ + 1; slot < capacity; slot++) {
+    int index = slot - this->hot_slots_ - 1;
+    if (!occupied[slot] || (index < this->cache_slots_ && this->cache_ids_[index] != 0))
+      continue;
+    App.feed_wdt();
+    bool cache_copy = slot >= this->saved_cache_first_ && slot <= this->saved_cache_last_;
+    if (!cache_copy && !this->cold_.has(slot)) {
+      if (slot > MAX_FINGERPRINT_ID || !this->cold_.fits(slot) || !this->has_fingerprint(slot)) {
+        ESP_LOGW(TAG, "Template in sensor slot %u has no enrolled cold storage ID, left in place", slot);
+        continue;
+      }
+      if (!this->persist_cold(slot, slot)) {
+        ESP_LOGW(TAG, "Could not move template %u to cold storage, left in place", slot);
+        continue;
+      }
+      moved++;
+      if (index < this->cache_slots_)
+        continue;  // persist_cold() kept it as the slot's cached copy
+    }
+    // The cold copy is authoritative; an unmapped sensor copy is never used
+    this->finger_->deleteModel(slot);
+    dropped++;
+  }
+  
+  // Map changes are held back until here, so the saved layout stays the old one until
+  // every slot has been sorted out
+  this->tiers_checked_ = true;
+  this->save_cache_map();
+  if (moved > 0)
+    ESP_LOGI(TAG, "Moved %u templates to cold storage", moved);
+  if (dropped > 0)
+    ESP_LOGI(TAG, "Deleted %u stale sensor copies of cold templates", dropped);
+  if (moved > 0 || dropped > 0 || restored > 0)
+    this->finger_->getTemplateCount();
+}
+
+int FingerprintDoorbell::find_cache(uint16_t id) const {
+  for (uint8_t i = 0; i < this->cache_slots_; i++) {
+    if (this->cache_ids_[i] == id)
+      return i;
+  }
+  return -1;
+}
+
+// Frees a cache slot for `id`: the one holding it already, else an empty one, else the
+// least recently matched. The slot is unmapped until assign_cache(), so a template
+// being overwritten is never reported under the wrong ID. -1 without cache slots.
+int FingerprintDoorbell::release_cache_slot(uint16_t id) {
+  int victim = this->find_cache(id);
+  if (victim < 0)
+    victim = this->find_cache(0);
+  if (victim < 0 && this->cache_slots_ > 0) {
+    uint32_t now = millis();
+    uint32_t oldest = 0;
+    for (uint8_t i = 0; i < this->cache_slots_; i++) {
+      uint32_t age = this->cache_last_match_[i] == 0 ? UINT32_MAX : now - this->cache_last_match_[i];
+      if (victim < 0 || age > oldest) {
+        victim = i;
+        oldest = age;
+      }
+    }
+  }
+  if (victim >= 0 && this->cache_ids_[victim] != 0) {
+    this->uncache(victim);
+    this->save_cache_map();
+  }
+  return victim;
+}
+
+void FingerprintDoorbell::assign_cache(int index, uint16_t id) {
+  this->cache_ids_[index] = id;
+  this->cache_last_match_[index] = match_stamp();
+}
+
+void FingerprintDoorbell::uncache(int index) {
+  this->cache_ids_[index] = 0;
+  this->cache_last_match_[index] = 0;
+}
+
+// Committed right away: a map that lags the sensor's slots after a reset would report
+// a cached template under the wrong ID
+void FingerprintDoorbell::save_cache_map() {
+  if (!this->tiers_checked_)
+    return;
+  CacheMap map{this->hot_slots_, this->cache_slots_, this->cache_ids_};
+  this->cache_pref_.save(&map);
+  global_preferences->sync();
+}
+
+// ID for a sensor slot the library search returned; 0 for a cache slot that maps to nothing
+uint16_t FingerprintDoorbell::resolve_slot(uint16_t slot) {
+  if (!this->is_cold_id(slot)) {
+    this->tier_stats_.sensor_hits++;
+    return slot;
+  }
+  int index = slot - this->hot_slots_ - 1;
+  if (index >= this->cache_slots_ || this->cache_ids_[index] == 0) {
+    ESP_LOGW(TAG, "Match in unmapped sensor slot %u ignored", slot);
+    return 0;
+  }
+  uint16_t id = this->cache_ids_[index];
+  this->cache_last_match_[index] = match_stamp();
+  this->cold_last_match_[id - this->cold_.first_id()] = this->cache_last_match_[index];
+  this->tier_stats_.cache_hits++;
+  return id;
+}
+
+// Fills up to cold_search_max_ stored, uncached cold IDs: the most recently matched
+// first (at most half), then the others in turn from a cursor that moves on with every
+// touch, so someone never matched before is reached after a few touches at worst.
+// `eligible` is how many IDs could have been picked.
+uint8_t FingerprintDoorbell::pick_cold_candidates(uint16_t *candidates, uint16_t &eligible) {
+  uint8_t limit = this->cold_search_max_;
+  uint8_t recent_limit = (limit + 1) / 2;
+  uint8_t count = 0;
+  eligible = 0;
+  uint16_t first = this->cold_.first_id();
+  uint16_t total = this->cold_last_match_.size();
+  
+  // Insertion into a short list sorted newest first
+  uint32_t now = millis();
+  for (uint16_t i = 0; i < total; i++) {
+    uint16_t id = first + i;
+    if (!this->cold_.has(id) || this->find_cache(id) >= 0)
+      continue;
+    eligible++;
+    uint32_t last = this->cold_last_match_[i];
+    if (last == 0)
+      continue;
+    uint8_t pos = count;
+    while (pos > 0 && now - this->cold_last_match_[candidates[pos - 1] - first] > now - last)
+      pos--;
+    if (pos >= recent_limit)
+      continue;
+    if (count < recent_limit)
+      count++;
+    for (uint8_t j = count - 1; j > pos; j--)
+      candidates[j] = candidates[j - 1];
+    candidates[pos] = id;
+  }
+  
+  for (uint16_t step = 0; step < total && count < limit; step++) {
+    uint16_t i = (this->cold_cursor_ + step) % total;
+    uint16_t id = first + i;
+    if (!this->cold_.has(id) || this->find_cache(id) >= 0 ||
+        std::find(candidates, candidates + count, id) != candidates + count)
+      continue;
+    candidates[count++] = id;
+    this->cold_cursor_ = (i + 1) % total;
+  }
+  return count;
+}
+
+// Matches the capture in char buffer 1 against cold templates; a hit is promoted into
+// the cache so the library search finds it next time. Bounded by cold_search_max
+// candidates and cold_search_budget, whichever ends first.
+bool FingerprintDoorbell::search_cold(Match &match) {
+  if (!this->cold_.enabled() || this->cold_.size() == 0)
+    return false;
+  uint32_t start = micros();
+  uint32_t start_ms = millis();
+  TierStats &stats = this->tier_stats_;
+  
+  uint16_t candidates[MAX_COLD_CANDIDATES];
+  uint16_t eligible = 0;
+  uint8_t count = this->pick_cold_candidates(candidates, eligible);
+  uint8_t tried = 0;
+  uint16_t hit = 0;
+  uint16_t score = 0;
+  for (; tried < count; tried++) {
+    if (tried > 0 && millis() - start_ms >= this->cold_search_budget_ms_)
+      break;
+    App.feed_wdt();
+    stats.cold_candidates++;
+    uint8_t result = this->load_cold(candidates[tried], 2);
+    if (result == FINGERPRINT_OK)
+      result = this->match_char_buffers(score);
+    if (result == FINGERPRINT_OK) {
+      hit = candidates[tried++];
+      break;
+    }
+    if (result != FINGERPRINT_NOMATCH) {
+      stats.cold_errors++;
+      if (!this->sensor_connected_)
+        break;
+    }
+  }
+  if (hit == 0 && tried < eligible)
+    stats.budget_exhausted++;
+  
+  if (hit != 0) {
+    stats.cold_hits++;
+    this->cold_last_match_[hit - this->cold_.first_id()] = match_stamp();
+    match.match_id = hit;
+    match.match_confidence = score;
+    
+    // Buffer 2 still holds the matched template
+    int index = this->release_cache_slot(hit);
+    if (index >= 0) {
+      if (this->finger_->storeModel(this->cache_slot(index), 2) == FINGERPRINT_OK) {
+        this->assign_cache(index, hit);
+        this->save_cache_map();
+        stats.promotions++;
+      } else {
+        ESP_LOGW(TAG, "Promoting template %u into sensor slot %u failed", hit, this->cache_slot(index));
+      }
+    }
+  } else {
+    stats.cold_misses++;
+  }
   
-  this->mode_ = previous_mode;
+  uint32_t elapsed = micros() - start;
+  stats.fallback_count++;
+  stats.fallback_us += elapsed;
+  if (elapsed > stats.fallback_max_us)
+    stats.fallback_max_us = elapsed;
+  ESP_LOGD(TAG, "Cold search: %u of %u templates in %u ms, %s", tried, eligible, (unsigned) (elapsed / 1000),
+           hit != 0 ? "match" : "no match");
+  return hit != 0;
+}
+
+// Streams cold template `id` into char buffer `buffer`
+uint8_t FingerprintDoorbell::load_cold(uint16_t id, uint8_t buffer) {
+  uint16_t length = 0;
+  if (!this->cold_.load(id, this->cold_buffer_.data(), length))
+    return FINGERPRINT_DBREADFAIL;
+  TemplateStream tmpl(this->cold_buffer_.data(), length, TemplateEncoding::RAW);
+  TransferStats stats;
+  return this->send_template(buffer, tmpl, stats);
+}
+
+uint8_t FingerprintDoorbell::delete_cold(uint16_t id) {
+  int index = this->find_cache(id);
+  if (index >= 0) {
+    uint8_t result = this->finger_->deleteModel(this->cache_slot(index));
+    if (result != FINGERPRINT_OK)
+      return result;
+    this->uncache(index);
+    this->save_cache_map();
+  }
+  if (!this->cold_.erase(id))
+    return FINGERPRINT_FLASHERR;
+  if (this->cold_.fits(id))
+    this->cold_last_match_[id - this->cold_.first_id()] = 0;
+  return FINGERPRINT_OK;
+}
+
+// Copies the template in sensor slot `slot` to cold storage as `id`. A slot inside the
+// cache keeps it as the cached copy.
+bool FingerprintDoorbell::persist_cold(uint16_t id, uint16_t slot) {
+  std::vector<uint8_t> data;
+  TransferStats stats;
+  uint8_t result = this->read_template_once(slot, data, stats);
+  if (result != FINGERPRINT_OK) {
+    delay(300);
+    result = this->read_template_once(slot, data, stats);
+  }
+  if (result != FINGERPRINT_OK || !this->cold_.store(id, data.data(), data.size()))
+    return false;
+  
+  int index = slot - this->hot_slots_ - 1;
+  if (slot > this->hot_slots_ && index < this->cache_slots_) {
+    this->assign_cache(index, id);
+    this->save_cache_map();
+  }
+  return true;
+}
+
+#endif  // USE_FINGERPRINT_DOORBELL_TIERED
+
+// ==================== JOBS ====================
+#ifdef USE_FINGERPRINT_DOORBELL_REST
+
+uint32_t JobQueue::submit(Job &&job) {
+  LockGuard guard(this->lock_);
+  // A free slot, else the oldest finished job
+  Job *slot = nullptr;
+  for (Job &candidate : this->jobs_) {
+    if (candidate.id == 0) {
+      slot = &candidate;
+      break;
+    }
+    bool finished = candidate.state == JobState::DONE || candidate.state == JobState::FAILED;
+    if (finished && (slot == nullptr || candidate.id < slot->id))
+      slot = &candidate;
+  }
+  if (slot == nullptr)
+    return 0;
+  
+  *slot = std::move(job);
+  slot->id = this->next_id_++;
+  slot->state = JobState::QUEUED;
+  return slot->id;
+}
+
+Job *JobQueue::claim(bool cancel_only) {
+  LockGuard guard(this->lock_);
+  Job *next = nullptr;
+  for (Job &job : this->jobs_) {
+    if (cancel_only && job.type != JobType::CANCEL_ENROLL)
+      continue;
+    if (job.id != 0 && job.state == JobState::QUEUED && (next == nullptr || job.id < next->id))
+      next = &job;
+  }
+  if (next != nullptr)
+    next->state = JobState::RUNNING;
+  return next;
+}
+
+void JobQueue::complete(Job *job, bool success) {
+  LockGuard guard(this->lock_);
+  job->state = success ? JobState::DONE : JobState::FAILED;
+}
+
+// Runs at most one queued job; true if one ran. An image capture without a finger yet
+// stays RUNNING and is polled again on the next call, so it never blocks loop().
+bool FingerprintDoorbell::process_jobs(bool cancel_only) {
+  Job *job = cancel_only ? nullptr : this->waiting_job_;
+  if (job == nullptr) {
+    job = this->jobs_.claim(cancel_only);
+    if (job == nullptr)
+      return false;
+    if (job->type == JobType::IMAGE_CAPTURE)
+      this->capture_deadline_ = millis() + job->wait_ms;
+  }
+  
+  TraceScope trace(&this->trace_, "job");
+  ESP_LOGD(TAG, "Running job %u (type %d)", (unsigned) job->id, (int) job->type);
+  bool success = false;
+  switch (job->type) {
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
+    case JobType::TEMPLATE_EXPORT: {
+      std::vector<uint8_t> data;
+      success = this->get_template(job->slot, data, job->stats);
+      if (success && job->encoding == TemplateEncoding::PACKBITS)
+        data = packbits_encode(data.data(), data.size());
+      job->data = std::move(data);
+      job->name = this->get_fingerprint_name(job->slot);
+      break;
+    }
+    case JobType::TEMPLATE_IMPORT: {
+      TemplateStream tmpl(job->data.data(), job->data.size(), job->encoding);
+      success = this->upload_template(job->slot, job->name, tmpl, job->stats);
+      // The upload data is not part of the result
+      job->data.clear();
+      job->data.shrink_to_fit();
+      break;
+    }
+#endif
+    case JobType::DELETE:
+      success = this->delete_fingerprint(job->slot);
+      break;
+    case JobType::DELETE_ALL:
+      success = this->delete_all_fingerprints();
+      break;
+    case JobType::ENROLL:
+      success = this->start_enrollment(job->slot, job->name);
+      break;
+    case JobType::CANCEL_ENROLL:
+      this->cancel_enrollment();
+      success = true;
+      break;
+    case JobType::UNPAIR:
+      success = this->unpair_sensor();
+      break;
+    case JobType::PAIR:
+      success = this->pair_sensor(job->password);
+      job->password = 0;
+      break;
+    case JobType::ENROLL_SESSION:
+      // Reads the index table, so it runs here rather than on the web server task
+      success = this->start_enrollment_session(job->names);
+      break;
+    case JobType::VERIFY:
+      // publish_match() drives the unlock output and the entities, so it runs here
+      success = this->verify_fingerprint(job->slot);
+      job->verify = this->last_verify_;
+      break;
+    case JobType::DELETE_BATCH:
+      job->count = this->delete_fingerprints(job->ids);
+      success = job->count == job->ids.size();
+      break;
+    case JobType::RENAME_BATCH:
+      job->count = this->rename_fingerprints(job->renames, &job->ids);
+      job->renames.clear();
+      job->renames.shrink_to_fit();
+      success = job->count > 0;
+      break;
+    case JobType::IMAGE_CAPTURE:
+      job->code = this->capture_image(job->stream, job->bytes);
+      if (job->code == FINGERPRINT_NOFINGER && this->sensor_connected_ && this->image_stream_.attached(job->stream) &&
+          (int32_t) (millis() - this->capture_deadline_) < 0) {
+        this->waiting_job_ = job;
+        return true;
+      }
+      this->waiting_job_ = nullptr;
+      this->image_stream_.finish(job->stream, job->code);
+      success = job->code == FINGERPRINT_OK;
+      break;
+    default:  // Template jobs in a build without template transfer
+      break;
+  }
+  this->jobs_.complete(job, success);
   return true;
 }
 
+#endif  // USE_FINGERPRINT_DOORBELL_REST
+
+// ==================== IMAGE CAPTURE ====================
+#ifdef USE_FINGERPRINT_DOORBELL_REST
+
+// UpImage command (not in Arduino library): sends the image buffer as data packets
+#define FINGERPRINT_UPIMAGE 0x0A
+static constexpr auto UPIMAGE_FRAME = make_command_frame<1>({FINGERPRINT_UPIMAGE});
+// A packet takes about 25 ms to arrive; waiting longer for a slow client would let the
+// UART's receive buffer overflow
+static const uint32_t IMAGE_PUT_TIMEOUT_MS = 100;
+
+// Runs as a job on the loop task, which owns the sensor. Each UpImage packet is handed
+// to the web server task as soon as it is read, so only a packet or two is in RAM.
+uint8_t FingerprintDoorbell::capture_image(uint32_t ticket, uint32_t &bytes) {
+  bytes = 0;
+  // The request gave up while the job was queued or waiting for a finger
+  if (!this->image_stream_.attached(ticket))
+    return FINGERPRINT_UPLOADFAIL;
+  
+  uint8_t result = this->get_image();
+  if (result != FINGERPRINT_OK)
+    return result;
+  
+  this->link_.drain();
+  Adafruit_Fingerprint_Packet reply(FINGERPRINT_ACKPACKET, 0, nullptr);
+  result = this->send_frame(UPIMAGE_FRAME, reply);
+  
+  // The whole upload is read even once the request is gone, so no stale packets are
+  // left in the UART
+  uint8_t packet[TEMPLATE_PACKET_MAX];
+  bool streaming = true;
+  while (result == FINGERPRINT_OK) {
+    uint16_t length = 0;
+    uint8_t type = 0;
+    result = this->read_data_packet(packet, length, type);
+    if (result != FINGERPRINT_OK) {
+      ESP_LOGW(TAG, "Image upload failed after %u bytes: %d", (unsigned) bytes, result);
+      break;
+    }
+    bytes += length;
+    if (streaming)
+      streaming = this->image_stream_.put(ticket, packet, length, IMAGE_PUT_TIMEOUT_MS);
+    if (type == FINGERPRINT_ENDDATAPACKET)
+      break;
+  }
+  if (result != FINGERPRINT_OK)
+    return result;
+  if (!streaming) {
+    ESP_LOGW(TAG, "Image request stopped reading after %u bytes", (unsigned) bytes);
+    return FINGERPRINT_UPLOADFAIL;
+  }
+  ESP_LOGI(TAG, "Streamed fingerprint image: %u bytes", (unsigned) bytes);
+  return FINGERPRINT_OK;
+}
+
+#endif  // USE_FINGERPRINT_DOORBELL_REST
+
 // ==================== UTILITIES ====================
 
 uint16_t FingerprintDoorbell::get_enrolled_count() {
-  return this->finger_ != nullptr ? this->finger_->templateCount : 0;
+  if (this->finger_ == nullptr)
+    return 0;
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  // Cached templates are copies of cold ones
+  if (this->cold_.enabled()) {
+    uint16_t cached = 0;
+    for (uint8_t i = 0; i < this->cache_slots_; i++) {
+      if (this->cache_ids_[i] != 0)
+        cached++;
+    }
+    return this->finger_->templateCount - std::min(cached, this->finger_->templateCount) + this->cold_.size();
+  }
+#endif
+  return this->finger_->templateCount;
 }
 
 std::string FingerprintDoorbell::get_fingerprint_name(uint16_t id) {
-  auto it = this->fingerprint_names_.find(id);
-  return (it != this->fingerprint_names_.end()) ? it->second : "unknown";
+  const char *name = this->fingerprint_names_.get(id);
+  return name != nullptr ? name : "unknown";
 }
 
 std::string FingerprintDoorbell::get_fingerprint_list_json() {
@@ -904,14 +2887,204 @@ std::string FingerprintDoorbell::get_fingerprint_list_json() {
   }
   
   // Use cached fingerprint names instead of scanning all slots
-  for (const auto& pair : this->fingerprint_names_) {
-    if (!first) json += ",";
-    json += "{\"id\":" + std::to_string(pair.first) + ",\"name\":\"" + pair.second + "\"}";
+  json.reserve(2 + this->fingerprint_names_.size() * 64);
+  this->fingerprint_names_.for_each([this, &json, &first](uint16_t id, const char *name) {
+    json += first ? "{\"id\":" : ",{\"id\":";
+    json += std::to_string(id) + ",\"name\":\"" + json_escape(name) + "\",\"quality\":" +
+            std::to_string(this->get_fingerprint_quality(id)) + "}";
     first = false;
+  });
+  
+  json += "]";
+  return json;
+}
+
+void FingerprintDoorbell::encode_fingerprint_list(CborWriter &writer) {
+  if (this->finger_ == nullptr || !this->sensor_connected_) {
+    writer.begin_array(0);
+    return;
+  }
+  
+  writer.begin_array(this->fingerprint_names_.size());
+  this->fingerprint_names_.for_each([this, &writer](uint16_t id, const char *name) {
+    writer.begin_map(3);
+    writer.add_text("id");
+    writer.add_uint(id);
+    writer.add_text("name");
+    writer.add_text(name);
+    writer.add_text("quality");
+    writer.add_uint(this->get_fingerprint_quality(id));
+  });
+}
+
+// ==================== METRICS ====================
+
+// Prometheus label for a command byte; unknown commands are shown as hex in `fallback`
+static const char *command_label(uint8_t command, char (&fallback)[8]) {
+  const char *name = SensorLink::command_name(command);
+  if (name != nullptr)
+    return name;
+  snprintf(fallback, sizeof(fallback), "0x%02X", command);
+  return fallback;
+}
+
+static void append_metric(std::string &out, const char *name, const char *type, const char *help, double value) {
+  char buf[192];
+  snprintf(buf, sizeof(buf), "# HELP %s %s\n# TYPE %s %s\n%s %.10g\n", name, help, name, type, name, value);
+  out += buf;
+}
+
+std::string FingerprintDoorbell::get_metrics_prometheus() {
+  std::string out;
+  out.reserve(4096);
+  const SensorLink &link = this->link_;
+  
+  append_metric(out, "fingerprint_sensor_connected", "gauge", "1 if the sensor link is up",
+                this->sensor_connected_ ? 1 : 0);
+  append_metric(out, "fingerprint_link_down_total", "counter", "Times the sensor link was marked down",
+                this->link_down_count_);
+  append_metric(out, "fingerprint_uart_tx_bytes_total", "counter", "Bytes sent to the sensor", link.tx_bytes());
+  append_metric(out, "fingerprint_uart_rx_bytes_total", "counter", "Bytes received from the sensor", link.rx_bytes());
+  append_metric(out, "fingerprint_uart_tx_packets_total", "counter", "Packets sent to the sensor", link.tx_packets());
+  append_metric(out, "fingerprint_uart_rx_packets_total", "counter", "Valid packets received from the sensor",
+                link.rx_packets());
+  append_metric(out, "fingerprint_uart_checksum_errors_total", "counter", "Received packets with a bad checksum",
+                link.checksum_errors());
+  append_metric(out, "fingerprint_uart_timeouts_total", "counter", "Commands that never got an ack",
+                link.timeouts());
+  append_metric(out, "fingerprint_uart_resync_bytes_total", "counter",
+                "Bytes skipped while hunting for the 0xEF01 start code", link.resync_bytes());
+  
+  out += "# HELP fingerprint_command_rtt_seconds Round-trip time from command to ack\n"
+         "# TYPE fingerprint_command_rtt_seconds summary\n";
+  char buf[160];
+  for (uint8_t i = 0; i < link.command_stats_count(); i++) {
+    const CommandStats &stats = link.command_stats()[i];
+    char label[8];
+    const char *name = command_label(stats.command, label);
+    snprintf(buf, sizeof(buf),
+             "fingerprint_command_rtt_seconds_sum{command=\"%s\"} %.6f\n"
+             "fingerprint_command_rtt_seconds_count{command=\"%s\"} %u\n",
+             name, stats.total_us / 1e6, name, (unsigned) stats.count);
+    out += buf;
+  }
+  out += "# HELP fingerprint_command_rtt_max_seconds Slowest round trip per command\n"
+         "# TYPE fingerprint_command_rtt_max_seconds gauge\n";
+  for (uint8_t i = 0; i < link.command_stats_count(); i++) {
+    const CommandStats &stats = link.command_stats()[i];
+    char label[8];
+    const char *name = command_label(stats.command, label);
+    snprintf(buf, sizeof(buf), "fingerprint_command_rtt_max_seconds{command=\"%s\"} %.6f\n", name,
+             stats.max_us / 1e6);
+    out += buf;
+  }
+  
+  if (this->unlock_pin_ != nullptr) {
+    append_metric(out, "fingerprint_unlock_total", "counter", "Matches that drove the unlock output",
+                  this->unlock_count_);
+    append_metric(out, "fingerprint_unlock_denied_total", "counter", "Matches outside the slot's access windows",
+                  this->unlock_denied_count_);
+    append_metric(out, "fingerprint_unlock_policy_seconds", "gauge", "Last access policy evaluation time",
+                  this->unlock_eval_last_us_ / 1e6);
+    append_metric(out, "fingerprint_unlock_policy_max_seconds", "gauge", "Slowest access policy evaluation",
+                  this->unlock_eval_max_us_ / 1e6);
+  }
+  
+  const PublishStats &publish = this->publish_stats_;
+  append_metric(out, "fingerprint_publish_total", "counter", "Entity states sent", publish.published);
+  append_metric(out, "fingerprint_publish_suppressed_total", "counter", "Entity states dropped as unchanged",
+                publish.suppressed);
+  append_metric(out, "fingerprint_publish_coalesced_total", "counter",
+                "Entity states replaced by a newer one before they went out", publish.coalesced);
+  append_metric(out, "fingerprint_publish_deferred_total", "counter", "Entity states held back by a rate limit",
+                publish.deferred);
+  
+#ifdef USE_FINGERPRINT_DOORBELL_MULTICAST
+  if (this->multicast_.enabled()) {
+    append_metric(out, "fingerprint_multicast_sent_total", "counter", "Ring and match datagrams sent",
+                  this->multicast_.sent());
+    append_metric(out, "fingerprint_multicast_errors_total", "counter", "Ring and match datagrams dropped",
+                  this->multicast_.errors());
+    append_metric(out, "fingerprint_multicast_send_max_seconds", "gauge",
+                  "Slowest datagram build and send, time taken from the loop", this->multicast_.max_send_us() / 1e6);
+  }
+#endif
+
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  if (this->cold_.enabled()) {
+    const TierStats &tier = this->tier_stats_;
+    uint16_t cached = 0;
+    for (uint8_t i = 0; i < this->cache_slots_; i++) {
+      if (this->cache_ids_[i] != 0)
+        cached++;
+    }
+    append_metric(out, "fingerprint_tier_cold_templates", "gauge", "Templates in cold storage", this->cold_.size());
+    append_metric(out, "fingerprint_tier_cache_used", "gauge", "Cache slots holding a promoted cold template",
+                  cached);
+    append_metric(out, "fingerprint_tier_promotions_total", "counter", "Cold templates promoted into the cache",
+                  tier.promotions);
+    append_metric(out, "fingerprint_tier_cold_candidates_total", "counter",
+                  "Cold templates matched 1:1 by the fallback", tier.cold_candidates);
+    append_metric(out, "fingerprint_tier_budget_exhausted_total", "counter",
+                  "Fallbacks that missed before trying every cold template", tier.budget_exhausted);
+    append_metric(out, "fingerprint_tier_cold_errors_total", "counter", "Cold template reads or transfers that failed",
+                  tier.cold_errors);
+    
+    // Lookups that reached the library search, by the tier that answered them
+    uint32_t lookups = tier.sensor_hits + tier.cache_hits + tier.cold_hits + tier.cold_misses;
+    const std::pair<const char *, uint32_t> tiers[] = {
+        {"sensor", tier.sensor_hits}, {"cache", tier.cache_hits}, {"cold", tier.cold_hits}, {"miss", tier.cold_misses}};
+    out += "# HELP fingerprint_tier_lookups_total Identifications by the tier that matched (miss: none did)\n"
+           "# TYPE fingerprint_tier_lookups_total counter\n";
+    for (const auto &entry : tiers) {
+      snprintf(buf, sizeof(buf), "fingerprint_tier_lookups_total{tier=\"%s\"} %u\n", entry.first,
+               (unsigned) entry.second);
+      out += buf;
+    }
+    out += "# HELP fingerprint_tier_hit_ratio Share of identifications answered by each tier\n"
+           "# TYPE fingerprint_tier_hit_ratio gauge\n";
+    for (const auto &entry : tiers) {
+      snprintf(buf, sizeof(buf), "fingerprint_tier_hit_ratio{tier=\"%s\"} %.4f\n", entry.first,
+               lookups != 0 ? (double) entry.second / lookups : 0.0);
+      out += buf;
+    }
+    
+    // Time spent per tier: the library search (hot and cache) and the cold fallback
+    const struct {
+      const char *tier;
+      uint64_t sum_us;
+      uint32_t count;
+      uint32_t max_us;
+    } timings[] = {{"library", tier.search_us, tier.search_count, tier.search_max_us},
+                   {"cold", tier.fallback_us, tier.fallback_count, tier.fallback_max_us}};
+    out += "# HELP fingerprint_tier_search_seconds Time per search, by tier\n"
+           "# TYPE fingerprint_tier_search_seconds summary\n";
+    for (const auto &timing : timings) {
+      snprintf(buf, sizeof(buf),
+               "fingerprint_tier_search_seconds_sum{tier=\"%s\"} %.6f\n"
+               "fingerprint_tier_search_seconds_count{tier=\"%s\"} %u\n",
+               timing.tier, timing.sum_us / 1e6, timing.tier, (unsigned) timing.count);
+      out += buf;
+    }
+    out += "# HELP fingerprint_tier_search_max_seconds Slowest search, by tier\n"
+           "# TYPE fingerprint_tier_search_max_seconds gauge\n";
+    for (const auto &timing : timings) {
+      snprintf(buf, sizeof(buf), "fingerprint_tier_search_max_seconds{tier=\"%s\"} %.6f\n", timing.tier,
+               timing.max_us / 1e6);
+      out += buf;
+    }
+    append_metric(out, "fingerprint_tier_cold_budget_seconds", "gauge", "Time budget of one cold fallback",
+                  this->cold_search_budget_ms_ / 1e3);
   }
+#endif
   
-  json += "]";
-  return json;
+  append_metric(out, "fingerprint_heap_free_bytes", "gauge", "Free heap",
+                heap_caps_get_free_size(MALLOC_CAP_8BIT));
+  append_metric(out, "fingerprint_heap_min_free_bytes", "gauge", "Lowest free heap since boot (low-water mark)",
+                heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+  append_metric(out, "fingerprint_heap_largest_free_block_bytes", "gauge", "Largest allocatable heap block",
+                heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  return out;
 }
 
 void FingerprintDoorbell::update_touch_state(bool touched) {
@@ -933,58 +3106,67 @@ bool FingerprintDoorbell::is_ring_touched() {
   return !this->touch_pin_->digital_read();
 }
 
-void FingerprintDoorbell::set_led_ring_ready() {
+void FingerprintDoorbell::set_led(const CommandFrame<5> &frame) {
   if (this->finger_ == nullptr || !this->sensor_connected_)
     return;
-  
-  if (this->ignore_touch_ring_) {
-    // When touch ring is ignored, use solid "on" mode instead of breathing
-    this->finger_->LEDcontrol(FINGERPRINT_LED_ON, 0, this->led_ready_.color, 0);
-  } else {
-    this->finger_->LEDcontrol(this->led_ready_.mode, this->led_ready_.speed, this->led_ready_.color, 0);
-  }
+  Adafruit_Fingerprint_Packet reply(FINGERPRINT_ACKPACKET, 0, nullptr);
+  this->send_frame(frame, reply);
+}
+
+void FingerprintDoorbell::set_led_ring_ready() {
+  TraceScope trace(&this->trace_, "led_ready");
+  // When touch ring is ignored, use solid "on" mode instead of breathing
+  this->set_led(this->ignore_touch_ring_ ? this->led_ready_solid_frame_ : this->led_ready_.frame);
 }
 
 void FingerprintDoorbell::set_led_ring_error() {
-  if (this->finger_ != nullptr)
-    this->finger_->LEDcontrol(this->led_error_.mode, this->led_error_.speed, this->led_error_.color, 0);
+  TraceScope trace(&this->trace_, "led_error");
+  this->set_led(this->led_error_.frame);
 }
 
 void FingerprintDoorbell::set_led_ring_enroll() {
-  if (this->finger_ != nullptr)
-    this->finger_->LEDcontrol(this->led_enroll_.mode, this->led_enroll_.speed, this->led_enroll_.color, 0);
+  TraceScope trace(&this->trace_, "led_enroll");
+  this->set_led(this->led_enroll_.frame);
 }
 
 void FingerprintDoorbell::set_led_ring_match() {
+  TraceScope trace(&this->trace_, "led_match");
   ESP_LOGD(TAG, "LED match: color=%d, mode=%d, speed=%d", this->led_match_.color, this->led_match_.mode, this->led_match_.speed);
-  if (this->finger_ != nullptr)
-    this->finger_->LEDcontrol(this->led_match_.mode, this->led_match_.speed, this->led_match_.color, 0);
+  this->set_led(this->led_match_.frame);
 }
 
 void FingerprintDoorbell::set_led_ring_scanning() {
+  TraceScope trace(&this->trace_, "led_scanning");
   ESP_LOGD(TAG, "LED scanning: color=%d, mode=%d, speed=%d", this->led_scanning_.color, this->led_scanning_.mode, this->led_scanning_.speed);
-  if (this->finger_ != nullptr)
-    this->finger_->LEDcontrol(this->led_scanning_.mode, this->led_scanning_.speed, this->led_scanning_.color, 0);
+  this->set_led(this->led_scanning_.frame);
 }
 
 void FingerprintDoorbell::set_led_ring_no_match() {
+  TraceScope trace(&this->trace_, "led_no_match");
   ESP_LOGD(TAG, "LED no_match: color=%d, mode=%d, speed=%d", this->led_no_match_.color, this->led_no_match_.mode, this->led_no_match_.speed);
-  if (this->finger_ != nullptr)
-    this->finger_->LEDcontrol(this->led_no_match_.mode, this->led_no_match_.speed, this->led_no_match_.color, 0);
+  this->set_led(this->led_no_match_.frame);
+}
+
+uint32_t FingerprintDoorbell::pref_hash(const std::string &key) const {
+  // Each instance keeps its own keys; without a namespace they match the single-sensor keys
+  if (this->preferences_namespace_.empty())
+    return fnv1_hash(key);
+  return fnv1_hash(this->preferences_namespace_ + "/" + key);
 }
 
 void FingerprintDoorbell::load_fingerprint_names() {
+  TraceScope trace(&this->trace_, "pref_load_names");
   this->fingerprint_names_.clear();
   
-  for (uint16_t i = 1; i <= 200; i++) {
+  for (uint16_t i = 1; i <= MAX_FINGERPRINT_ID; i++) {
     std::string key = "fp_" + std::to_string(i);
-    ESPPreferenceObject pref = global_preferences->make_preference<std::array<char, 32>>(fnv1_hash(key.c_str()));
+    ESPPreferenceObject pref = global_preferences->make_preference<NameTable<MAX_FINGERPRINT_ID>::Entry>(this->pref_hash(key));
     
-    std::array<char, 32> name_array;
+    NameTable<MAX_FINGERPRINT_ID>::Entry name_array;
     if (pref.load(&name_array)) {
-      std::string name(name_array.data());
-      if (!name.empty() && name[0] != '\0' && name != "@empty") {
-        this->fingerprint_names_[i] = name;
+      name_array.back() = '\0';
+      if (name_array[0] != '\0' && strcmp(name_array.data(), "@empty") != 0) {
+        this->fingerprint_names_.set(i, name_array.data());
       }
     }
   }
@@ -993,20 +3175,22 @@ void FingerprintDoorbell::load_fingerprint_names() {
 }
 
 void FingerprintDoorbell::save_fingerprint_name(uint16_t id, const std::string &name) {
+  TraceScope trace(&this->trace_, "pref_save_name");
   std::string key = "fp_" + std::to_string(id);
-  ESPPreferenceObject pref = global_preferences->make_preference<std::array<char, 32>>(fnv1_hash(key.c_str()));
+  ESPPreferenceObject pref = global_preferences->make_preference<std::array<char, 32>>(this->pref_hash(key));
   
   std::array<char, 32> name_array = {};
   strncpy(name_array.data(), name.c_str(), 31);
   name_array[31] = '\0';
   pref.save(&name_array);
   
-  this->fingerprint_names_[id] = name;
+  this->fingerprint_names_.set(id, name.c_str());
 }
 
 void FingerprintDoorbell::delete_fingerprint_name(uint16_t id) {
+  TraceScope trace(&this->trace_, "pref_delete_name");
   std::string key = "fp_" + std::to_string(id);
-  ESPPreferenceObject pref = global_preferences->make_preference<std::array<char, 32>>(fnv1_hash(key.c_str()));
+  ESPPreferenceObject pref = global_preferences->make_preference<std::array<char, 32>>(this->pref_hash(key));
   
   std::array<char, 32> empty_array = {};
   pref.save(&empty_array);
@@ -1014,8 +3198,30 @@ void FingerprintDoorbell::delete_fingerprint_name(uint16_t id) {
   this->fingerprint_names_.erase(id);
 }
 
+void FingerprintDoorbell::load_fingerprint_quality() {
+  TraceScope trace(&this->trace_, "pref_load_quality");
+  this->quality_pref_ = global_preferences->make_preference<std::array<uint16_t, MAX_FINGERPRINT_ID + 1>>(
+      this->pref_hash("fp_quality"));
+  if (!this->quality_pref_.load(&this->fingerprint_quality_)) {
+    this->fingerprint_quality_.fill(0);
+  }
+}
+
+void FingerprintDoorbell::save_fingerprint_quality(uint16_t id, uint16_t quality) {
+  if (id > MAX_FINGERPRINT_ID || this->fingerprint_quality_[id] == quality)
+    return;
+  TraceScope trace(&this->trace_, "pref_save_quality");
+  this->fingerprint_quality_[id] = quality;
+  this->quality_pref_.save(&this->fingerprint_quality_);
+}
+
+uint16_t FingerprintDoorbell::get_fingerprint_quality(uint16_t id) {
+  return id <= MAX_FINGERPRINT_ID ? this->fingerprint_quality_[id] : 0;
+}
+
 void FingerprintDoorbell::publish_enroll_status(const std::string &status) {
   ESP_LOGI(TAG, "Enroll status: %s", status.c_str());
+  strncpy(this->enroll_status_, status.c_str(), sizeof(this->enroll_status_) - 1);
   if (this->enroll_status_sensor_ != nullptr) {
     this->enroll_status_sensor_->publish_state(status);
   }
@@ -1028,10 +3234,27 @@ void FingerprintDoorbell::publish_last_action(const std::string &action) {
   }
 }
 
+// Same as publish_last_action(), but formats into a stack buffer and publishes from a
+// string whose capacity was reserved in setup(), so it does not touch the heap
+void FingerprintDoorbell::publish_last_actionf(const char *format, ...) {
+  char buf[64];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  
+  ESP_LOGI(TAG, "Action: %s", buf);
+  if (this->last_action_sensor_ != nullptr) {
+    this->last_action_text_.assign(buf);
+    this->last_action_sensor_->publish_state(this->last_action_text_);
+  }
+}
+
 // ==================== SENSOR PAIRING ====================
 
 void FingerprintDoorbell::load_sensor_password() {
-  ESPPreferenceObject pref = global_preferences->make_preference<uint32_t>(fnv1_hash("sensor_pwd"));
+  TraceScope trace(&this->trace_, "pref_load_password");
+  ESPPreferenceObject pref = global_preferences->make_preference<uint32_t>(this->pref_hash("sensor_pwd"));
   uint32_t stored_password = 0;
   if (pref.load(&stored_password)) {
     // Check for special "unpaired" marker (all 1s is unlikely as a real password)
@@ -1051,11 +3274,13 @@ void FingerprintDoorbell::load_sensor_password() {
 }
 
 void FingerprintDoorbell::save_sensor_password() {
-  ESPPreferenceObject pref = global_preferences->make_preference<uint32_t>(fnv1_hash("sensor_pwd"));
+  TraceScope trace(&this->trace_, "pref_save_password");
+  ESPPreferenceObject pref = global_preferences->make_preference<uint32_t>(this->pref_hash("sensor_pwd"));
   pref.save(&this->sensor_password_);
   ESP_LOGI(TAG, "Saved sensor password to preferences");
 }
 
+#ifdef USE_FINGERPRINT_DOORBELL_REST
 bool FingerprintDoorbell::pair_sensor(uint32_t password) {
   if (!this->sensor_connected_ || this->finger_ == nullptr) {
     ESP_LOGW(TAG, "Cannot pair: sensor not connected");
@@ -1073,8 +3298,7 @@ bool FingerprintDoorbell::pair_sensor(uint32_t password) {
   
   // Recreate finger object with new password for future communications
   delete this->finger_;
-  this->finger_ = new Adafruit_Fingerprint(this->hw_serial_, password);
-  this->finger_->begin(57600);
+  this->finger_ = new Adafruit_Fingerprint(&this->link_, password);
   
   // Update our stored password to match
   this->sensor_password_ = password;
@@ -1103,8 +3327,7 @@ bool FingerprintDoorbell::unpair_sensor() {
   
   // Recreate finger object with default password
   delete this->finger_;
-  this->finger_ = new Adafruit_Fingerprint(this->hw_serial_, 0x00000000);
-  this->finger_->begin(57600);
+  this->finger_ = new Adafruit_Fingerprint(&this->link_, 0x00000000);
   
   // Update our state
   this->sensor_password_ = 0xFFFFFFFF;  // Marker for "unpaired"
@@ -1116,7 +3339,47 @@ bool FingerprintDoorbell::unpair_sensor() {
   return true;
 }
 
+#endif  // USE_FINGERPRINT_DOORBELL_REST
+
 // ==================== REST API ====================
+#ifdef USE_FINGERPRINT_DOORBELL_REST
+
+#define FINGERPRINT_STRINGIFY_(x) #x
+#define FINGERPRINT_STRINGIFY(x) FINGERPRINT_STRINGIFY_(x)
+static const char *const ID_RANGE_ERROR =
+    "{\"error\":\"ID must be 1-" FINGERPRINT_STRINGIFY(FINGERPRINT_DOORBELL_MAX_ID) "\"}";
+// GET /image waits this long beyond `wait` for jobs queued ahead of its capture, then
+// this long for each further packet of the upload
+static const uint32_t IMAGE_START_TIMEOUT_MS = 15000;
+static const uint32_t IMAGE_PACKET_TIMEOUT_MS = 2000;
+
+// Starts a response whose body follows with httpd_resp_send_chunk()
+static void begin_chunked_response(httpd_req_t *req, const char *content_type, const char *status = "200 OK") {
+  httpd_resp_set_status(req, status);
+  httpd_resp_set_type(req, content_type);
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "Content-Type, Authorization");
+}
+
+// CBOR body streamed straight into the HTTP response with chunked encoding, one chunk
+// per filled writer buffer. Call end() once the top-level item is complete.
+class CborResponse : public CborWriter {
+ public:
+  explicit CborResponse(AsyncWebServerRequest *request, const char *status = "200 OK")
+      : CborWriter(&CborResponse::send_chunk, static_cast<httpd_req_t *>(*request)) {
+    begin_chunked_response(*request, "application/cbor", status);
+  }
+  
+  void end() {
+    this->flush();
+    httpd_resp_send_chunk(static_cast<httpd_req_t *>(this->context_), nullptr, 0);
+  }
+  
+ protected:
+  static void send_chunk(void *context, const uint8_t *data, size_t length) {
+    httpd_resp_send_chunk(static_cast<httpd_req_t *>(context), reinterpret_cast<const char *>(data), length);
+  }
+};
 
 class FingerprintRequestHandler : public AsyncWebHandler {
  public:
@@ -1124,12 +3387,17 @@ class FingerprintRequestHandler : public AsyncWebHandler {
   
   bool canHandle(AsyncWebServerRequest *request) const override {
     std::string url = request->url();
-    return url.rfind("/fingerprint/", 0) == 0;  // starts_with equivalent
+    const std::string &prefix = this->parent_->get_rest_prefix();
+    return url.size() > prefix.size() && url.compare(0, prefix.size(), prefix) == 0 && url[prefix.size()] == '/';
   }
   
   bool isRequestHandlerTrivial() const override { return false; }
   
   bool check_auth(AsyncWebServerRequest *request) const {
+#ifndef USE_FINGERPRINT_DOORBELL_API_TOKEN
+    (void) request;
+    return true;  // No instance has an api_token
+#else
     std::string token = this->parent_->get_api_token();
     if (token.empty()) {
       return true;  // No token configured, allow access
@@ -1143,6 +3411,7 @@ class FingerprintRequestHandler : public AsyncWebHandler {
     
     std::string expected = "Bearer " + token;
     return auth_header.value() == expected;
+#endif
   }
   
   void send_cors_response(AsyncWebServerRequest *request, int code, const char *content_type, const std::string &body) {
@@ -1152,8 +3421,62 @@ class FingerprintRequestHandler : public AsyncWebHandler {
     response->addHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
     request->send(response);
   }
+  
+  // Clients opt in to CBOR with "Accept: application/cbor"; everything else gets JSON
+  bool wants_cbor(AsyncWebServerRequest *request) const {
+    auto accept = request->get_header("Accept");
+    return accept.has_value() && accept.value().find("application/cbor") != std::string::npos;
+  }
+  
+  // {"status":..., "id":..., "name":...} acknowledgement; id and name are optional
+  void send_status(AsyncWebServerRequest *request, const char *status, int id = -1, const char *name = nullptr) {
+    if (this->wants_cbor(request)) {
+      CborResponse cbor(request);
+      cbor.begin_map(1 + (id >= 0) + (name != nullptr));
+      cbor.add_text("status");
+      cbor.add_text(status);
+      if (id >= 0) {
+        cbor.add_text("id");
+        cbor.add_uint(id);
+      }
+      if (name != nullptr) {
+        cbor.add_text("name");
+        cbor.add_text(name);
+      }
+      cbor.end();
+      return;
+    }
+    std::string json = "{\"status\":\"" + std::string(status) + "\"";
+    if (id >= 0)
+      json += ",\"id\":" + std::to_string(id);
+    if (name != nullptr)
+      json += ",\"name\":\"" + json_escape(name) + "\"";
+    json += "}";
+    this->send_cors_response(request, 200, "application/json", json);
+  }
 
+  // Sends the gzip page straight from flash. It may be cached for a day and is then
+  // revalidated with its ETag, a hash of the compressed page.
+  void send_web_ui(AsyncWebServerRequest *request) {
+    httpd_req_t *req = *request;
+    std::string etag = std::string("\"") + this->parent_->get_web_ui_etag() + "\"";
+    httpd_resp_set_hdr(req, "ETag", etag.c_str());
+    httpd_resp_set_hdr(req, "Cache-Control", "public, max-age=86400");
+    auto if_none_match = request->get_header("If-None-Match");
+    if (if_none_match.has_value() && if_none_match.value() == etag) {
+      httpd_resp_set_status(req, "304 Not Modified");
+      httpd_resp_send(req, nullptr, 0);
+      return;
+    }
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_send(req, reinterpret_cast<const char *>(this->parent_->get_web_ui_data()),
+                    this->parent_->get_web_ui_size());
+  }
+  
   void handleRequest(AsyncWebServerRequest *request) override {
+    TraceScope trace(this->parent_->get_trace(), "http_request");
+
     // Handle CORS preflight
     if (request->method() == HTTP_OPTIONS) {
       auto *response = request->beginResponse(200, "text/plain", "");
@@ -1164,6 +3487,15 @@ class FingerprintRequestHandler : public AsyncWebHandler {
       return;
     }
 
+    // The management page holds no data of its own; it asks for the token when an API call needs it
+    if (request->method() == HTTP_GET && this->parent_->get_web_ui_size() > 0) {
+      std::string path = request->url().substr(this->parent_->get_rest_prefix().size());
+      if (path == "/" || path == "/ui") {
+        this->send_web_ui(request);
+        return;
+      }
+    }
+    
     // Check authorization for all endpoints
     if (!this->check_auth(request)) {
       this->send_cors_response(request, 401, "application/json", "{\"error\":\"Unauthorized\"}");
@@ -1172,28 +3504,107 @@ class FingerprintRequestHandler : public AsyncWebHandler {
     
     std::string url = request->url();
     ESP_LOGD(TAG, "Request: %s %s", request->method() == HTTP_GET ? "GET" : (request->method() == HTTP_POST ? "POST" : "OTHER"), url.c_str());
+    // Endpoints below are matched without this instance's prefix (default /fingerprint)
+    std::string path = url.substr(this->parent_->get_rest_prefix().size());
     
     // GET /fingerprint/list - Get list of enrolled fingerprints
-    if (url == "/fingerprint/list" && request->method() == HTTP_GET) {
+    if (path == "/list" && request->method() == HTTP_GET) {
+      if (this->wants_cbor(request)) {
+        CborResponse cbor(request);
+        this->parent_->encode_fingerprint_list(cbor);
+        cbor.end();
+        return;
+      }
       std::string json = this->parent_->get_fingerprint_list_json();
       this->send_cors_response(request, 200, "application/json", json);
       return;
     }
     
     // GET /fingerprint/status - Get current status
-    if (url == "/fingerprint/status" && request->method() == HTTP_GET) {
+    if (path == "/status" && request->method() == HTTP_GET) {
+      if (this->wants_cbor(request)) {
+        CborResponse cbor(request);
+        cbor.begin_map(6);
+        cbor.add_text("connected");
+        cbor.add_bool(this->parent_->is_sensor_connected());
+        cbor.add_text("paired");
+        cbor.add_bool(this->parent_->is_sensor_paired());
+        cbor.add_text("enrolling");
+        cbor.add_bool(this->parent_->is_enrolling());
+        cbor.add_text("enroll_status");
+        cbor.add_text(this->parent_->get_enroll_status());
+        cbor.add_text("count");
+        cbor.add_uint(this->parent_->get_enrolled_count());
+        cbor.add_text("max_id");
+        cbor.add_uint(MAX_FINGERPRINT_ID);
+        cbor.end();
+        return;
+      }
       std::string json = "{";
       json += "\"connected\":" + std::string(this->parent_->is_sensor_connected() ? "true" : "false");
       json += ",\"paired\":" + std::string(this->parent_->is_sensor_paired() ? "true" : "false");
       json += ",\"enrolling\":" + std::string(this->parent_->is_enrolling() ? "true" : "false");
+      json += ",\"enroll_status\":\"" + std::string(this->parent_->get_enroll_status()) + "\"";
       json += ",\"count\":" + std::to_string(this->parent_->get_enrolled_count());
+      json += ",\"max_id\":" + std::to_string(MAX_FINGERPRINT_ID);
       json += "}";
       this->send_cors_response(request, 200, "application/json", json);
       return;
     }
     
+    // GET /fingerprint/metrics - Link-layer counters in Prometheus text format
+    if (path == "/metrics" && request->method() == HTTP_GET) {
+      this->send_cors_response(request, 200, "text/plain; version=0.0.4", this->parent_->get_metrics_prometheus());
+      return;
+    }
+    
+    // GET /fingerprint/trace - Recorded begin/end events as Chrome trace-event JSON
+    if (path == "/trace" && request->method() == HTTP_GET) {
+      TraceRecorder *recorder = this->parent_->get_trace();
+      if (!recorder->enabled()) {
+        this->send_cors_response(request, 404, "application/json",
+                                 "{\"error\":\"Tracing disabled, set trace_buffer_size\"}");
+        return;
+      }
+      this->send_cors_response(request, 200, "application/json", recorder->dump_chrome_json());
+      return;
+    }
+    
+#ifdef USE_FINGERPRINT_DOORBELL_CAPTURE
+    // GET /fingerprint/capture - Download the sensor traffic capture (binary, see link_capture.h)
+    if (path == "/capture" && request->method() == HTTP_GET) {
+      LinkCapture *capture = this->parent_->get_capture();
+      if (!capture->enabled()) {
+        this->send_cors_response(request, 404, "application/json",
+                                 "{\"error\":\"Capture disabled, set capture_buffer_size\"}");
+        return;
+      }
+      httpd_req_t *req = *request;
+      begin_chunked_response(req, "application/octet-stream");
+      httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"sensor.fpcap\"");
+      capture->dump([req](const uint8_t *data, size_t length) {
+        return httpd_resp_send_chunk(req, reinterpret_cast<const char *>(data), length) == ESP_OK;
+      });
+      httpd_resp_send_chunk(req, nullptr, 0);
+      return;
+    }
+    
+    // POST /fingerprint/capture/clear - Start a fresh capture
+    if (path == "/capture/clear" && request->method() == HTTP_POST) {
+      LinkCapture *capture = this->parent_->get_capture();
+      if (!capture->enabled()) {
+        this->send_cors_response(request, 404, "application/json",
+                                 "{\"error\":\"Capture disabled, set capture_buffer_size\"}");
+        return;
+      }
+      capture->clear();
+      this->send_status(request, "cleared");
+      return;
+    }
+#endif
+    
     // POST /fingerprint/pair?password=XXXXXXXX - Pair sensor with password (hex string)
-    if (url == "/fingerprint/pair" && request->method() == HTTP_POST) {
+    if (path == "/pair" && request->method() == HTTP_POST) {
       if (!request->hasParam("password")) {
         this->send_cors_response(request, 400, "application/json", "{\"error\":\"Missing password parameter\"}");
         return;
@@ -1209,26 +3620,23 @@ class FingerprintRequestHandler : public AsyncWebHandler {
         return;
       }
       
-      if (this->parent_->pair_sensor(password)) {
-        this->send_cors_response(request, 200, "application/json", "{\"status\":\"paired\"}");
-      } else {
-        this->send_cors_response(request, 500, "application/json", "{\"error\":\"Failed to pair sensor\"}");
-      }
+      Job job;
+      job.type = JobType::PAIR;
+      job.password = password;
+      this->submit_job(request, std::move(job));
       return;
     }
     
     // POST /fingerprint/unpair - Unpair sensor (reset to default password)
-    if (url == "/fingerprint/unpair" && request->method() == HTTP_POST) {
-      if (this->parent_->unpair_sensor()) {
-        this->send_cors_response(request, 200, "application/json", "{\"status\":\"unpaired\"}");
-      } else {
-        this->send_cors_response(request, 500, "application/json", "{\"error\":\"Failed to unpair sensor\"}");
-      }
+    if (path == "/unpair" && request->method() == HTTP_POST) {
+      Job job;
+      job.type = JobType::UNPAIR;
+      this->submit_job(request, std::move(job));
       return;
     }
     
     // POST /fingerprint/enroll?id=X&name=Y - Start enrollment
-    if (url == "/fingerprint/enroll" && request->method() == HTTP_POST) {
+    if (path == "/enroll" && request->method() == HTTP_POST) {
       if (!request->hasParam("id") || !request->hasParam("name")) {
         this->send_cors_response(request, 400, "application/json", "{\"error\":\"Missing id or name parameter\"}");
         return;
@@ -1237,26 +3645,180 @@ class FingerprintRequestHandler : public AsyncWebHandler {
       std::string name = request->getParam("name")->value();
       uint16_t id = std::atoi(id_str.c_str());
       
-      if (id < 1 || id > 200) {
-        this->send_cors_response(request, 400, "application/json", "{\"error\":\"ID must be 1-200\"}");
+      if (id < 1 || id > MAX_FINGERPRINT_ID) {
+        this->send_cors_response(request, 400, "application/json", ID_RANGE_ERROR);
+        return;
+      }
+      
+      Job job;
+      job.type = JobType::ENROLL;
+      job.slot = id;
+      job.name = name;
+      this->submit_job(request, std::move(job));
+      return;
+    }
+    
+    // POST /fingerprint/enroll_session?names=A,B,C - Enroll several names back to back into free slots
+    if (path == "/enroll_session" && request->method() == HTTP_POST) {
+      if (!request->hasParam("names")) {
+        this->send_cors_response(request, 400, "application/json", "{\"error\":\"Missing names parameter\"}");
+        return;
+      }
+      std::string names_str = request->getParam("names")->value();
+      std::vector<std::string> names;
+      size_t start = 0;
+      while (start <= names_str.size()) {
+        size_t end = names_str.find(',', start);
+        if (end == std::string::npos)
+          end = names_str.size();
+        if (end > start)
+          names.push_back(names_str.substr(start, end - start));
+        start = end + 1;
+      }
+      
+      if (names.empty() || names.size() > MAX_FINGERPRINT_ID) {
+        this->send_cors_response(request, 400, "application/json",
+                                 "{\"error\":\"names must list 1-" FINGERPRINT_STRINGIFY(FINGERPRINT_DOORBELL_MAX_ID)
+                                 " entries\"}");
         return;
       }
       
-      this->parent_->start_enrollment(id, name);
-      std::string response = "{\"status\":\"enrollment_started\",\"id\":" + std::to_string(id) + ",\"name\":\"" + name + "\"}";
-      this->send_cors_response(request, 200, "application/json", response);
+      Job job;
+      job.type = JobType::ENROLL_SESSION;
+      job.names = std::move(names);
+      this->submit_job(request, std::move(job));
+      return;
+    }
+    
+    // GET /fingerprint/enroll_session - Progress and per-entry results of the last session
+    if (path == "/enroll_session" && request->method() == HTTP_GET) {
+      this->send_enroll_session(request);
       return;
     }
     
     // POST /fingerprint/cancel - Cancel enrollment
-    if (url == "/fingerprint/cancel" && request->method() == HTTP_POST) {
-      this->parent_->cancel_enrollment();
-      this->send_cors_response(request, 200, "application/json", "{\"status\":\"cancelled\"}");
+    if (path == "/cancel" && request->method() == HTTP_POST) {
+      Job job;
+      job.type = JobType::CANCEL_ENROLL;
+      this->submit_job(request, std::move(job));
+      return;
+    }
+    
+    // POST /fingerprint/verify?id=X[&arm=true&timeout=S] - 1:1 verification of a claimed identity.
+    // Without arm the finger must already be on the sensor and the check runs as a job;
+    // with arm the next touch is verified.
+    if (path == "/verify" && request->method() == HTTP_POST) {
+      if (!request->hasParam("id")) {
+        this->send_cors_response(request, 400, "application/json", "{\"error\":\"Missing id parameter\"}");
+        return;
+      }
+      uint16_t id = std::atoi(request->getParam("id")->value().c_str());
+      if (id < 1 || id > MAX_FINGERPRINT_ID) {
+        this->send_cors_response(request, 400, "application/json", ID_RANGE_ERROR);
+        return;
+      }
+      
+      if (request->hasParam("arm") && request->getParam("arm")->value() == "true") {
+        uint32_t timeout_s = 10;
+        if (request->hasParam("timeout"))
+          timeout_s = std::atoi(request->getParam("timeout")->value().c_str());
+        if (timeout_s < 1 || timeout_s > 300) {
+          this->send_cors_response(request, 400, "application/json", "{\"error\":\"timeout must be 1-300 seconds\"}");
+          return;
+        }
+        if (this->parent_->arm_verify(id, timeout_s * 1000)) {
+          this->send_status(request, "verify_armed", id);
+        } else {
+          this->send_cors_response(request, 409, "application/json", "{\"error\":\"Cannot verify while enrolling\"}");
+        }
+        return;
+      }
+      
+      Job job;
+      job.type = JobType::VERIFY;
+      job.slot = id;
+      this->submit_job(request, std::move(job));
+      return;
+    }
+    
+    // GET /fingerprint/verify - Result of the last (or state of the armed) verification
+    if (path == "/verify" && request->method() == HTTP_GET) {
+      this->send_verify(request);
+      return;
+    }
+    
+    // GET /fingerprint/access - Access windows and the windows each named slot may unlock in
+    if (path == "/access" && request->method() == HTTP_GET) {
+      this->send_cors_response(request, 200, "application/json", this->access_json());
+      return;
+    }
+    
+    // POST /fingerprint/access?id=X&windows=0,2 - Override a slot's windows ("none", or "default" to reset)
+    if (path == "/access" && request->method() == HTTP_POST) {
+      if (!this->parent_->has_unlock_pin()) {
+        this->send_cors_response(request, 409, "application/json", "{\"error\":\"No unlock_pin configured\"}");
+        return;
+      }
+      if (!request->hasParam("id") || !request->hasParam("windows")) {
+        this->send_cors_response(request, 400, "application/json", "{\"error\":\"Missing id or windows parameter\"}");
+        return;
+      }
+      // Parsed strictly: "3x" or "" must not quietly become slot 3 or window 0
+      unsigned long id;
+      if (!parse_number(request->getParam("id")->value(), 1, MAX_FINGERPRINT_ID, id)) {
+        this->send_cors_response(request, 400, "application/json", ID_RANGE_ERROR);
+        return;
+      }
+      std::string windows_str = request->getParam("windows")->value();
+      uint8_t windows = 0;
+      if (windows_str == "default") {
+        windows = AccessPolicy<MAX_FINGERPRINT_ID>::USE_DEFAULT;
+      } else if (windows_str != "none") {
+        uint8_t count = this->parent_->get_access_policy().window_count();
+        const char *text = windows_str.c_str();
+        size_t start = 0;
+        do {
+          size_t end = windows_str.find(',', start);
+          if (end == std::string::npos)
+            end = windows_str.size();
+          unsigned long index;
+          if (count == 0 || !parse_number(text + start, text + end, 0, count - 1, index)) {
+            this->send_cors_response(request, 400, "application/json",
+                                     "{\"error\":\"windows must be none, default or window indexes like 0,2\"}");
+            return;
+          }
+          windows |= 1 << index;
+          start = end + 1;
+        } while (start <= windows_str.size());
+      }
+      
+      this->parent_->set_access_windows(id, windows);
+      this->send_status(request, "access_updated", id);
+      return;
+    }
+    
+    // GET /fingerprint/image[?wait=S] - Capture an image (job)
+    // GET /fingerprint/image?job=N[&format=pgm&width=W&height=H] - Stream that job's image
+    if (path == "/image" && request->method() == HTTP_GET) {
+      this->handle_image(request);
       return;
     }
     
     // POST /fingerprint/delete?id=X - Delete fingerprint
-    if (url == "/fingerprint/delete" && request->method() == HTTP_POST) {
+    // POST /fingerprint/delete?ids=1,3,5-9 - Delete a list of IDs and ranges
+    if (path == "/delete" && request->method() == HTTP_POST && request->hasParam("ids")) {
+      std::vector<uint16_t> ids;
+      if (!parse_id_list(request->getParam("ids")->value(), MAX_FINGERPRINT_ID, ids)) {
+        this->send_cors_response(request, 400, "application/json", "{\"error\":\"ids must list IDs or ranges like 1,3,5-9\"}");
+        return;
+      }
+      Job job;
+      job.type = JobType::DELETE_BATCH;
+      job.ids = std::move(ids);
+      this->submit_job(request, std::move(job));
+      return;
+    }
+    if (path == "/delete" && request->method() == HTTP_POST) {
       if (!request->hasParam("id")) {
         this->send_cors_response(request, 400, "application/json", "{\"error\":\"Missing id parameter\"}");
         return;
@@ -1264,27 +3826,42 @@ class FingerprintRequestHandler : public AsyncWebHandler {
       std::string id_str = request->getParam("id")->value();
       uint16_t id = std::atoi(id_str.c_str());
       
-      if (this->parent_->delete_fingerprint(id)) {
-        std::string response = "{\"status\":\"deleted\",\"id\":" + std::to_string(id) + "}";
-        this->send_cors_response(request, 200, "application/json", response);
-      } else {
-        this->send_cors_response(request, 500, "application/json", "{\"error\":\"Delete failed\"}");
+      if (id < 1 || id > MAX_FINGERPRINT_ID) {
+        this->send_cors_response(request, 400, "application/json", ID_RANGE_ERROR);
+        return;
       }
+      
+      Job job;
+      job.type = JobType::DELETE;
+      job.slot = id;
+      this->submit_job(request, std::move(job));
       return;
     }
     
     // POST /fingerprint/delete_all - Delete all fingerprints
-    if (url == "/fingerprint/delete_all" && request->method() == HTTP_POST) {
-      if (this->parent_->delete_all_fingerprints()) {
-        this->send_cors_response(request, 200, "application/json", "{\"status\":\"all_deleted\"}");
-      } else {
-        this->send_cors_response(request, 500, "application/json", "{\"error\":\"Delete all failed\"}");
+    if (path == "/delete_all" && request->method() == HTTP_POST) {
+      Job job;
+      job.type = JobType::DELETE_ALL;
+      this->submit_job(request, std::move(job));
+      return;
+    }
+    
+    // POST /fingerprint/rename?names=1:Alice,2:Bob,10-15:Guest - Rename several slots at once
+    if (path == "/rename" && request->method() == HTTP_POST && request->hasParam("names")) {
+      std::vector<std::pair<uint16_t, std::string>> names;
+      if (!parse_name_list(request->getParam("names")->value(), MAX_FINGERPRINT_ID, names)) {
+        this->send_cors_response(request, 400, "application/json", "{\"error\":\"names must list id:name or range:name entries\"}");
+        return;
       }
+      Job job;
+      job.type = JobType::RENAME_BATCH;
+      job.renames = std::move(names);
+      this->submit_job(request, std::move(job));
       return;
     }
     
     // POST /fingerprint/rename?id=X&name=Y - Rename fingerprint
-    if (url == "/fingerprint/rename" && request->method() == HTTP_POST) {
+    if (path == "/rename" && request->method() == HTTP_POST) {
       if (!request->hasParam("id") || !request->hasParam("name")) {
         this->send_cors_response(request, 400, "application/json", "{\"error\":\"Missing id or name parameter\"}");
         return;
@@ -1294,40 +3871,47 @@ class FingerprintRequestHandler : public AsyncWebHandler {
       uint16_t id = std::atoi(id_str.c_str());
       
       if (this->parent_->rename_fingerprint(id, name)) {
-        std::string response = "{\"status\":\"renamed\",\"id\":" + std::to_string(id) + ",\"name\":\"" + name + "\"}";
-        this->send_cors_response(request, 200, "application/json", response);
+        this->send_status(request, "renamed", id, name.c_str());
       } else {
         this->send_cors_response(request, 500, "application/json", "{\"error\":\"Rename failed\"}");
       }
       return;
     }
     
-    // GET /fingerprint/template?id=X - Export fingerprint template as base64
-    if (url == "/fingerprint/template" && request->method() == HTTP_GET) {
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
+    if (path.compare(0, 9, "/template") == 0 && !this->parent_->has_template_transfer()) {
+      this->send_cors_response(request, 404, "application/json",
+                               "{\"error\":\"Template transfer disabled, set template_transfer: true\"}");
+      return;
+    }
+    
+    // GET /fingerprint/template?id=X[&encoding=packbits] - Export fingerprint template
+    // (base64 in JSON, raw bytes in CBOR), optionally PackBits-compressed
+    if (path == "/template" && request->method() == HTTP_GET) {
       if (!request->hasParam("id")) {
         this->send_cors_response(request, 400, "application/json", "{\"error\":\"Missing id parameter\"}");
         return;
       }
       std::string id_str = request->getParam("id")->value();
       uint16_t id = std::atoi(id_str.c_str());
-      
-      std::vector<uint8_t> template_data;
-      if (this->parent_->get_template(id, template_data)) {
-        // Base64 encode the template data
-        std::string base64 = this->base64_encode(template_data);
-        std::string name = this->parent_->get_fingerprint_name(id);
-        std::string response = "{\"id\":" + std::to_string(id) + ",\"name\":\"" + name + "\",\"template\":\"" + base64 + "\"}";
-        this->send_cors_response(request, 200, "application/json", response);
-      } else {
-        this->send_cors_response(request, 500, "application/json", "{\"error\":\"Failed to export template\"}");
+      TemplateEncoding encoding = TemplateEncoding::RAW;
+      if (request->hasParam("encoding") && !parse_template_encoding(request->getParam("encoding")->value(), encoding)) {
+        this->send_cors_response(request, 400, "application/json", "{\"error\":\"encoding must be raw or packbits\"}");
+        return;
       }
+      
+      Job job;
+      job.type = JobType::TEMPLATE_EXPORT;
+      job.slot = id;
+      job.encoding = encoding;
+      this->submit_job(request, std::move(job));
       return;
     }
     
     // POST /fingerprint/template/chunk - Import fingerprint template in chunks
     // Query params: id, chunk (0-based index), total (total chunks), data (base64 chunk)
-    // First chunk also includes: name
-    if (url == "/fingerprint/template/chunk" && request->method() == HTTP_POST) {
+    // First chunk also includes: name, optionally encoding (raw or packbits)
+    if (path == "/template/chunk" && request->method() == HTTP_POST) {
       if (!request->hasParam("id") || !request->hasParam("chunk") || 
           !request->hasParam("total") || !request->hasParam("data")) {
         ESP_LOGW(TAG, "Chunk request missing params");
@@ -1348,8 +3932,14 @@ class FingerprintRequestHandler : public AsyncWebHandler {
           this->send_cors_response(request, 400, "application/json", "{\"error\":\"First chunk must include name\"}");
           return;
         }
+        TemplateEncoding encoding = TemplateEncoding::RAW;
+        if (request->hasParam("encoding") && !parse_template_encoding(request->getParam("encoding")->value(), encoding)) {
+          this->send_cors_response(request, 400, "application/json", "{\"error\":\"encoding must be raw or packbits\"}");
+          return;
+        }
         import_id_ = id;
         import_name_ = request->getParam("name")->value();
+        import_encoding_ = encoding;
         import_buffer_.clear();
         import_buffer_.reserve(total_chunks * 500);  // Approximate size
         ESP_LOGI(TAG, "Starting chunked import: id=%d name='%s' chunks=%d", id, import_name_.c_str(), total_chunks);
@@ -1367,7 +3957,7 @@ class FingerprintRequestHandler : public AsyncWebHandler {
       
       // If not last chunk, just acknowledge
       if (chunk_idx < total_chunks - 1) {
-        this->send_cors_response(request, 200, "application/json", "{\"status\":\"chunk_received\"}");
+        this->send_status(request, "chunk_received");
         return;
       }
       
@@ -1382,18 +3972,477 @@ class FingerprintRequestHandler : public AsyncWebHandler {
         return;
       }
       
-      if (this->parent_->upload_template(import_id_, import_name_, template_data)) {
-        std::string response = "{\"status\":\"imported\",\"id\":" + std::to_string(import_id_) + ",\"name\":\"" + import_name_ + "\"}";
-        this->send_cors_response(request, 200, "application/json", response);
-      } else {
-        this->send_cors_response(request, 500, "application/json", "{\"error\":\"Failed to import template\"}");
+      TemplateStream tmpl(template_data.data(), template_data.size(), import_encoding_);
+      if (tmpl.size() == 0) {
+        this->send_cors_response(request, 400, "application/json", "{\"error\":\"Invalid packbits template data\"}");
+        return;
       }
+      
+      Job job;
+      job.type = JobType::TEMPLATE_IMPORT;
+      job.slot = import_id_;
+      job.name = import_name_;
+      job.encoding = import_encoding_;
+      job.data = std::move(template_data);
+      this->submit_job(request, std::move(job));
+      return;
+    }
+#endif
+    
+    // GET /fingerprint/jobs/<id> - State and, once finished, result of a queued operation
+    if (path.compare(0, 6, "/jobs/") == 0 && request->method() == HTTP_GET) {
+      uint32_t job_id = strtoul(path.c_str() + 6, nullptr, 10);
+      Job job;
+      bool found = this->parent_->get_jobs().with_job(job_id, [&job](const Job &queued) {
+        // Copy out so the response is written without holding the queue lock
+        job.id = queued.id;
+        job.type = queued.type;
+        job.state = queued.state;
+        if (queued.state == JobState::DONE || queued.state == JobState::FAILED) {
+          job.slot = queued.slot;
+          job.name = queued.name;
+          job.encoding = queued.encoding;
+          job.data = queued.data;
+          job.stats = queued.stats;
+        }
+      });
+      if (!found) {
+        this->send_cors_response(request, 404, "application/json", "{\"error\":\"Unknown job\"}");
+        return;
+      }
+      this->send_job(request, job);
       return;
     }
     
     this->send_cors_response(request, 404, "application/json", "{\"error\":\"Unknown endpoint\"}");
   }
   
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
+  std::string transfer_json(const TransferStats &stats) const {
+    std::string json = "{\"attempts\":" + std::to_string(stats.attempts);
+    json += ",\"checksum_errors\":" + std::to_string(stats.checksum_errors);
+    json += ",\"timeouts\":" + std::to_string(stats.timeouts);
+    json += ",\"verify_mismatches\":" + std::to_string(stats.verify_mismatches);
+    json += ",\"verified\":" + std::string(stats.verified ? "true" : "false");
+    json += "}";
+    return json;
+  }
+  
+  void encode_transfer(CborWriter &writer, const TransferStats &stats) const {
+    writer.begin_map(5);
+    writer.add_text("attempts");
+    writer.add_uint(stats.attempts);
+    writer.add_text("checksum_errors");
+    writer.add_uint(stats.checksum_errors);
+    writer.add_text("timeouts");
+    writer.add_uint(stats.timeouts);
+    writer.add_text("verify_mismatches");
+    writer.add_uint(stats.verify_mismatches);
+    writer.add_text("verified");
+    writer.add_bool(stats.verified);
+  }
+#endif
+  
+  // GET /image[?wait=S&format=raw|pgm&width=W&height=H] queues a capture job and streams
+  // its UpImage packets into a chunked response as the loop task reads them. Raw is the
+  // sensor's data as is (two 4-bit pixels per byte, first pixel in the high nibble); PGM
+  // expands it to 8-bit grey behind a header, which needs the image size up front.
+  void handle_image(AsyncWebServerRequest *request) {
+    unsigned long wait_s = 5, width = 192, height = 192;
+    if ((request->hasParam("wait") && !parse_number(request->getParam("wait")->value(), 0, 10, wait_s)) ||
+        (request->hasParam("width") && !parse_number(request->getParam("width")->value(), 1, 512, width)) ||
+        (request->hasParam("height") && !parse_number(request->getParam("height")->value(), 1, 512, height))) {
+      this->send_cors_response(request, 400, "application/json",
+                               "{\"error\":\"wait must be 0-10, width and height 1-512\"}");
+      return;
+    }
+    bool pgm = false;
+    if (request->hasParam("format")) {
+      std::string format = request->getParam("format")->value();
+      if (format != "raw" && format != "pgm") {
+        this->send_cors_response(request, 400, "application/json", "{\"error\":\"format must be raw or pgm\"}");
+        return;
+      }
+      pgm = format == "pgm";
+    }
+    if (this->parent_->is_enrolling()) {
+      this->send_cors_response(request, 409, "application/json", "{\"error\":\"Enrollment in progress\"}");
+      return;
+    }
+    
+    ImageStream &stream = this->parent_->get_image_stream();
+    uint32_t ticket = stream.open();
+    if (ticket == 0) {
+      this->send_cors_response(request, 409, "application/json", "{\"error\":\"Another image is being captured\"}");
+      return;
+    }
+    Job job;
+    job.type = JobType::IMAGE_CAPTURE;
+    job.wait_ms = wait_s * 1000;
+    job.stream = ticket;
+    if (this->parent_->get_jobs().submit(std::move(job)) == 0) {
+      stream.close(ticket);
+      this->send_cors_response(request, 503, "application/json", "{\"error\":\"Too many jobs in progress\"}");
+      return;
+    }
+    
+    // The first packet comes once the jobs ahead are done and a finger is there
+    uint16_t length = 0;
+    bool ended = false;
+    const uint8_t *packet = stream.next(ticket, length, ended, wait_s * 1000 + IMAGE_START_TIMEOUT_MS);
+    if (packet == nullptr) {
+      uint8_t code = ended ? stream.code() : FINGERPRINT_TIMEOUT;
+      stream.close(ticket);
+      if (code == FINGERPRINT_NOFINGER) {
+        this->send_cors_response(request, 408, "application/json", "{\"error\":\"No finger on the sensor\"}");
+      } else {
+        this->send_cors_response(request, 500, "application/json", "{\"error\":\"Image capture failed\"}");
+      }
+      return;
+    }
+    
+    httpd_req_t *req = *request;
+    begin_chunked_response(req, pgm ? "image/x-portable-graymap" : "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition",
+                       pgm ? "inline; filename=\"fingerprint.pgm\"" : "inline; filename=\"fingerprint.raw\"");
+    char pixels[2 * ImageStream::PACKET_SIZE];
+    size_t pixels_left = width * height;
+    bool sent = true;
+    if (pgm) {
+      int size = snprintf(pixels, sizeof(pixels), "P5\n%u %u\n255\n", (unsigned) width, (unsigned) height);
+      sent = httpd_resp_send_chunk(req, pixels, size) == ESP_OK;
+    }
+    while (sent && packet != nullptr) {
+      if (!pgm) {
+        sent = httpd_resp_send_chunk(req, reinterpret_cast<const char *>(packet), length) == ESP_OK;
+      } else {
+        // Two 4-bit pixels per byte; pixels past width x height are dropped
+        size_t count = 0;
+        for (uint16_t i = 0; i < length && count < pixels_left; i++) {
+          pixels[count++] = (packet[i] >> 4) * 17;
+          if (count < pixels_left)
+            pixels[count++] = (packet[i] & 0x0F) * 17;
+        }
+        pixels_left -= count;
+        sent = count == 0 || httpd_resp_send_chunk(req, pixels, count) == ESP_OK;
+      }
+      stream.release(ticket);
+      if (sent)
+        packet = stream.next(ticket, length, ended, IMAGE_PACKET_TIMEOUT_MS);
+    }
+    bool complete = sent && ended && stream.code() == FINGERPRINT_OK;
+    stream.close(ticket);
+    if (!sent)
+      return;  // The client went away; the loop task drains the rest of the upload
+    if (!complete)
+      ESP_LOGW(TAG, "Image upload ended early, the response is cut short");
+    
+    // A short image is padded so the PGM stays readable
+    memset(pixels, 0, sizeof(pixels));
+    while (pgm && pixels_left > 0) {
+      size_t count = std::min(pixels_left, sizeof(pixels));
+      if (httpd_resp_send_chunk(req, pixels, count) != ESP_OK)
+        return;
+      pixels_left -= count;
+    }
+    httpd_resp_send_chunk(req, nullptr, 0);
+  }
+  
+  std::string access_json() const {
+    const AccessPolicy<MAX_FINGERPRINT_ID> &policy = this->parent_->get_access_policy();
+    std::string json = "{\"windows\":[";
+    char buf[96];
+    for (uint8_t i = 0; i < policy.window_count(); i++) {
+      const AccessWindow &window = policy.window(i);
+      snprintf(buf, sizeof(buf), "%s{\"index\":%u,\"days\":%u,\"start\":\"%02u:%02u\",\"end\":\"%02u:%02u\"}",
+               i == 0 ? "" : ",", (unsigned) i, (unsigned) window.days, window.start / 60u, window.start % 60u,
+               window.end / 60u, window.end % 60u);
+      json += buf;
+    }
+    json += "],\"slots\":[";
+    bool first = true;
+    for (uint16_t id = 1; id <= MAX_FINGERPRINT_ID; id++) {
+      uint8_t mask = policy.windows_for(id);
+      if (!this->parent_->has_fingerprint(id) && !policy.is_overridden(id))
+        continue;  // Slot not in use
+      snprintf(buf, sizeof(buf), "%s{\"id\":%u,\"windows\":%u,\"override\":%s}", first ? "" : ",",
+               (unsigned) id, (unsigned) mask, policy.is_overridden(id) ? "true" : "false");
+      json += buf;
+      first = false;
+    }
+    json += "]}";
+    return json;
+  }
+  
+  // Queues `job` for the loop task and answers 202 Accepted with its id
+  void submit_job(AsyncWebServerRequest *request, Job &&job) {
+    uint32_t id = this->parent_->get_jobs().submit(std::move(job));
+    if (id == 0) {
+      this->send_cors_response(request, 503, "application/json", "{\"error\":\"Too many jobs in progress\"}");
+      return;
+    }
+    std::string location = this->parent_->get_rest_prefix() + "/jobs/" + std::to_string(id);
+    if (this->wants_cbor(request)) {
+      CborResponse cbor(request, "202 Accepted");
+      httpd_resp_set_hdr(*request, "Location", location.c_str());
+      cbor.begin_map(2);
+      cbor.add_text("status");
+      cbor.add_text("accepted");
+      cbor.add_text("job");
+      cbor.add_uint(id);
+      cbor.end();
+      return;
+    }
+    AsyncWebServerResponse *response =
+        request->beginResponse(202, "application/json", "{\"status\":\"accepted\",\"job\":" + std::to_string(id) + "}");
+    response->addHeader("Location", location.c_str());
+    response->addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+    response->addHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    request->send(response);
+  }
+  
+  static const char *job_type_name(JobType type) {
+    switch (type) {
+      case JobType::TEMPLATE_EXPORT: return "template_export";
+      case JobType::TEMPLATE_IMPORT: return "template_import";
+      case JobType::DELETE_ALL: return "delete_all";
+      case JobType::PAIR: return "pair";
+      case JobType::ENROLL_SESSION: return "enroll_session";
+      case JobType::VERIFY: return "verify";
+      case JobType::IMAGE_CAPTURE: return "image";
+      case JobType::DELETE_BATCH: return "delete";
+      case JobType::RENAME_BATCH: return "rename";
+      case JobType::DELETE: return "delete";
+      case JobType::ENROLL: return "enroll";
+      case JobType::CANCEL_ENROLL: return "cancel";
+      case JobType::UNPAIR: return "unpair";
+      default: return "unknown";
+    }
+  }
+
+  // Status of a finished job whose result is only its outcome
+  static const char *job_status(JobType type) {
+    switch (type) {
+      case JobType::DELETE_ALL: return "all_deleted";
+      case JobType::ENROLL_SESSION: return "session_started";
+      case JobType::DELETE: return "deleted";
+      case JobType::ENROLL: return "enrollment_started";
+      case JobType::CANCEL_ENROLL: return "cancelled";
+      case JobType::UNPAIR: return "unpaired";
+      default: return "paired";
+    }
+  }
+  
+  static const char *job_state_name(JobState state) {
+    switch (state) {
+      case JobState::QUEUED: return "queued";
+      case JobState::RUNNING: return "running";
+      case JobState::DONE: return "done";
+      default: return "failed";
+    }
+  }
+  
+  static const char *job_error(const Job &job) {
+    switch (job.type) {
+      case JobType::TEMPLATE_EXPORT: return "Failed to export template";
+      case JobType::TEMPLATE_IMPORT: return "Failed to import template";
+      case JobType::DELETE_ALL: return "Delete all failed";
+      case JobType::ENROLL_SESSION: return "Could not start enrollment session";
+      case JobType::VERIFY: return "Sensor busy or not connected";
+      case JobType::IMAGE_CAPTURE:
+        return job.code == FINGERPRINT_NOFINGER ? "No finger on the sensor" : "Image capture failed";
+      case JobType::DELETE_BATCH: return "Delete failed";
+      case JobType::RENAME_BATCH: return "None of the IDs are enrolled";
+      case JobType::DELETE: return "Delete failed";
+      case JobType::ENROLL: return "Could not start enrollment";
+      case JobType::UNPAIR: return "Failed to unpair sensor";
+      default: return "Failed to pair sensor";
+    }
+  }
+  
+  // {"job":N,"type":...,"state":...[,"result":{...}]}; the result is what the endpoint
+  // returned when it still ran synchronously
+  void send_job(AsyncWebServerRequest *request, const Job &job) {
+    bool finished = job.state == JobState::DONE || job.state == JobState::FAILED;
+    bool done = job.state == JobState::DONE;
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
+    bool transfer = job.type == JobType::TEMPLATE_EXPORT || job.type == JobType::TEMPLATE_IMPORT;
+#else
+    bool transfer = false;
+#endif
+    bool batch = job.type == JobType::DELETE_BATCH || job.type == JobType::RENAME_BATCH;
+    // Results of these also name the ID, as the synchronous responses did
+    bool single = job.type == JobType::DELETE || job.type == JobType::ENROLL;
+    
+    if (this->wants_cbor(request)) {
+      CborResponse cbor(request);
+      cbor.begin_map(finished ? 4 : 3);
+      cbor.add_text("job");
+      cbor.add_uint(job.id);
+      cbor.add_text("type");
+      cbor.add_text(job_type_name(job.type));
+      cbor.add_text("state");
+      cbor.add_text(job_state_name(job.state));
+      if (finished) {
+        cbor.add_text("result");
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
+        if (done && job.type == JobType::TEMPLATE_EXPORT) {
+          cbor.begin_map(5);
+          cbor.add_text("id");
+          cbor.add_uint(job.slot);
+          cbor.add_text("name");
+          cbor.add_text(job.name.c_str(), job.name.size());
+          cbor.add_text("encoding");
+          cbor.add_text(template_encoding_name(job.encoding));
+          cbor.add_text("template");
+          cbor.add_bytes(job.data.data(), job.data.size());
+        } else if (done && job.type == JobType::TEMPLATE_IMPORT) {
+          cbor.begin_map(4);
+          cbor.add_text("status");
+          cbor.add_text("imported");
+          cbor.add_text("id");
+          cbor.add_uint(job.slot);
+          cbor.add_text("name");
+          cbor.add_text(job.name.c_str(), job.name.size());
+        } else
+#endif
+        if (done && job.type == JobType::VERIFY) {
+          this->encode_verify(cbor, job.verify);
+        } else if (done && job.type == JobType::IMAGE_CAPTURE) {
+          cbor.begin_map(2);
+          cbor.add_text("status");
+          cbor.add_text("captured");
+          cbor.add_text("bytes");
+          cbor.add_uint(job.bytes);
+        } else if (batch) {
+          bool rename = job.type == JobType::RENAME_BATCH;
+          cbor.begin_map(rename ? 3 : 2);
+          cbor.add_text(done ? "status" : "error");
+          cbor.add_text(done ? (rename ? "renamed" : "deleted") : job_error(job));
+          cbor.add_text("count");
+          cbor.add_uint(job.count);
+          if (rename) {
+            cbor.add_text("skipped");
+            cbor.begin_array(job.ids.size());
+            for (uint16_t id : job.ids)
+              cbor.add_uint(id);
+          }
+        } else if (single) {
+          bool named = done && job.type == JobType::ENROLL;
+          cbor.begin_map(named ? 3 : 2);
+          cbor.add_text(done ? "status" : "error");
+          cbor.add_text(done ? job_status(job.type) : job_error(job));
+          cbor.add_text("id");
+          cbor.add_uint(job.slot);
+          if (named) {
+            cbor.add_text("name");
+            cbor.add_text(job.name.c_str(), job.name.size());
+          }
+        } else {
+          cbor.begin_map(transfer ? 2 : 1);
+          cbor.add_text(done ? "status" : "error");
+          cbor.add_text(done ? job_status(job.type) : job_error(job));
+        }
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
+        if (transfer) {
+          cbor.add_text("transfer");
+          this->encode_transfer(cbor, job.stats);
+        }
+#endif
+      }
+      cbor.end();
+      return;
+    }
+    
+    std::string json = "{\"job\":" + std::to_string(job.id) + ",\"type\":\"" + job_type_name(job.type) +
+                       "\",\"state\":\"" + job_state_name(job.state) + "\"";
+    if (finished) {
+      json += ",\"result\":";
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
+      if (done && job.type == JobType::TEMPLATE_EXPORT) {
+        json += "{\"id\":" + std::to_string(job.slot) + ",\"name\":\"" + json_escape(job.name) + "\",\"encoding\":\"" +
+                template_encoding_name(job.encoding) + "\",\"template\":\"" + this->base64_encode(job.data) + "\"";
+      } else if (done && job.type == JobType::TEMPLATE_IMPORT) {
+        json += "{\"status\":\"imported\",\"id\":" + std::to_string(job.slot) + ",\"name\":\"" + json_escape(job.name) + "\"";
+      } else
+#endif
+      if (done && job.type == JobType::VERIFY) {
+        json += "{" + verify_fields(job.verify);
+      } else if (done && job.type == JobType::IMAGE_CAPTURE) {
+        json += "{\"status\":\"captured\",\"bytes\":" + std::to_string(job.bytes);
+      } else if (batch) {
+        json += done ? (job.type == JobType::RENAME_BATCH ? "{\"status\":\"renamed\"" : "{\"status\":\"deleted\"")
+                     : std::string("{\"error\":\"") + job_error(job) + "\"";
+        json += ",\"count\":" + std::to_string(job.count);
+        if (job.type == JobType::RENAME_BATCH) {
+          json += ",\"skipped\":[";
+          for (size_t i = 0; i < job.ids.size(); i++) {
+            if (i > 0)
+              json += ",";
+            json += std::to_string(job.ids[i]);
+          }
+          json += "]";
+        }
+      } else if (done) {
+        json += std::string("{\"status\":\"") + job_status(job.type) + "\"";
+      } else {
+        json += std::string("{\"error\":\"") + job_error(job) + "\"";
+      }
+      if (single) {
+        json += ",\"id\":" + std::to_string(job.slot);
+        if (done && job.type == JobType::ENROLL)
+          json += ",\"name\":\"" + json_escape(job.name) + "\"";
+      }
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
+      if (transfer)
+        json += ",\"transfer\":" + this->transfer_json(job.stats);
+#endif
+      json += "}";
+    }
+    json += "}";
+    this->send_cors_response(request, 200, "application/json", json);
+  }
+  
+  static void encode_verify(CborWriter &cbor, const VerifyResult &verify) {
+    cbor.begin_map(3);
+    cbor.add_text("result");
+    cbor.add_text(verify_state_name(verify.state));
+    cbor.add_text("id");
+    cbor.add_uint(verify.id);
+    cbor.add_text("confidence");
+    cbor.add_uint(verify.confidence);
+  }
+  
+  // "result":...,"id":...,"confidence":... without the braces
+  static std::string verify_fields(const VerifyResult &verify) {
+    char json[80];
+    snprintf(json, sizeof(json), "\"result\":\"%s\",\"id\":%u,\"confidence\":%u", verify_state_name(verify.state),
+             (unsigned) verify.id, (unsigned) verify.confidence);
+    return json;
+  }
+  
+  void send_verify(AsyncWebServerRequest *request) {
+    const VerifyResult &verify = this->parent_->get_last_verify();
+    if (this->wants_cbor(request)) {
+      CborResponse cbor(request);
+      encode_verify(cbor, verify);
+      cbor.end();
+      return;
+    }
+    this->send_cors_response(request, 200, "application/json", "{" + verify_fields(verify) + "}");
+  }
+  
+  void send_enroll_session(AsyncWebServerRequest *request) {
+    if (this->wants_cbor(request)) {
+      CborResponse cbor(request);
+      this->parent_->encode_enroll_session(cbor);
+      cbor.end();
+      return;
+    }
+    this->send_cors_response(request, 200, "application/json", this->parent_->get_enroll_session_json());
+  }
+  
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
   // Base64 encoding
   std::string base64_encode(const std::vector<uint8_t> &data) const {
     static const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
@@ -1457,14 +4506,18 @@ class FingerprintRequestHandler : public AsyncWebHandler {
     }
     return result;
   }
+#endif
   
  protected:
   FingerprintDoorbell *parent_;
   
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
   // Chunked import state
   uint16_t import_id_{0};
   std::string import_name_;
   std::string import_buffer_;
+  TemplateEncoding import_encoding_{TemplateEncoding::RAW};
+#endif
 };
 
 void FingerprintDoorbell::setup_web_server() {
@@ -1476,8 +4529,10 @@ void FingerprintDoorbell::setup_web_server() {
   
   base->init();
   base->add_handler(new FingerprintRequestHandler(this));
-  ESP_LOGI(TAG, "REST API registered at /fingerprint/*");
+  ESP_LOGI(TAG, "REST API registered at %s/*", this->rest_prefix_.c_str());
 }
 
+#endif  // USE_FINGERPRINT_DOORBELL_REST
+
 }  // namespace fingerprint_doorbell
 }  // namespace esphome
@@ -1,38 +1,169 @@
 #pragma once
 
 #include "esphome/core/component.h"
+#include "esphome/core/defines.h"
 #include "esphome/core/hal.h"
 #include "esphome/core/automation.h"
+#include "esphome/core/preferences.h"
+#include "esphome/core/helpers.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/text_sensor/text_sensor.h"
 #include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/uart/uart.h"
 #include "esphome/components/web_server_base/web_server_base.h"
-#include <map>
+#ifdef USE_TIME
+#include "esphome/components/time/real_time_clock.h"
+#endif
+#include <array>
+#include <functional>
 #include <vector>
 #include <Adafruit_Fingerprint.h>
+#include "access_policy.h"
+#include "cbor.h"
+#include "cold_store.h"
+#include "command_frames.h"
+#include "event_multicast.h"
+#include "id_list.h"
+#include "image_stream.h"
+#include "name_table.h"
+#include "sensor_link.h"
+#include "state_publisher.h"
+#include "template_codec.h"
+#include "trace.h"
 
 namespace esphome {
 namespace fingerprint_doorbell {
 
 enum class ScanResult { NO_FINGER, MATCH_FOUND, NO_MATCH_FOUND, ERROR };
-enum class Mode { SCAN, ENROLL, IDLE };
-enum class EnrollStep { IDLE, WAITING_FOR_FINGER, CONVERTING, WAITING_REMOVE, STORING, DONE };
+enum class Mode { SCAN, ENROLL };
+enum class EnrollStep {
+  IDLE, WAITING_FOR_FINGER, CONVERTING, WAITING_REMOVE, STORING, AUTO_RUNNING,
+  VERIFY_WAIT_REMOVE, VERIFY_WAITING_FOR_FINGER, DONE
+};
+
+// Highest fingerprint ID (max_fingerprints); above the sensor's library only with tiered storage
+#ifndef FINGERPRINT_DOORBELL_MAX_ID
+#define FINGERPRINT_DOORBELL_MAX_ID 200
+#endif
+static const uint16_t MAX_FINGERPRINT_ID = FINGERPRINT_DOORBELL_MAX_ID;
 
 struct Match {
   ScanResult scan_result = ScanResult::NO_FINGER;
   uint16_t match_id = 0;
-  std::string match_name = "unknown";
+  char match_name[NAME_BUFFER_SIZE] = "unknown";  // Copied, so no heap use on the scan path
   uint16_t match_confidence = 0;
   uint8_t return_code = 0;
 };
 
+enum class VerifyState : uint8_t { NONE, ARMED, MATCHED, NO_MATCH, NO_FINGER, TIMEOUT, ERROR };
+
+// Latest 1:1 verification of a claimed identity
+struct VerifyResult {
+  VerifyState state = VerifyState::NONE;
+  uint16_t id = 0;
+  uint16_t confidence = 0;
+};
+
+struct EnrollSessionEntry {
+  std::string name;
+  uint16_t id = 0;
+  std::string result = "pending";
+};
+
+// Outcome of a template export/import, reported back to the REST caller
+struct TransferStats {
+  uint8_t attempts = 0;
+  uint8_t checksum_errors = 0;
+  uint8_t timeouts = 0;
+  uint8_t verify_mismatches = 0;
+  bool verified = false;
+};
+
+// Tiered storage counters and timings, exported on /metrics
+struct TierStats {
+  uint32_t sensor_hits = 0;       // Library search found a hot ID
+  uint32_t cache_hits = 0;        // Library search found a promoted cold ID
+  uint32_t cold_hits = 0;         // Fallback matched a cold template (and promoted it)
+  uint32_t cold_misses = 0;       // Fallback ran and matched nothing
+  uint32_t cold_candidates = 0;   // Cold templates matched 1:1 by the fallback
+  uint32_t budget_exhausted = 0;  // Fallback stopped by its time budget or candidate limit
+  uint32_t promotions = 0;
+  uint32_t cold_errors = 0;       // Flash read or sensor transfer failures
+  uint32_t search_count = 0;      // Library searches and their time
+  uint64_t search_us = 0;
+  uint32_t search_max_us = 0;
+  uint32_t fallback_count = 0;    // Fallback runs and their time
+  uint64_t fallback_us = 0;
+  uint32_t fallback_max_us = 0;
+};
+
+// Slow sensor operations requested over REST. They are queued and run by the loop
+// task, which owns the sensor; the client polls GET <prefix>/jobs/<id>.
+enum class JobType : uint8_t {
+  TEMPLATE_EXPORT, TEMPLATE_IMPORT, DELETE_ALL, PAIR, ENROLL_SESSION, VERIFY, IMAGE_CAPTURE, DELETE_BATCH, RENAME_BATCH,
+  DELETE, ENROLL, CANCEL_ENROLL, UNPAIR
+};
+enum class JobState : uint8_t { QUEUED, RUNNING, DONE, FAILED };
+
+struct Job {
+  uint32_t id = 0;  // 0 = free slot
+  JobType type = JobType::TEMPLATE_EXPORT;
+  JobState state = JobState::QUEUED;
+  uint16_t slot = 0;  // Template slot for export/import, claimed ID for verify, ID to delete or enroll
+  std::string name;
+  uint32_t password = 0;
+  TemplateEncoding encoding = TemplateEncoding::RAW;
+  std::vector<uint8_t> data;  // Import input, export result
+  std::vector<std::string> names;  // Enrollment session input
+  std::vector<uint16_t> ids;  // Batch delete input, IDs a batch rename skipped
+  std::vector<std::pair<uint16_t, std::string>> renames;  // Batch rename input
+  uint16_t count = 0;  // Batch delete/rename: how many IDs it changed
+  TransferStats stats;
+  VerifyResult verify;  // Verification result
+  uint32_t wait_ms = 0;  // Image capture: how long to wait for a finger once it runs
+  uint32_t stream = 0;   // Image capture: ImageStream ticket of the request it streams to
+  uint32_t bytes = 0;    // Image capture: bytes uploaded
+  uint8_t code = 0;      // Image capture: FINGERPRINT_* code it ended with
+};
+
+// Fixed set of job slots shared by the web server task and the loop task. Finished
+// jobs stay readable until their slot is needed for a new one.
+class JobQueue {
+ public:
+  static const uint8_t CAPACITY = 4;
+
+  // Returns the new job's id, 0 if every slot holds an unfinished job
+  uint32_t submit(Job &&job);
+  // Next queued job, marked RUNNING; nullptr if there is none. With cancel_only (while
+  // an enrollment owns the sensor) only an enrollment cancel is taken.
+  Job *claim(bool cancel_only = false);
+  void complete(Job *job, bool success);
+  // Calls f(job) under the queue lock; false if the id is unknown or already evicted
+  template<typename F> bool with_job(uint32_t id, F f) {
+    LockGuard guard(this->lock_);
+    for (Job &job : this->jobs_) {
+      if (job.id == id && id != 0) {
+        f(job);
+        return true;
+      }
+    }
+    return false;
+  }
+
+ protected:
+  Mutex lock_;
+  std::array<Job, CAPACITY> jobs_;
+  uint32_t next_id_{1};
+};
+
 struct LedConfig {
   uint8_t color;
   uint8_t mode;
   uint8_t speed;
+  CommandFrame<5> frame{};  // Built in setup() once the config is final
 };
 
-class FingerprintDoorbell : public Component {
+class FingerprintDoorbell : public Component, public uart::UARTDevice {
  public:
   FingerprintDoorbell() = default;
 
@@ -44,8 +175,52 @@ class FingerprintDoorbell : public Component {
   // Configuration setters
   void set_touch_pin(GPIOPin *pin) { touch_pin_ = pin; }
   void set_doorbell_pin(GPIOPin *pin) { doorbell_pin_ = pin; }
+  void set_unlock_pin(GPIOPin *pin) { unlock_pin_ = pin; }
+  void set_unlock_duration(uint32_t duration_ms) { unlock_duration_ = duration_ms; }
+#ifdef USE_TIME
+  void set_time(time::RealTimeClock *clock) { time_ = clock; }
+#endif
+  // Empty `ids` allows every slot in this window
+  void add_access_window(uint8_t days, uint16_t start, uint16_t end, const std::vector<uint16_t> &ids);
   void set_ignore_touch_ring(bool ignore) { ignore_touch_ring_ = ignore; }
   void set_api_token(const std::string &token) { api_token_ = token; }
+  void set_preferences_namespace(const std::string &ns) { preferences_namespace_ = ns; }
+  void set_rest_prefix(const std::string &prefix) { rest_prefix_ = prefix; }
+  void set_auto_enroll(bool auto_enroll) { auto_enroll_ = auto_enroll; }
+  void set_enroll_verify_touches(uint8_t touches) { enroll_verify_touches_ = touches; }
+  void set_enroll_min_quality(uint16_t quality) { enroll_min_quality_ = quality; }
+  void set_enroll_retries(uint8_t retries) { enroll_retries_ = retries; }
+  void set_template_refresh(bool refresh) { template_refresh_ = refresh; }
+  void set_template_refresh_min_confidence(uint16_t confidence) { template_refresh_min_confidence_ = confidence; }
+  void set_template_refresh_interval(uint32_t interval_ms) { template_refresh_interval_ = interval_ms; }
+  void set_trace_buffer_size(uint16_t events) { trace_buffer_size_ = events; }
+  void set_capture_buffer_size(uint32_t bytes) { capture_buffer_size_ = bytes; }
+  // Per instance: the feature defines are global, so another instance may compile them in
+  void set_rest_api(bool enabled) { rest_api_ = enabled; }
+  void set_template_transfer(bool enabled) { template_transfer_ = enabled; }
+  // Management page, gzip-compressed into flash by the code generator
+  void set_web_ui(const uint8_t *data, size_t size, const char *etag) {
+    web_ui_data_ = data;
+    web_ui_size_ = size;
+    web_ui_etag_ = etag;
+  }
+  void set_template_transfer_retries(uint8_t retries) { template_transfer_retries_ = retries; }
+  void set_template_verify_upload(bool verify) { template_verify_upload_ = verify; }
+  void set_verify_min_confidence(uint16_t confidence) { verify_min_confidence_ = confidence; }
+#ifdef USE_FINGERPRINT_DOORBELL_MULTICAST
+  void set_event_multicast(const std::string &address, uint16_t port) {
+    multicast_address_ = address;
+    multicast_port_ = port;
+  }
+  void set_event_multicast_key(const std::vector<uint8_t> &key) { multicast_key_ = key; }
+#endif
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  void set_cold_storage_partition(const std::string &label) { cold_partition_ = label; }
+  void set_hot_slots(uint16_t slots) { hot_slots_ = slots; }
+  void set_cache_slots(uint8_t slots) { cache_slots_ = slots; }
+  void set_cold_search_max(uint8_t candidates) { cold_search_max_ = candidates; }
+  void set_cold_search_budget(uint32_t budget_ms) { cold_search_budget_ms_ = budget_ms; }
+#endif
 
   // LED configuration setters
   void set_led_ready(uint8_t color, uint8_t mode, uint8_t speed) {
@@ -73,38 +248,89 @@ class FingerprintDoorbell : public Component {
   void set_match_name_sensor(text_sensor::TextSensor *sensor) { match_name_sensor_ = sensor; }
   void set_ring_sensor(binary_sensor::BinarySensor *sensor) { ring_sensor_ = sensor; }
   void set_finger_sensor(binary_sensor::BinarySensor *sensor) { finger_sensor_ = sensor; }
+  void set_unlock_sensor(binary_sensor::BinarySensor *sensor) { unlock_sensor_ = sensor; }
   void set_enroll_status_sensor(text_sensor::TextSensor *sensor) { enroll_status_sensor_ = sensor; }
   void set_last_action_sensor(text_sensor::TextSensor *sensor) { last_action_sensor_ = sensor; }
 
   // Public methods for HA services and REST API
-  void start_enrollment(uint16_t id, const std::string &name);
+  bool start_enrollment(uint16_t id, const std::string &name);
   void cancel_enrollment();
+  bool start_enrollment_session(const std::vector<std::string> &names);
+  std::string get_enroll_session_json();
+  void encode_enroll_session(CborWriter &writer);
   bool delete_fingerprint(uint16_t id);
   bool delete_all_fingerprints();
   bool rename_fingerprint(uint16_t id, const std::string &new_name);
+  // Batch variants: one DeleteChar per contiguous run of `ids` (ascending) and one
+  // preference commit for all names. Both return the number of slots changed.
+  uint16_t delete_fingerprints(const std::vector<uint16_t> &ids);
+  // Renames enrolled IDs only; the others are skipped and added to `skipped` if given
+  uint16_t rename_fingerprints(const std::vector<std::pair<uint16_t, std::string>> &names,
+                               std::vector<uint16_t> *skipped = nullptr);
+  // 1:1 verification against slot `id`: now (one capture) or on the next touch
+  bool verify_fingerprint(uint16_t id);
+  bool arm_verify(uint16_t id, uint32_t timeout_ms);
+  const VerifyResult &get_last_verify() const { return last_verify_; }
+  // Access windows for one slot (bitmask), AccessPolicy::USE_DEFAULT restores the YAML allowlist
+  bool set_access_windows(uint16_t id, uint8_t windows);
+  const AccessPolicy<MAX_FINGERPRINT_ID> &get_access_policy() const { return access_policy_; }
+  bool has_unlock_pin() const { return unlock_pin_ != nullptr; }
   void set_ignore_touch_ring_state(bool state) { ignore_touch_ring_ = state; }
   uint16_t get_enrolled_count();
   std::string get_fingerprint_name(uint16_t id);
+  bool has_fingerprint(uint16_t id) const { return fingerprint_names_.has(id); }
+  uint16_t get_fingerprint_quality(uint16_t id);
   std::string get_fingerprint_list_json();
+  void encode_fingerprint_list(CborWriter &writer);
+  std::string get_metrics_prometheus();
+  TraceRecorder *get_trace() { return &trace_; }
+#ifdef USE_FINGERPRINT_DOORBELL_CAPTURE
+  LinkCapture *get_capture() { return &capture_; }
+#endif
   bool is_enrolling() { return mode_ == Mode::ENROLL; }
+  // Last enrollment step, e.g. "Place finger (2/5)"
+  const char *get_enroll_status() const { return enroll_status_; }
+  const uint8_t *get_web_ui_data() const { return web_ui_data_; }
+  size_t get_web_ui_size() const { return web_ui_size_; }
+  const char *get_web_ui_etag() const { return web_ui_etag_; }
   bool is_sensor_connected() { return sensor_connected_; }
   bool is_sensor_paired() { return sensor_paired_; }
   std::string get_api_token() { return api_token_; }
+  const std::string &get_rest_prefix() const { return rest_prefix_; }
+  bool has_template_transfer() const { return template_transfer_; }
   
+#ifdef USE_FINGERPRINT_DOORBELL_REST
   // Sensor pairing - requires password to be set before sensor works
   bool pair_sensor(uint32_t password);
   bool unpair_sensor();
   
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_TRANSFER
   // Template transfer methods for copying fingerprints between devices
-  bool get_template(uint16_t id, std::vector<uint8_t> &template_data);
-  bool upload_template(uint16_t id, const std::string &name, const std::vector<uint8_t> &template_data);
+  bool get_template(uint16_t id, std::vector<uint8_t> &template_data, TransferStats &stats);
+  // `tmpl` may be PackBits-compressed; it is decoded packet by packet while sending
+  bool upload_template(uint16_t id, const std::string &name, TemplateStream &tmpl, TransferStats &stats);
+#endif
+  
+  JobQueue &get_jobs() { return jobs_; }
+  ImageStream &get_image_stream() { return image_stream_; }
+#endif  // USE_FINGERPRINT_DOORBELL_REST
 
  protected:
   GPIOPin *touch_pin_{nullptr};
   GPIOPin *doorbell_pin_{nullptr};
+  GPIOPin *unlock_pin_{nullptr};
   bool ignore_touch_ring_{false};
   bool last_ignore_touch_ring_{false};
   std::string api_token_{};
+  std::string preferences_namespace_{};  // Empty keeps the single-sensor keys
+  std::string rest_prefix_{"/fingerprint"};
+  bool auto_enroll_{false};
+  uint8_t enroll_verify_touches_{0};  // 0 = no post-store verification
+  uint16_t enroll_min_quality_{50};
+  uint8_t enroll_retries_{1};
+  bool template_refresh_{false};
+  uint16_t template_refresh_min_confidence_{200};
+  uint32_t template_refresh_interval_{86400000};  // 24h
 
   // LED configurations (color, mode, speed)
   LedConfig led_ready_{2, 1, 100};    // blue, breathing, speed 100
@@ -113,6 +339,8 @@ class FingerprintDoorbell : public Component {
   LedConfig led_match_{3, 3, 0};      // purple, on, speed 0
   LedConfig led_scanning_{2, 2, 25};  // blue, flashing, speed 25
   LedConfig led_no_match_{1, 2, 25};  // red, flashing, speed 25
+  CommandFrame<5> led_ready_solid_frame_{};  // led_ready_ while the touch ring is ignored
+  CommandFrame<6> search_frame_{};  // Depends on the sensor's capacity, built on connect
 
   // Sensors
   sensor::Sensor *match_id_sensor_{nullptr};
@@ -120,29 +348,160 @@ class FingerprintDoorbell : public Component {
   text_sensor::TextSensor *match_name_sensor_{nullptr};
   binary_sensor::BinarySensor *ring_sensor_{nullptr};
   binary_sensor::BinarySensor *finger_sensor_{nullptr};
+  binary_sensor::BinarySensor *unlock_sensor_{nullptr};
   text_sensor::TextSensor *enroll_status_sensor_{nullptr};
   text_sensor::TextSensor *last_action_sensor_{nullptr};
+  // Publish buffer, reserved in setup() so events on the scan path don't allocate
+  std::string last_action_text_;
+  // States set during loop(), sent together at its end and only when changed
+  PublishSlot<sensor::Sensor, float> match_id_out_;
+  PublishSlot<sensor::Sensor, float> confidence_out_;
+  PublishSlot<text_sensor::TextSensor, std::string> match_name_out_;
+  PublishSlot<binary_sensor::BinarySensor, bool> ring_out_;
+  PublishSlot<binary_sensor::BinarySensor, bool> finger_out_;
+  PublishSlot<binary_sensor::BinarySensor, bool> unlock_out_;
+  PublishStats publish_stats_;
 
   // Internal state
   Adafruit_Fingerprint *finger_{nullptr};
-  HardwareSerial *hw_serial_{nullptr};
+  SensorLink link_;  // All sensor traffic goes through here (counters, RTT)
+  TraceRecorder trace_;
+#ifdef USE_FINGERPRINT_DOORBELL_CAPTURE
+  LinkCapture capture_;  // Raw sensor traffic for tools/fpcap.py
+#endif
+  uint16_t trace_buffer_size_{0};  // 0 = tracing disabled
+  uint32_t capture_buffer_size_{0};  // 0 = no traffic capture
+  bool rest_api_{true};
+  bool template_transfer_{true};
+  const uint8_t *web_ui_data_{nullptr};
+  size_t web_ui_size_{0};
+  const char *web_ui_etag_{""};
+  // Copy of the enroll status text for REST; a fixed buffer, read by the web server task
+  char enroll_status_[48]{};
   bool sensor_connected_{false};
   bool last_touch_state_{false};
-  std::map<uint16_t, std::string> fingerprint_names_;
+  NameTable<MAX_FINGERPRINT_ID> fingerprint_names_;
+  // Verification score per slot measured at enrollment (0 = not verified)
+  std::array<uint16_t, MAX_FINGERPRINT_ID + 1> fingerprint_quality_{};
+  ESPPreferenceObject quality_pref_;
   
   uint32_t last_match_time_{0};
   uint32_t last_ring_time_{0};
+  // When to reset the match sensors / doorbell output (0 = nothing pending)
+  uint32_t match_clear_time_{0};
+  uint32_t ring_clear_time_{0};
   uint16_t last_match_id_{0};
-  uint32_t last_connect_attempt_{0};
-  uint8_t connect_attempts_{0};
+  uint32_t scan_start_ms_{0};  // Start of the scan behind the next match or ring
+
+#ifdef USE_FINGERPRINT_DOORBELL_MULTICAST
+  EventMulticast multicast_;
+  std::string multicast_address_;  // Empty when this instance has event_multicast off
+  uint16_t multicast_port_{0};
+  std::vector<uint8_t> multicast_key_;  // event_multicast_key; empty = derived from api_token
+#endif
+
+  // Adaptive template refresh, run at the end of the loop() that published the match.
+  // Not persisted, so the interval starts over after a reboot.
+  std::array<uint32_t, MAX_FINGERPRINT_ID + 1> last_refresh_time_{};  // millis(), 0 = never
+  uint16_t refresh_id_{0};  // Matched ID whose template is refreshed once the event is out
+
+#ifdef USE_FINGERPRINT_DOORBELL_REST
+  JobQueue jobs_;
+  Job *waiting_job_{nullptr};  // Image capture that polls for its finger, one GetImage per loop()
+  ImageStream image_stream_;    // UpImage packets on their way to the HTTP response
+  uint32_t capture_deadline_{0};
+#endif
+
+  // Template transfer
+  uint8_t template_transfer_retries_{2};
+  bool template_verify_upload_{true};
+
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  // Tiered storage. IDs up to hot_slots_ live in the sensor slot of the same number.
+  // Higher (cold) IDs live in cold_, and the cache_slots_ sensor slots right above
+  // hot_slots_ hold the cold templates matched most recently.
+  static const uint8_t MAX_CACHE_SLOTS = 32;
+  static const uint8_t MAX_COLD_CANDIDATES = 32;
+  ColdStore cold_;
+  std::string cold_partition_;
+  uint16_t hot_slots_{170};
+  uint8_t cache_slots_{20};
+  uint8_t cold_search_max_{8};
+  uint32_t cold_search_budget_ms_{2000};
+  std::array<uint16_t, MAX_CACHE_SLOTS> cache_ids_{};  // Cold ID in each cache slot, 0 = free
+  std::array<uint32_t, MAX_CACHE_SLOTS> cache_last_match_{};  // millis(), 0 = never
+  // cache_ids_ as saved, with the slot layout it was written for
+  struct CacheMap {
+    uint16_t hot_slots;
+    uint16_t cache_slots;
+    std::array<uint16_t, MAX_CACHE_SLOTS> ids;
+  };
+  ESPPreferenceObject cache_pref_;
+  // Sensor slots that were cache slots when the map was saved; 0 = no map
+  uint16_t saved_cache_first_{0};
+  uint16_t saved_cache_last_{0};
+  std::vector<uint8_t> cold_buffer_;  // One template read from cold_
+  std::vector<uint32_t> cold_last_match_;  // Per cold ID (index id - hot_slots_ - 1)
+  uint16_t cold_cursor_{0};  // Where the fallback continues among the other cold IDs
+  bool tiers_checked_{false};
+  TierStats tier_stats_;
+#endif
+
+  // 1:1 verification of a claimed identity
+  uint16_t verify_min_confidence_{100};
+  VerifyResult last_verify_;
+  uint32_t verify_deadline_{0};  // millis() when an armed verification expires
+
+  // On-device unlock: the relay is driven from the match path, HA hears about it after
+  uint32_t unlock_duration_{1000};
+  uint32_t unlock_clear_time_{0};
+  AccessPolicy<MAX_FINGERPRINT_ID> access_policy_;
+  ESPPreferenceObject access_pref_;
+#ifdef USE_TIME
+  time::RealTimeClock *time_{nullptr};
+#endif
+  // Local time cached once a second so the match path never converts time
+  int8_t clock_day_{-1};  // 0 = Sunday, -1 = unknown
+  uint16_t clock_minute_{0};
+  uint32_t clock_updated_{0};
+  uint32_t unlock_count_{0};
+  uint32_t unlock_denied_count_{0};
+  uint32_t unlock_eval_last_us_{0};
+  uint32_t unlock_eval_max_us_{0};
+
+  // Link health and reconnect state machine
+  bool ever_connected_{false};
+  bool probe_pending_{false};
+  uint32_t probe_sent_time_{0};
+  uint32_t next_connect_attempt_{0};
+  uint32_t reconnect_backoff_ms_{50};
+  uint32_t connect_attempts_{0};
+  uint8_t consecutive_errors_{0};
+  uint32_t last_link_activity_{0};
+  uint32_t link_down_count_{0};
 
   // Enrollment state machine
   Mode mode_{Mode::SCAN};
   EnrollStep enroll_step_{EnrollStep::IDLE};
   uint16_t enroll_id_{0};
+  uint16_t enroll_slot_{0};  // Sensor slot the model is stored in; differs from enroll_id_ for cold IDs
   std::string enroll_name_;
   uint8_t enroll_sample_{0};
   uint32_t enroll_timeout_{0};
+  uint8_t enroll_attempt_{0};
+  uint8_t verify_touch_{0};
+  uint16_t verify_min_score_{0};
+  bool verify_stored_{false};  // Model already in its slot (AutoEnroll), else still in char buffer 1
+
+  // Sensor-side AutoEnroll state (falls back to manual steps if unsupported)
+  bool auto_enroll_supported_{true};
+  bool auto_enroll_acked_{false};
+  uint32_t auto_enroll_started_{0};
+
+  // Enrollment session (queue of names enrolled back to back)
+  std::vector<EnrollSessionEntry> session_entries_;
+  size_t session_index_{0};
+  bool session_active_{false};
 
   // Sensor pairing state
   bool sensor_paired_{false};
@@ -151,9 +510,89 @@ class FingerprintDoorbell : public Component {
   // Internal methods
   void load_sensor_password();
   void save_sensor_password();
-  bool connect_sensor();
+  void init_link();
+  void process_reconnect();
+  void schedule_reconnect();
+  void on_link_up();
+  void mark_link_down();
+  void track_link(uint8_t result);
+  void send_heartbeat();
+  uint8_t send_command(uint8_t *data, uint16_t length, Adafruit_Fingerprint_Packet &reply, uint16_t timeout_ms);
+  uint8_t send_frame(const uint8_t *frame, size_t size, Adafruit_Fingerprint_Packet &reply, uint16_t timeout_ms);
+  template<size_t N>
+  uint8_t send_frame(const std::array<uint8_t, N> &frame, Adafruit_Fingerprint_Packet &reply,
+                     uint16_t timeout_ms = 1000) {
+    return this->send_frame(frame.data(), N, reply, timeout_ms);
+  }
+  uint8_t get_image();
+  uint8_t image_to_template(uint8_t slot);
+  uint8_t search_templates(uint16_t &id, uint16_t &confidence);
+  void set_led(const CommandFrame<5> &frame);
   Match scan_fingerprint();
+  bool should_refresh_template(const Match &match);
+  void refresh_template(uint16_t id);
+  bool begin_enrollment(uint16_t id, const std::string &name, uint8_t attempt = 0);
   void process_enrollment();
+  void finish_enrollment(const char *result, bool abort_session = false);
+  bool read_index_table(std::vector<bool> &occupied, uint16_t last_slot);
+  bool read_slot_occupancy(std::vector<bool> &occupied);
+  void start_session_entry();
+  void start_auto_enroll();
+  void process_auto_enroll();
+  void cancel_auto_enroll();
+  void on_enrollment_stored();
+  void start_enroll_verification(bool stored);
+  void process_verify_touch();
+  void complete_enrollment(uint16_t quality);
+  uint8_t match_char_buffers(uint16_t &score);
+  uint8_t match_claimed(uint16_t id, uint16_t &confidence);
+  void process_armed_verify();
+  void finish_verify(uint8_t result, uint16_t confidence);
+  void publish_match(const Match &match, const char *action, bool refresh = false);
+  // Time since scan_start_ms_, saturated to the datagram's 16-bit field
+  uint16_t scan_elapsed_ms() const {
+    uint32_t elapsed = millis() - this->scan_start_ms_;
+    return elapsed > UINT16_MAX ? UINT16_MAX : elapsed;
+  }
+  bool try_unlock(uint16_t id);
+  void update_access_clock();
+  void load_access_overrides();
+#if defined(USE_FINGERPRINT_DOORBELL_REST) || defined(USE_FINGERPRINT_DOORBELL_TEMPLATE_IO)
+  uint8_t read_data_packet(uint8_t *data, uint16_t &length, uint8_t &type);
+#endif
+#ifdef USE_FINGERPRINT_DOORBELL_TEMPLATE_IO
+  uint8_t read_template_once(uint16_t id, std::vector<uint8_t> &template_data, TransferStats &stats);
+  uint8_t read_char_buffer(std::vector<uint8_t> &template_data, TransferStats &stats);
+  uint8_t send_template(uint8_t buffer, TemplateStream &tmpl, TransferStats &stats);
+  uint8_t write_template_once(uint16_t id, TemplateStream &tmpl, TransferStats &stats);
+#endif
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  bool is_cold_id(uint16_t id) const { return this->cold_.enabled() && id > this->hot_slots_; }
+  uint16_t cache_slot(uint8_t index) const { return this->hot_slots_ + 1 + index; }
+  int find_cache(uint16_t id) const;
+  int release_cache_slot(uint16_t id);
+  void assign_cache(int index, uint16_t id);
+  void uncache(int index);
+  void save_cache_map();
+  void setup_tiers();
+  void check_tiers(uint16_t capacity);
+  uint16_t resolve_slot(uint16_t slot);
+  uint8_t pick_cold_candidates(uint16_t *candidates, uint16_t &eligible);
+  bool search_cold(Match &match);
+  uint8_t load_cold(uint16_t id, uint8_t buffer);
+  uint8_t delete_cold(uint16_t id);
+  bool persist_cold(uint16_t id, uint16_t slot);
+#endif
+  // True if `id` is the sensor slot of the same number (always, without tiered storage)
+  bool in_sensor(uint16_t id) const {
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+    return !this->is_cold_id(id);
+#else
+    (void) id;
+    return true;
+#endif
+  }
+  uint8_t delete_template(uint16_t id);
   void update_touch_state(bool touched);
   bool is_ring_touched();
   void set_led_ring_ready();
@@ -162,12 +601,25 @@ class FingerprintDoorbell : public Component {
   void set_led_ring_match();
   void set_led_ring_scanning();
   void set_led_ring_no_match();
+  uint32_t pref_hash(const std::string &key) const;
   void load_fingerprint_names();
   void save_fingerprint_name(uint16_t id, const std::string &name);
   void delete_fingerprint_name(uint16_t id);
+  uint8_t delete_range(uint16_t first, uint16_t count);
+  void load_fingerprint_quality();
+  void save_fingerprint_quality(uint16_t id, uint16_t quality);
   void publish_enroll_status(const std::string &status);
   void publish_last_action(const std::string &action);
+  void publish_last_actionf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  void process_event_resets();
+  void process_loop();
+  void flush_publications();
+#ifdef USE_FINGERPRINT_DOORBELL_REST
+  bool process_jobs(bool cancel_only = false);
+  // One GetImage, then the UpImage packets into image_stream_; returns a FINGERPRINT_* code
+  uint8_t capture_image(uint32_t ticket, uint32_t &bytes);
   void setup_web_server();
+#endif
 };
 
 // ==================== AUTOMATION ACTIONS ====================
@@ -183,6 +635,34 @@ class EnrollAction : public Action<Ts...>, public Parented<FingerprintDoorbell>
   }
 };
 
+template<typename... Ts>
+class EnrollSessionAction : public Action<Ts...>, public Parented<FingerprintDoorbell> {
+ public:
+  // A braced list of names cannot deduce through TEMPLATABLE_VALUE's setter, so static
+  // lists and lambdas get their own setters (like uart.write)
+  void set_names_template(std::function<std::vector<std::string>(Ts...)> func) {
+    this->names_func_ = func;
+    this->static_ = false;
+  }
+  void set_names_static(const std::vector<std::string> &names) {
+    this->names_static_ = names;
+    this->static_ = true;
+  }
+
+  void play(Ts... x) override {
+    if (this->static_) {
+      this->parent_->start_enrollment_session(this->names_static_);
+    } else {
+      this->parent_->start_enrollment_session(this->names_func_(x...));
+    }
+  }
+
+ protected:
+  bool static_{false};
+  std::function<std::vector<std::string>(Ts...)> names_func_{};
+  std::vector<std::string> names_static_{};
+};
+
 template<typename... Ts>
 class CancelEnrollAction : public Action<Ts...>, public Parented<FingerprintDoorbell> {
  public:
@@ -201,6 +681,19 @@ class DeleteAction : public Action<Ts...>, public Parented<FingerprintDoorbell>
   }
 };
 
+template<typename... Ts>
+class DeleteBatchAction : public Action<Ts...>, public Parented<FingerprintDoorbell> {
+ public:
+  TEMPLATABLE_VALUE(std::string, ids)
+
+  void play(Ts... x) override {
+    // A malformed list leaves `ids` empty, which delete_fingerprints() reports
+    std::vector<uint16_t> ids;
+    parse_id_list(this->ids_.value(x...), MAX_FINGERPRINT_ID, ids);
+    this->parent_->delete_fingerprints(ids);
+  }
+};
+
 template<typename... Ts>
 class DeleteAllAction : public Action<Ts...>, public Parented<FingerprintDoorbell> {
  public:
@@ -209,6 +702,22 @@ class DeleteAllAction : public Action<Ts...>, public Parented<FingerprintDoorbel
   }
 };
 
+template<typename... Ts>
+class VerifyAction : public Action<Ts...>, public Parented<FingerprintDoorbell> {
+ public:
+  TEMPLATABLE_VALUE(uint16_t, finger_id)
+  TEMPLATABLE_VALUE(bool, arm)
+  TEMPLATABLE_VALUE(uint32_t, timeout)
+
+  void play(Ts... x) override {
+    if (this->arm_.value(x...)) {
+      this->parent_->arm_verify(this->finger_id_.value(x...), this->timeout_.value(x...));
+    } else {
+      this->parent_->verify_fingerprint(this->finger_id_.value(x...));
+    }
+  }
+};
+
 template<typename... Ts>
 class RenameAction : public Action<Ts...>, public Parented<FingerprintDoorbell> {
  public:
@@ -220,5 +729,17 @@ class RenameAction : public Action<Ts...>, public Parented<FingerprintDoorbell>
   }
 };
 
+template<typename... Ts>
+class RenameBatchAction : public Action<Ts...>, public Parented<FingerprintDoorbell> {
+ public:
+  TEMPLATABLE_VALUE(std::string, names)
+
+  void play(Ts... x) override {
+    std::vector<std::pair<uint16_t, std::string>> names;
+    parse_name_list(this->names_.value(x...), MAX_FINGERPRINT_ID, names);
+    this->parent_->rename_fingerprints(names);
+  }
+};
+
 }  // namespace fingerprint_doorbell
 }  // namespace esphome
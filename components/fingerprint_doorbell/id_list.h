@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// Parses a decimal number that fills all of [begin, end) and lies within min..max.
+// Signs, spaces, empty text and trailing characters are rejected.
+inline bool parse_number(const char *begin, const char *end, unsigned long min, unsigned long max,
+                         unsigned long &value) {
+  if (begin == end || *begin < '0' || *begin > '9')
+    return false;
+  char *next;
+  errno = 0;
+  value = strtoul(begin, &next, 10);
+  return next == end && errno == 0 && value >= min && value <= max;
+}
+
+inline bool parse_number(const std::string &text, unsigned long min, unsigned long max, unsigned long &value) {
+  return parse_number(text.c_str(), text.c_str() + text.size(), min, max, value);
+}
+
+// Parses "N" or "N-M" from [begin, end) into ids within 1..max_id; false if malformed
+inline bool parse_id_range(const char *begin, const char *end, uint16_t max_id, std::vector<uint16_t> &ids) {
+  char *next;
+  unsigned long first = strtoul(begin, &next, 10);
+  if (next == begin)
+    return false;
+  unsigned long last = first;
+  if (next < end && *next == '-') {
+    const char *second = next + 1;
+    last = strtoul(second, &next, 10);
+    if (next == second)
+      return false;
+  }
+  if (next != end || first < 1 || last < first || last > max_id)
+    return false;
+  for (unsigned long id = first; id <= last; id++)
+    ids.push_back(id);
+  return true;
+}
+
+// Parses "1,3,5-9" into ascending ids without duplicates. On a malformed entry `ids` is
+// left empty and false is returned.
+inline bool parse_id_list(const std::string &text, uint16_t max_id, std::vector<uint16_t> &ids) {
+  ids.clear();
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find(',', start);
+    if (end == std::string::npos)
+      end = text.size();
+    if (!parse_id_range(text.c_str() + start, text.c_str() + end, max_id, ids)) {
+      ids.clear();
+      return false;
+    }
+    start = end + 1;
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  return !ids.empty();
+}
+
+// Parses "1:Alice,2:Bob,10-15:Guest" into (id, name) pairs; a range gives every slot the
+// same name. On a malformed entry `names` is left empty and false is returned.
+inline bool parse_name_list(const std::string &text, uint16_t max_id,
+                            std::vector<std::pair<uint16_t, std::string>> &names) {
+  names.clear();
+  std::vector<uint16_t> ids;
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find(',', start);
+    if (end == std::string::npos)
+      end = text.size();
+    size_t colon = text.find(':', start);
+    ids.clear();
+    if (colon == std::string::npos || colon >= end || colon + 1 == end ||
+        !parse_id_range(text.c_str() + start, text.c_str() + colon, max_id, ids)) {
+      names.clear();
+      return false;
+    }
+    for (uint16_t id : ids)
+      names.emplace_back(id, text.substr(colon + 1, end - colon - 1));
+    start = end + 1;
+  }
+  return !names.empty();
+}
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
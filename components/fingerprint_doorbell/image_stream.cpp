@@ -0,0 +1,103 @@
+#include "image_stream.h"
+#include "esphome/core/hal.h"
+#include <cstring>
+#include <Adafruit_Fingerprint.h>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+uint32_t ImageStream::open() {
+  LockGuard guard(this->lock_);
+  if (this->ticket_ != 0)
+    return 0;
+  this->head_ = 0;
+  this->count_ = 0;
+  this->finished_ = false;
+  this->code_ = 0;
+  this->ticket_ = this->next_ticket_++;
+  if (this->next_ticket_ == 0)
+    this->next_ticket_ = 1;
+  return this->ticket_;
+}
+
+void ImageStream::close(uint32_t ticket) {
+  LockGuard guard(this->lock_);
+  if (this->ticket_ == ticket)
+    this->ticket_ = 0;
+}
+
+const uint8_t *ImageStream::next(uint32_t ticket, uint16_t &length, bool &ended, uint32_t timeout_ms) {
+  uint32_t start = millis();
+  for (;;) {
+    {
+      LockGuard guard(this->lock_);
+      ended = this->ticket_ != ticket || (this->finished_ && this->count_ == 0);
+      if (ended)
+        return nullptr;
+      if (this->count_ > 0) {
+        length = this->lengths_[this->head_];
+        return this->packets_[this->head_].data();
+      }
+    }
+    if (millis() - start >= timeout_ms)
+      return nullptr;
+    delay(2);  // A packet takes about 25 ms at 57600 baud
+  }
+}
+
+void ImageStream::release(uint32_t ticket) {
+  LockGuard guard(this->lock_);
+  if (this->ticket_ != ticket || this->count_ == 0)
+    return;
+  this->head_ = (this->head_ + 1) % SLOTS;
+  this->count_--;
+}
+
+uint8_t ImageStream::code() {
+  LockGuard guard(this->lock_);
+  return this->code_;
+}
+
+bool ImageStream::attached(uint32_t ticket) {
+  LockGuard guard(this->lock_);
+  return ticket != 0 && this->ticket_ == ticket && !this->finished_;
+}
+
+bool ImageStream::put(uint32_t ticket, const uint8_t *data, uint16_t length, uint32_t timeout_ms) {
+  if (length > PACKET_SIZE)
+    return false;
+  uint32_t start = millis();
+  for (;;) {
+    {
+      LockGuard guard(this->lock_);
+      if (ticket == 0 || this->ticket_ != ticket || this->finished_)
+        return false;
+      if (this->count_ < SLOTS) {
+        // Never the slot being sent: that one is at head_ while count_ > 0
+        uint8_t slot = (this->head_ + this->count_) % SLOTS;
+        memcpy(this->packets_[slot].data(), data, length);
+        this->lengths_[slot] = length;
+        this->count_++;
+        return true;
+      }
+      if (millis() - start >= timeout_ms) {
+        // The client stopped reading; it gets what was queued, then the error
+        this->finished_ = true;
+        this->code_ = FINGERPRINT_UPLOADFAIL;
+        return false;
+      }
+    }
+    delay(1);
+  }
+}
+
+void ImageStream::finish(uint32_t ticket, uint8_t code) {
+  LockGuard guard(this->lock_);
+  if (ticket == 0 || this->ticket_ != ticket || this->finished_)
+    return;
+  this->finished_ = true;
+  this->code_ = code;
+}
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
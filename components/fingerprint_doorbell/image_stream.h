@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// Hands the data packets of one UpImage upload from the loop task, which reads them
+// off the UART, to the web server task, which writes each into the HTTP response. Two
+// packet buffers: the loop fills one while the other is being sent, so the image is
+// never in RAM as a whole.
+//
+// One request streams at a time and holds a ticket. A capture job whose request has
+// gone (ticket closed or replaced) is refused by put(), and the job then only drains
+// the rest of the upload from the UART.
+class ImageStream {
+ public:
+  static const size_t PACKET_SIZE = 256;  // Largest data packet the sensor sends
+  static const uint8_t SLOTS = 2;
+
+  // Web server side. open() returns the ticket, 0 if another request is streaming.
+  uint32_t open();
+  void close(uint32_t ticket);
+  // Waits up to timeout_ms for the oldest unsent packet and returns it (the slot stays
+  // the caller's until release()). nullptr with `ended` set once the upload is over and
+  // every packet was taken (see code()), or with `ended` clear on a timeout.
+  const uint8_t *next(uint32_t ticket, uint16_t &length, bool &ended, uint32_t timeout_ms);
+  void release(uint32_t ticket);
+  uint8_t code();  // FINGERPRINT_* code the upload ended with
+
+  // Loop side
+  bool attached(uint32_t ticket);
+  // Copies one packet into a free slot, waiting up to timeout_ms for one. False if the
+  // request is gone or did not take its packets in time; it is then detached.
+  bool put(uint32_t ticket, const uint8_t *data, uint16_t length, uint32_t timeout_ms);
+  void finish(uint32_t ticket, uint8_t code);
+
+ protected:
+  Mutex lock_;
+  uint32_t ticket_{0};  // Open request, 0 = none
+  uint32_t next_ticket_{1};
+  std::array<std::array<uint8_t, PACKET_SIZE>, SLOTS> packets_{};
+  std::array<uint16_t, SLOTS> lengths_{};
+  uint8_t head_{0};   // Oldest unsent packet
+  uint8_t count_{0};  // Packets not yet released by the web server
+  bool finished_{false};
+  uint8_t code_{0};
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
@@ -0,0 +1,65 @@
+#include "link_capture.h"
+#include <esp_timer.h>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+void LinkCapture::init(uint32_t size) {
+  if (size == 0 || this->buffer_ != nullptr)
+    return;
+  // A power of two keeps position % size continuous when the 32-bit positions wrap
+  while (size & (size - 1))
+    size &= size - 1;
+  this->buffer_ = new uint8_t[size];
+  this->size_ = size;
+}
+
+void LinkCapture::clear() {
+  LockGuard guard(this->lock_);
+  this->tail_ = this->head_;
+  this->open_ = false;
+  this->dropped_records_ = 0;
+}
+
+void LinkCapture::make_room(uint32_t bytes) {
+  while (this->head_ - this->tail_ + bytes > this->size_) {
+    if (this->open_ && this->tail_ == this->open_start_)
+      this->open_ = false;  // The record being written is the oldest: start over
+    this->tail_ += HEADER_SIZE + this->at(this->tail_ + 5);
+    this->dropped_records_++;
+  }
+}
+
+void LinkCapture::record(uint8_t dir, uint8_t byte) {
+  if (this->buffer_ == nullptr)
+    return;
+  LockGuard guard(this->lock_);
+  if (this->paused_)
+    return;
+
+  uint32_t now = (uint32_t) esp_timer_get_time();
+  if (this->open_ && (dir != this->open_dir_ || this->at(this->open_start_ + 5) == 255 ||
+                      now - this->last_byte_us_ > RECORD_GAP_US))
+    this->open_ = false;
+  this->last_byte_us_ = now;
+
+  if (this->open_)
+    this->make_room(1);
+  if (!this->open_) {
+    this->make_room(HEADER_SIZE + 1);
+    this->open_start_ = this->head_;
+    this->open_dir_ = dir;
+    this->open_ = true;
+    this->put(now);
+    this->put(now >> 8);
+    this->put(now >> 16);
+    this->put(now >> 24);
+    this->put(dir);
+    this->put(0);
+  }
+  this->put(byte);
+  this->buffer_[(this->open_start_ + 5) % this->size_]++;
+}
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
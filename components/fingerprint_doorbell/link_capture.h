@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// RAM ring of the raw bytes on the sensor link, for replaying field problems at a
+// desk (tools/fpcap.py). Consecutive bytes in one direction form a record:
+//
+//   ts_us(4, little endian, low 32 bits of esp_timer) | dir(1, 0 = TX, 1 = RX) | len(1) | bytes
+//
+// A new record starts when the direction changes, the record is full or the link
+// was quiet for RECORD_GAP_US. When the ring is full the oldest records are dropped.
+class LinkCapture {
+ public:
+  static const uint8_t DIR_TX = 0;
+  static const uint8_t DIR_RX = 1;
+  static const size_t HEADER_SIZE = 6;
+  static const uint32_t RECORD_GAP_US = 1000;
+  // Dump starts with "FPCAP" and this format version
+  static const uint8_t FORMAT_VERSION = 1;
+
+  // Allocates the ring (size rounded down to a power of two); called once from setup()
+  void init(uint32_t size);
+  bool enabled() const { return this->buffer_ != nullptr; }
+
+  void record(uint8_t dir, uint8_t byte);
+  void clear();
+
+  // Writes the file header and every record, oldest first, through sink(data, length),
+  // which returns false to stop. Recording pauses meanwhile, so the ring is not
+  // locked while the sink talks to the network.
+  template<typename F> bool dump(F sink) {
+    {
+      LockGuard guard(this->lock_);
+      this->paused_ = true;
+    }
+    const uint8_t header[8] = {'F', 'P', 'C', 'A', 'P', FORMAT_VERSION, 0, 0};
+    bool ok = sink(header, sizeof(header));
+    uint32_t pos = this->tail_;
+    while (ok && pos != this->head_) {
+      size_t offset = pos % this->size_;
+      size_t length = this->head_ - pos;
+      if (length > this->size_ - offset)
+        length = this->size_ - offset;  // Up to the end of the ring, then wrap
+      ok = sink(this->buffer_ + offset, length);
+      pos += length;
+    }
+    LockGuard guard(this->lock_);
+    this->paused_ = false;
+    this->open_ = false;
+    return ok;
+  }
+
+  uint32_t used() const { return this->head_ - this->tail_; }
+  uint32_t size() const { return this->size_; }
+  uint32_t dropped_records() const { return this->dropped_records_; }
+
+ protected:
+  void put(uint8_t byte) { this->buffer_[this->head_++ % this->size_] = byte; }
+  uint8_t at(uint32_t pos) const { return this->buffer_[pos % this->size_]; }
+  // Drops oldest records until `bytes` more fit
+  void make_room(uint32_t bytes);
+
+  Mutex lock_;
+  uint8_t *buffer_{nullptr};
+  uint32_t size_{0};
+  // Absolute positions; the ring index is position % size_
+  uint32_t head_{0};
+  uint32_t tail_{0};
+  uint32_t open_start_{0};
+  bool open_{false};
+  bool paused_{false};
+  uint8_t open_dir_{0};
+  uint32_t last_byte_us_{0};
+  uint32_t dropped_records_{0};
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
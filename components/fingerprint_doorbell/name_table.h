@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+static const size_t NAME_BUFFER_SIZE = 32;  // Names are stored as 31 chars + terminator
+
+// Fingerprint names indexed by slot: one fixed 32-byte entry per slot (the same width
+// as on flash) plus an occupancy bitmap. Lookups are O(1), iteration walks contiguous
+// memory, and the whole table is sized up front - nothing is allocated per name.
+template<uint16_t MaxId> class NameTable {
+ public:
+  using Entry = std::array<char, NAME_BUFFER_SIZE>;
+
+  bool has(uint16_t id) const { return id <= MaxId && (this->used_[id / 32] >> (id % 32)) & 1; }
+
+  // Name in slot `id`, nullptr if the slot has none
+  const char *get(uint16_t id) const { return this->has(id) ? this->names_[id].data() : nullptr; }
+
+  // Longer names are truncated to 31 characters
+  void set(uint16_t id, const char *name) {
+    if (id > MaxId)
+      return;
+    Entry &entry = this->names_[id];
+    size_t len = std::min(strlen(name), entry.size() - 1);
+    memcpy(entry.data(), name, len);
+    entry[len] = '\0';
+    if (!this->has(id)) {
+      this->used_[id / 32] |= 1u << (id % 32);
+      this->count_++;
+    }
+  }
+
+  void erase(uint16_t id) {
+    if (!this->has(id))
+      return;
+    this->used_[id / 32] &= ~(1u << (id % 32));
+    this->names_[id].fill('\0');
+    this->count_--;
+  }
+
+  void clear() {
+    this->used_.fill(0);
+    this->count_ = 0;
+  }
+
+  uint16_t size() const { return this->count_; }
+
+  // Calls f(id, name) for every named slot in ascending id order
+  template<typename F> void for_each(F f) const {
+    for (size_t word = 0; word < this->used_.size(); word++) {
+      uint32_t bits = this->used_[word];
+      while (bits != 0) {
+        uint16_t id = word * 32 + __builtin_ctz(bits);
+        bits &= bits - 1;
+        f(id, this->names_[id].data());
+      }
+    }
+  }
+
+ protected:
+  std::array<Entry, MaxId + 1> names_{};
+  std::array<uint32_t, (MaxId + 32) / 32> used_{};
+  uint16_t count_{0};
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
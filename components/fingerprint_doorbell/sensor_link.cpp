@@ -0,0 +1,219 @@
+#include "sensor_link.h"
+#include "esphome/core/hal.h"
+#include <Adafruit_Fingerprint.h>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// ==================== PACKET PARSER ====================
+
+PacketParser::Event PacketParser::feed(uint8_t byte) {
+  switch (this->state_) {
+    case START_HIGH:
+      if (byte == 0xEF) {
+        this->state_ = START_LOW;
+      } else {
+        this->skipped_bytes_++;
+      }
+      return NONE;
+
+    case START_LOW:
+      if (byte == 0x01) {
+        this->state_ = ADDRESS;
+        this->address_read_ = 0;
+      } else {
+        // The 0xEF was noise; a new 0xEF may still start a packet
+        this->skipped_bytes_++;
+        if (byte != 0xEF) {
+          this->skipped_bytes_++;
+          this->state_ = START_HIGH;
+        }
+      }
+      return NONE;
+
+    case ADDRESS:
+      if (++this->address_read_ == 4)
+        this->state_ = TYPE;
+      return NONE;
+
+    case TYPE:
+      this->type_ = byte;
+      this->sum_ = byte;
+      this->state_ = LENGTH_HIGH;
+      return NONE;
+
+    case LENGTH_HIGH:
+      this->length_ = byte << 8;
+      this->sum_ += byte;
+      this->state_ = LENGTH_LOW;
+      return NONE;
+
+    case LENGTH_LOW:
+      this->length_ |= byte;
+      this->sum_ += byte;
+      this->data_read_ = 0;
+      // Length covers data + 2 checksum bytes; anything else means we lost sync
+      if (this->length_ < 2 || this->length_ > 258) {
+        this->skipped_bytes_ += 9;
+        this->state_ = START_HIGH;
+      } else {
+        this->state_ = this->length_ == 2 ? CHECKSUM_HIGH : DATA;
+      }
+      return NONE;
+
+    case DATA:
+      if (this->data_read_ == 0)
+        this->first_data_ = byte;
+      this->sum_ += byte;
+      if (++this->data_read_ == this->length_ - 2)
+        this->state_ = CHECKSUM_HIGH;
+      return NONE;
+
+    case CHECKSUM_HIGH:
+      this->checksum_ = byte << 8;
+      this->state_ = CHECKSUM_LOW;
+      return NONE;
+
+    case CHECKSUM_LOW:
+      this->checksum_ |= byte;
+      this->state_ = START_HIGH;
+      return this->checksum_ == this->sum_ ? PACKET : CHECKSUM_ERROR;
+  }
+  return NONE;
+}
+
+// ==================== SENSOR LINK ====================
+
+const char *SensorLink::command_name(uint8_t command) {
+  switch (command) {
+    case 0x01: return "get_image";
+    case 0x02: return "image2tz";
+    case 0x03: return "match";
+    case 0x04: return "search";
+    case 0x05: return "reg_model";
+    case 0x06: return "store";
+    case 0x07: return "load_char";
+    case 0x08: return "up_char";
+    case 0x09: return "down_char";
+    case 0x0A: return "up_image";
+    case 0x0C: return "delete";
+    case 0x0D: return "empty";
+    case 0x0F: return "read_sys_param";
+    case 0x12: return "set_password";
+    case 0x13: return "verify_password";
+    case 0x1D: return "template_count";
+    case 0x1F: return "read_index_table";
+    case 0x30: return "cancel";
+    case 0x31: return "auto_enroll";
+    case 0x35: return "aura_led";
+    case 0x40: return "handshake";
+    default: return nullptr;
+  }
+}
+
+const char *SensorLink::trace_name(uint8_t command) const {
+  const char *name = command_name(command);
+  return name != nullptr ? name : "sensor_command";
+}
+
+int SensorLink::peek() {
+  uint8_t byte;
+  return this->uart_->peek_byte(&byte) ? byte : -1;
+}
+
+int SensorLink::read() {
+  uint8_t byte;
+  if (!this->uart_->read_byte(&byte))
+    return -1;
+  this->on_rx_byte(byte);
+  return byte;
+}
+
+size_t SensorLink::write(uint8_t byte) {
+  this->on_tx_byte(byte);
+  this->uart_->write_array(&byte, 1);
+  return 1;
+}
+
+size_t SensorLink::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++)
+    this->on_tx_byte(buffer[i]);
+  this->uart_->write_array(buffer, size);
+  return size;
+}
+
+void SensorLink::drain() {
+  while (this->uart_->available())
+    this->read();
+}
+
+void SensorLink::on_rx_byte(uint8_t byte) {
+  this->rx_bytes_++;
+#ifdef USE_FINGERPRINT_DOORBELL_CAPTURE
+  if (this->capture_ != nullptr)
+    this->capture_->record(LinkCapture::DIR_RX, byte);
+#endif
+  PacketParser::Event event = this->rx_parser_.feed(byte);
+  if (event == PacketParser::CHECKSUM_ERROR) {
+    this->checksum_errors_++;
+    return;
+  }
+  if (event != PacketParser::PACKET)
+    return;
+
+  this->rx_packets_++;
+  if (this->rx_parser_.type() == FINGERPRINT_ACKPACKET && this->command_pending_) {
+    this->command_pending_ = false;
+    if (this->trace_ != nullptr)
+      this->trace_->end(this->trace_name(this->pending_command_));
+    CommandStats *stats = this->stats_for(this->pending_command_);
+    if (stats != nullptr) {
+      uint32_t rtt = micros() - this->pending_since_us_;
+      stats->count++;
+      stats->total_us += rtt;
+      if (rtt > stats->max_us)
+        stats->max_us = rtt;
+    }
+  }
+}
+
+void SensorLink::on_tx_byte(uint8_t byte) {
+  this->tx_bytes_++;
+#ifdef USE_FINGERPRINT_DOORBELL_CAPTURE
+  if (this->capture_ != nullptr)
+    this->capture_->record(LinkCapture::DIR_TX, byte);
+#endif
+  if (this->tx_parser_.feed(byte) != PacketParser::PACKET)
+    return;
+
+  this->tx_packets_++;
+  if (this->tx_parser_.type() != FINGERPRINT_COMMANDPACKET)
+    return;
+
+  // A new command while the previous one never got its ack: that one timed out
+  if (this->command_pending_) {
+    this->timeouts_++;
+    if (this->trace_ != nullptr)
+      this->trace_->end(this->trace_name(this->pending_command_));
+  }
+  this->command_pending_ = true;
+  this->pending_command_ = this->tx_parser_.first_data();
+  this->pending_since_us_ = micros();
+  if (this->trace_ != nullptr)
+    this->trace_->begin(this->trace_name(this->pending_command_));
+}
+
+CommandStats *SensorLink::stats_for(uint8_t command) {
+  for (uint8_t i = 0; i < this->command_stats_count_; i++) {
+    if (this->command_stats_[i].command == command)
+      return &this->command_stats_[i];
+  }
+  if (this->command_stats_count_ == MAX_COMMAND_STATS)
+    return nullptr;
+  CommandStats *stats = &this->command_stats_[this->command_stats_count_++];
+  stats->command = command;
+  return stats;
+}
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+#include "esphome/core/defines.h"
+#include "esphome/components/uart/uart.h"
+#include "link_capture.h"
+#include "trace.h"
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// Incremental parser for R503 packets: EF01 | addr(4) | type | len(2) | data | checksum(2)
+class PacketParser {
+ public:
+  enum Event { NONE, PACKET, CHECKSUM_ERROR };
+
+  // Feed one byte; returns PACKET/CHECKSUM_ERROR when a packet is complete
+  Event feed(uint8_t byte);
+
+  uint8_t type() const { return this->type_; }
+  uint8_t first_data() const { return this->first_data_; }
+  // Bytes discarded while hunting for the 0xEF01 start code
+  uint32_t skipped_bytes() const { return this->skipped_bytes_; }
+
+ protected:
+  enum State { START_HIGH, START_LOW, ADDRESS, TYPE, LENGTH_HIGH, LENGTH_LOW, DATA, CHECKSUM_HIGH, CHECKSUM_LOW };
+
+  State state_{START_HIGH};
+  uint8_t address_read_{0};
+  uint8_t type_{0};
+  uint8_t first_data_{0};
+  uint16_t length_{0};
+  uint16_t data_read_{0};
+  uint16_t sum_{0};
+  uint16_t checksum_{0};
+  uint32_t skipped_bytes_{0};
+};
+
+struct CommandStats {
+  uint8_t command{0};
+  uint32_t count{0};
+  uint64_t total_us{0};
+  uint32_t max_us{0};
+};
+
+// Stream between Adafruit_Fingerprint (and our raw packet code) and an ESPHome UART.
+// It forwards every byte unchanged and parses both directions on the side to keep
+// link-layer counters: bytes, packets, checksum failures, resyncs, unanswered
+// commands and round-trip time per command. With a trace recorder attached, each
+// command also becomes a begin/end span from its last TX byte to its ack, and with a
+// capture ring attached every byte is recorded with its timestamp.
+class SensorLink : public Stream {
+ public:
+  static const uint8_t MAX_COMMAND_STATS = 24;
+
+  // Short name for a command byte, nullptr for commands we never send
+  static const char *command_name(uint8_t command);
+
+  void set_uart(uart::UARTComponent *uart) { this->uart_ = uart; }
+  void set_trace(TraceRecorder *trace) { this->trace_ = trace; }
+#ifdef USE_FINGERPRINT_DOORBELL_CAPTURE
+  void set_capture(LinkCapture *capture) { this->capture_ = capture; }
+#endif
+
+  int available() override { return this->uart_->available(); }
+  int peek() override;
+  int read() override;
+  size_t write(uint8_t byte) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  void flush() override { this->uart_->flush(); }
+  using Print::write;
+
+  // Drop whatever is waiting in the RX buffer (counted as received bytes)
+  void drain();
+
+  uint32_t tx_bytes() const { return this->tx_bytes_; }
+  uint32_t rx_bytes() const { return this->rx_bytes_; }
+  uint32_t tx_packets() const { return this->tx_packets_; }
+  uint32_t rx_packets() const { return this->rx_packets_; }
+  uint32_t checksum_errors() const { return this->checksum_errors_; }
+  uint32_t timeouts() const { return this->timeouts_; }
+  uint32_t resync_bytes() const { return this->rx_parser_.skipped_bytes(); }
+  const CommandStats *command_stats() const { return this->command_stats_; }
+  uint8_t command_stats_count() const { return this->command_stats_count_; }
+
+ protected:
+  void on_rx_byte(uint8_t byte);
+  void on_tx_byte(uint8_t byte);
+  CommandStats *stats_for(uint8_t command);
+
+  const char *trace_name(uint8_t command) const;
+
+  uart::UARTComponent *uart_{nullptr};
+  TraceRecorder *trace_{nullptr};
+#ifdef USE_FINGERPRINT_DOORBELL_CAPTURE
+  LinkCapture *capture_{nullptr};
+#endif
+  PacketParser rx_parser_;
+  PacketParser tx_parser_;
+
+  uint32_t tx_bytes_{0};
+  uint32_t rx_bytes_{0};
+  uint32_t tx_packets_{0};
+  uint32_t rx_packets_{0};
+  uint32_t checksum_errors_{0};
+  uint32_t timeouts_{0};
+
+  // Command currently waiting for its ack
+  bool command_pending_{false};
+  uint8_t pending_command_{0};
+  uint32_t pending_since_us_{0};
+
+  CommandStats command_stats_[MAX_COMMAND_STATS];
+  uint8_t command_stats_count_{0};
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
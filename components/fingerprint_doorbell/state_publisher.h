@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "esphome/components/sensor/sensor.h"
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// Counters over all PublishSlots, exported on /metrics
+struct PublishStats {
+  uint32_t published{0};
+  uint32_t suppressed{0};  // Equal to the value last sent, dropped
+  uint32_t coalesced{0};   // Replaced by a newer value before it went out
+  uint32_t deferred{0};    // Held back by a slot's rate limit
+};
+
+// A sensor with force_update set wants every value, changed or not
+inline bool forces_update(sensor::Sensor *entity) { return entity->get_force_update(); }
+template<typename E> bool forces_update(E * /*entity*/) { return false; }
+
+// Outgoing state of one entity. set() only stages the value; flush() sends it unless it
+// equals the value last sent. With a minimum interval, a change within that time of
+// the previous publish is held and the newest value goes out once the interval is
+// over, so flapping states cost one publish per interval. Main loop task only.
+template<typename E, typename T> class PublishSlot {
+ public:
+  void init(E *entity, uint32_t min_interval_ms = 0) {
+    this->entity_ = entity;
+    this->min_interval_ms_ = min_interval_ms;
+  }
+  // For string slots: capacity for values up to `size` chars, so set() does not allocate
+  void reserve(size_t size) {
+    this->value_.reserve(size);
+    this->last_.reserve(size);
+  }
+
+  template<typename V> void set(const V &value, PublishStats &stats) {
+    if (this->entity_ == nullptr)
+      return;
+    if (this->pending_)
+      stats.coalesced++;
+    this->value_ = value;
+    this->pending_ = true;
+  }
+
+  void flush(uint32_t now, PublishStats &stats) {
+    if (!this->pending_)
+      return;
+    if (this->sent_ && this->value_ == this->last_ && !forces_update(this->entity_)) {
+      this->pending_ = false;
+      this->held_ = false;
+      stats.suppressed++;
+      return;
+    }
+    if (this->sent_ && now - this->last_publish_ms_ < this->min_interval_ms_) {
+      if (!this->held_)
+        stats.deferred++;
+      this->held_ = true;
+      return;
+    }
+    this->pending_ = false;
+    this->held_ = false;
+    this->sent_ = true;
+    this->last_ = this->value_;
+    this->last_publish_ms_ = now;
+    stats.published++;
+    this->entity_->publish_state(this->value_);
+  }
+
+ protected:
+  E *entity_{nullptr};
+  T value_{};
+  T last_{};
+  uint32_t min_interval_ms_{0};
+  uint32_t last_publish_ms_{0};
+  bool pending_{false};
+  bool held_{false};
+  bool sent_{false};
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
@@ -0,0 +1,130 @@
+#include "template_codec.h"
+#include <cstring>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+static const size_t PACKBITS_MAX_RUN = 128;
+
+// Templates are padded to their full size with either byte
+static bool is_padding(uint8_t byte) { return byte == 0x00 || byte == 0xFF; }
+
+bool parse_template_encoding(const std::string &name, TemplateEncoding &encoding) {
+  if (name == "raw") {
+    encoding = TemplateEncoding::RAW;
+    return true;
+  }
+  if (name == "packbits") {
+    encoding = TemplateEncoding::PACKBITS;
+    return true;
+  }
+  return false;
+}
+
+const char *template_encoding_name(TemplateEncoding encoding) {
+  return encoding == TemplateEncoding::PACKBITS ? "packbits" : "raw";
+}
+
+std::vector<uint8_t> packbits_encode(const uint8_t *data, size_t length) {
+  std::vector<uint8_t> out;
+  out.reserve(length / 4 + 16);
+  size_t i = 0;
+  while (i < length) {
+    // Repeat run: two or more equal bytes
+    size_t run = 1;
+    while (i + run < length && run < PACKBITS_MAX_RUN && data[i + run] == data[i])
+      run++;
+    if (run >= 2) {
+      out.push_back(static_cast<uint8_t>(257 - run));
+      out.push_back(data[i]);
+      i += run;
+      continue;
+    }
+    // Literal run: up to the next pair of equal bytes
+    size_t start = i;
+    while (i < length && i - start < PACKBITS_MAX_RUN && (i + 1 >= length || data[i] != data[i + 1]))
+      i++;
+    out.push_back(static_cast<uint8_t>(i - start - 1));
+    out.insert(out.end(), data + start, data + i);
+  }
+  return out;
+}
+
+TemplateStream::TemplateStream(const uint8_t *data, size_t length, TemplateEncoding encoding)
+    : data_(data), length_(length), encoding_(encoding) {
+  if (encoding != TemplateEncoding::PACKBITS) {
+    this->size_ = length;
+    this->content_size_ = length;
+    while (this->content_size_ > 0 && is_padding(data[this->content_size_ - 1]))
+      this->content_size_--;
+    return;
+  }
+  // Walk the headers once to learn the decoded size and reject truncated input
+  size_t decoded = 0;
+  size_t content = 0;
+  size_t pos = 0;
+  while (pos < length) {
+    uint8_t header = data[pos++];
+    if (header < 128) {
+      for (size_t i = 0; i <= header && pos + i < length; i++) {
+        if (!is_padding(data[pos + i]))
+          content = decoded + i + 1;
+      }
+      pos += header + 1;
+      decoded += header + 1;
+    } else if (header > 128) {
+      if (pos < length && !is_padding(data[pos]))
+        content = decoded + 257 - header;
+      pos += 1;
+      decoded += 257 - header;
+    }
+  }
+  this->size_ = pos == length ? decoded : 0;
+  this->content_size_ = pos == length ? content : 0;
+}
+
+void TemplateStream::rewind() {
+  this->position_ = 0;
+  this->run_left_ = 0;
+}
+
+size_t TemplateStream::read(uint8_t *out, size_t length) {
+  if (this->encoding_ != TemplateEncoding::PACKBITS) {
+    size_t count = this->length_ - this->position_;
+    if (count > length)
+      count = length;
+    memcpy(out, this->data_ + this->position_, count);
+    this->position_ += count;
+    return count;
+  }
+
+  size_t copied = 0;
+  while (copied < length) {
+    if (this->run_left_ == 0) {
+      if (this->position_ >= this->length_)
+        break;
+      uint8_t header = this->data_[this->position_++];
+      if (header == 128)
+        continue;  // No-op header
+      this->run_repeat_ = header > 128;
+      this->run_left_ = this->run_repeat_ ? 257 - header : header + 1;
+      if (this->position_ >= this->length_)
+        break;  // Truncated; size() is 0 for such input anyway
+    }
+    size_t count = this->run_left_ < length - copied ? this->run_left_ : length - copied;
+    if (this->run_repeat_) {
+      memset(out + copied, this->data_[this->position_], count);
+      if (this->run_left_ == count)
+        this->position_++;
+    } else {
+      memcpy(out + copied, this->data_ + this->position_, count);
+      this->position_ += count;
+    }
+    this->run_left_ -= count;
+    copied += count;
+  }
+  return copied;
+}
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// Wire encodings for exported/imported templates. PACKBITS is byte-oriented run-length
+// coding: a header byte 0..127 is followed by that many + 1 literal bytes, a header
+// 129..255 by one byte that repeats 257 - header times (2..128). R503 templates are
+// mostly padding, so this shrinks them several times at almost no CPU cost.
+enum class TemplateEncoding : uint8_t {
+  RAW,
+  PACKBITS,
+};
+
+// "raw" / "packbits"; returns false for anything else
+bool parse_template_encoding(const std::string &name, TemplateEncoding &encoding);
+const char *template_encoding_name(TemplateEncoding encoding);
+
+std::vector<uint8_t> packbits_encode(const uint8_t *data, size_t length);
+
+// Sequential reader over a template in either encoding. PackBits data is decoded on
+// the fly as packets are filled, so a compressed template is never expanded in RAM.
+// The data must outlive the stream.
+class TemplateStream {
+ public:
+  TemplateStream(const uint8_t *data, size_t length, TemplateEncoding encoding);
+
+  // Decoded size in bytes; 0 if PackBits data is truncated
+  size_t size() const { return this->size_; }
+  // Decoded size without the trailing 0x00/0xFF padding, the part a sensor must keep as is
+  size_t content_size() const { return this->content_size_; }
+
+  // Starts over from the first byte (each transfer attempt reads the template again)
+  void rewind();
+  // Copies up to `length` decoded bytes into `out` and returns how many were copied
+  size_t read(uint8_t *out, size_t length);
+
+ protected:
+  const uint8_t *data_;
+  size_t length_;
+  TemplateEncoding encoding_;
+  size_t size_{0};
+  size_t content_size_{0};
+  size_t position_{0};
+  // Remaining bytes of the PackBits run being decoded
+  uint8_t run_left_{0};
+  bool run_repeat_{false};
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
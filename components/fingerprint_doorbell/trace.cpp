@@ -0,0 +1,55 @@
+#include "trace.h"
+#include <cstdio>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+static const uint8_t TID_LOOP = 1;
+static const uint8_t TID_OTHER = 2;
+
+void TraceRecorder::init(uint16_t capacity) {
+  if (capacity == 0 || this->events_ != nullptr)
+    return;
+  this->events_ = new Event[capacity]();
+  this->capacity_ = capacity;
+  this->main_task_ = xTaskGetCurrentTaskHandle();
+}
+
+void TraceRecorder::record(const char *name, char phase) {
+  uint32_t slot = this->head_.fetch_add(1, std::memory_order_relaxed) % this->capacity_;
+  Event &event = this->events_[slot];
+  event.ts_us = esp_timer_get_time();
+  event.name = name;
+  event.phase = phase;
+  event.tid = xTaskGetCurrentTaskHandle() == this->main_task_ ? TID_LOOP : TID_OTHER;
+}
+
+std::string TraceRecorder::dump_chrome_json() const {
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"loop\"}},";
+  json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"web_server\"}}";
+  if (this->events_ == nullptr)
+    return json + "]}";
+
+  uint32_t head = this->head_.load(std::memory_order_relaxed);
+  uint32_t count = head < this->capacity_ ? head : this->capacity_;
+  json.reserve(json.size() + count * 64 + 2);
+
+  char buf[96];
+  for (uint32_t i = head - count; i != head; i++) {
+    const Event &event = this->events_[i % this->capacity_];
+    if (event.name == nullptr)
+      continue;
+    snprintf(buf, sizeof(buf), ",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%u}", event.name,
+             event.phase, (long long) event.ts_us, (unsigned) event.tid);
+    json += buf;
+  }
+  json += "]}";
+  return json;
+}
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
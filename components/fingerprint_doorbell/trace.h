@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace esphome {
+namespace fingerprint_doorbell {
+
+// Fixed ring of begin/end events with microsecond timestamps, dumped as Chrome
+// trace-event JSON (chrome://tracing, Perfetto). Recording is lock-free so the
+// loop task and the web server task can both write; names must be string literals.
+class TraceRecorder {
+ public:
+  // Allocates the ring; the calling task is shown as the main loop thread
+  void init(uint16_t capacity);
+  bool enabled() const { return this->events_ != nullptr; }
+
+  void begin(const char *name) {
+    if (this->events_ != nullptr)
+      this->record(name, 'B');
+  }
+  void end(const char *name) {
+    if (this->events_ != nullptr)
+      this->record(name, 'E');
+  }
+
+  std::string dump_chrome_json() const;
+
+ protected:
+  struct Event {
+    int64_t ts_us;
+    const char *name;
+    char phase;
+    uint8_t tid;
+  };
+
+  void record(const char *name, char phase);
+
+  Event *events_{nullptr};
+  uint16_t capacity_{0};
+  std::atomic<uint32_t> head_{0};
+  void *main_task_{nullptr};
+};
+
+// Records a begin event now and the matching end event when it goes out of scope
+class TraceScope {
+ public:
+  TraceScope(TraceRecorder *trace, const char *name) : trace_(trace), name_(name) { trace_->begin(name); }
+  ~TraceScope() { this->trace_->end(this->name_); }
+
+ protected:
+  TraceRecorder *trace_;
+  const char *name_;
+};
+
+}  // namespace fingerprint_doorbell
+}  // namespace esphome
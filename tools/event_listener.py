@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""Receive fingerprint_doorbell ring and match datagrams (event_multicast: true).
+
+  event_listener.py --key HEX [--group 239.255.70.68] [--port 47068]
+                    [--prefix /fingerprint] [--count N] [--max-skew 30]
+                    [--state FILE] [--allow-unsynced]
+  event_listener.py --token TOKEN --print-key
+
+Joins the multicast group, checks each datagram's tag and prints one line per
+event. The key is the doorbell's event_multicast_key (or $FINGERPRINT_MULTICAST_KEY).
+Without one, the doorbell derives the key from its api_token: --print-key shows
+that key once, so receivers never need the token. --token still works in place of
+--key. With --prefix, events are labelled with the rest_prefix of the doorbell that
+sent them (repeat it for several doorbells on one ESP32).
+
+Replays are dropped by sequence number per doorbell start and by clock time.
+Datagrams sent before the doorbell's clock was set carry no time and are dropped
+unless --allow-unsynced is given. --state keeps the sequence numbers in a file, so a
+restarted listener does not accept datagrams it has already seen.
+
+Latency columns:
+  scan     scan start on the doorbell to the datagram going out (doorbell clock)
+  network  datagram sent to received; needs both clocks NTP-synced, "-" if the
+           doorbell's clock is not set yet
+  total    scan + network
+
+Ctrl+C (or --count) prints min/median/p95/max of each column.
+
+Datagram (see components/fingerprint_doorbell/event_multicast.h), big endian:
+"FD" | version(1) | type(1) | source(2) | boot(4) | seq(4) | epoch_us(8) |
+id(2) | confidence(2) | scan_ms(2) | HMAC-SHA256 tag truncated to 16 bytes.
+"""
+
+import argparse
+import hashlib
+import hmac
+import json
+import os
+import socket
+import struct
+import sys
+import time
+
+MAGIC = b"FD"
+FORMAT_VERSION = 1
+KEY_LABEL = b"fingerprint_doorbell multicast v1"
+BODY = struct.Struct(">2sBBHIIQHHH")
+TAG_SIZE = 16
+TYPE_NAMES = {1: "ring", 2: "match"}
+# Starts remembered per doorbell in --state; older ones rely on the clock window
+MAX_BOOTS_PER_SOURCE = 8
+
+
+def derive_key(token):
+    return hmac.new(token.encode(), KEY_LABEL, hashlib.sha256).digest()
+
+
+def fnv1_hash(text):
+    # Same as esphome::fnv1_hash(); the doorbell sends its low 16 bits as source
+    value = 2166136261
+    for byte in text.encode():
+        value = (value * 16777619) & 0xFFFFFFFF
+        value ^= byte
+    return value
+
+
+def parse(datagram, key):
+    """Returns the body fields, or a reason the datagram was dropped."""
+    if len(datagram) != BODY.size + TAG_SIZE:
+        return None, f"size {len(datagram)}"
+    body, tag = datagram[: BODY.size], datagram[BODY.size :]
+    expected = hmac.new(key, body, hashlib.sha256).digest()[:TAG_SIZE]
+    if not hmac.compare_digest(tag, expected):
+        return None, "bad tag (wrong key?)"
+    magic, version, *fields = BODY.unpack(body)
+    if magic != MAGIC or version != FORMAT_VERSION:
+        return None, f"unknown format {magic!r} v{version}"
+    return fields, None
+
+
+class ReplayFilter:
+    """Drops datagrams seen before: seq must grow per (source, boot), and the clock
+    time must be within max_skew seconds of ours. Without a clock time (epoch_us 0) a
+    datagram could be replayed into any later start, so it is only taken with
+    allow_unsynced. With a state file, the last seq of each start survives restarts."""
+
+    def __init__(self, max_skew, allow_unsynced=False, state_file=None):
+        self.max_skew = max_skew
+        self.allow_unsynced = allow_unsynced
+        self.state_file = state_file
+        self.last_seq = {}  # (source, boot) -> [seq, time last seen]
+        if state_file and os.path.exists(state_file):
+            with open(state_file) as f:
+                for entry in json.load(f):
+                    self.last_seq[(entry["source"], entry["boot"])] = [entry["seq"], entry["seen"]]
+
+    def accept(self, source, boot, seq, epoch_us, now):
+        if not epoch_us and not self.allow_unsynced:
+            return "doorbell clock not set (see --allow-unsynced)"
+        if epoch_us and abs(now - epoch_us / 1e6) > self.max_skew:
+            return "outside the clock window"
+        if seq <= self.last_seq.get((source, boot), [0, 0])[0]:
+            return "replayed or duplicate"
+        self.last_seq[(source, boot)] = [seq, now]
+        self.save(source)
+        return None
+
+    def save(self, source):
+        if not self.state_file:
+            return
+        # Only the most recently seen starts of each doorbell are kept
+        boots = sorted((key for key in self.last_seq if key[0] == source), key=lambda key: self.last_seq[key][1])
+        for key in boots[:-MAX_BOOTS_PER_SOURCE]:
+            del self.last_seq[key]
+        entries = [{"source": source_id, "boot": boot, "seq": seq, "seen": seen}
+                   for (source_id, boot), (seq, seen) in self.last_seq.items()]
+        # Written next to the file and renamed over it, so a crash never leaves half a file
+        temporary = self.state_file + ".tmp"
+        with open(temporary, "w") as f:
+            json.dump(entries, f)
+        os.replace(temporary, self.state_file)
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def summary(name, values):
+    if not values:
+        return f"{name:<8} no samples"
+    return (f"{name:<8} n={len(values):<4} min {min(values):7.1f}  median {percentile(values, 0.5):7.1f}  "
+            f"p95 {percentile(values, 0.95):7.1f}  max {max(values):7.1f} ms")
+
+
+def open_socket(group, port, interface):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", port))
+    membership = socket.inet_aton(group) + socket.inet_aton(interface)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    return sock
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--key", default=os.environ.get("FINGERPRINT_MULTICAST_KEY"),
+                        help="datagram key, 64 hex digits (default: $FINGERPRINT_MULTICAST_KEY)")
+    parser.add_argument("--token", default=os.environ.get("FINGERPRINT_API_TOKEN"),
+                        help="the doorbell's api_token, to derive the key from (default: $FINGERPRINT_API_TOKEN)")
+    parser.add_argument("--print-key", action="store_true", help="print the key derived from --token and exit")
+    parser.add_argument("--group", default="239.255.70.68", help="event_multicast_address")
+    parser.add_argument("--port", type=int, default=47068, help="event_multicast_port")
+    parser.add_argument("--interface", default="0.0.0.0", help="local address to join the group on")
+    parser.add_argument("--prefix", action="append", default=[], help="rest_prefix of a doorbell, for labels")
+    parser.add_argument("--count", type=int, default=0, help="exit after this many events")
+    parser.add_argument("--max-skew", type=float, default=30.0,
+                        help="seconds a datagram's clock time may differ from ours")
+    parser.add_argument("--allow-unsynced", action="store_true",
+                        help="accept datagrams sent before the doorbell's clock was set (replayable)")
+    parser.add_argument("--state", help="JSON file that keeps the replay filter's sequence numbers across restarts")
+    parser.add_argument("--verbose", action="store_true", help="also report dropped datagrams")
+    args = parser.parse_args()
+
+    if args.print_key:
+        if not args.token:
+            parser.error("--print-key needs --token or $FINGERPRINT_API_TOKEN")
+        print(derive_key(args.token).hex())
+        return
+    if args.key:
+        try:
+            key = bytes.fromhex(args.key)
+        except ValueError:
+            parser.error("--key must be hexadecimal")
+        if len(key) != 32:
+            parser.error("--key must be 64 hex digits (32 bytes)")
+    elif args.token:
+        key = derive_key(args.token)
+    else:
+        parser.error("--key (or $FINGERPRINT_MULTICAST_KEY) or --token is required")
+
+    names = {fnv1_hash(prefix) & 0xFFFF: prefix for prefix in args.prefix}
+    replay = ReplayFilter(args.max_skew, args.allow_unsynced, args.state)
+    sock = open_socket(args.group, args.port, args.interface)
+    latencies = {"scan": [], "network": [], "total": []}
+    events = 0
+
+    print(f"Listening on {args.group}:{args.port}", file=sys.stderr)
+    try:
+        while not args.count or events < args.count:
+            datagram, sender = sock.recvfrom(256)
+            now = time.time()
+            fields, error = parse(datagram, key)
+            if fields:
+                kind, source, boot, seq, epoch_us, finger_id, confidence, scan_ms = fields
+                error = replay.accept(source, boot, seq, epoch_us, now)
+            if error:
+                if args.verbose:
+                    print(f"dropped datagram from {sender[0]}: {error}", file=sys.stderr)
+                continue
+            events += 1
+
+            latencies["scan"].append(scan_ms)
+            network = total = "-"
+            if epoch_us:
+                network_ms = (now - epoch_us / 1e6) * 1000
+                latencies["network"].append(network_ms)
+                latencies["total"].append(scan_ms + network_ms)
+                network, total = f"{network_ms:.1f}", f"{scan_ms + network_ms:.1f}"
+            label = names.get(source, f"{sender[0]}/{source:04x}")
+            detail = f"id={finger_id} confidence={confidence}" if kind == 2 else ""
+            print(f"{time.strftime('%H:%M:%S')} {label} #{seq} {TYPE_NAMES.get(kind, kind)} {detail} "
+                  f"scan={scan_ms} network={network} total={total} ms", flush=True)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sock.close()
+
+    print(f"\n{events} events", file=sys.stderr)
+    for name, values in latencies.items():
+        print(summary(name, values), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
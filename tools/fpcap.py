@@ -0,0 +1,499 @@
+#!/usr/bin/env python3
+"""Analyze and replay sensor traffic captures from GET /fingerprint/capture.
+
+  fpcap.py analyze sensor.fpcap [--json]
+      Per-command sensor response times, loop blocking (back-to-back sensor calls
+      the main loop waits on) and decision latency (finger read -> LED verdict).
+
+  fpcap.py emulate sensor.fpcap --port /dev/ttyUSB0 [--save replay.fpcap] [--json]
+      Plays the recorded sensor through a USB-UART wired to the doorbell's sensor
+      pins. The firmware runs its real scan, enrollment and template code against
+      the recorded answers, sent with the recorded response delays. Needs pyserial.
+
+  fpcap.py compare baseline.json current.json [--tolerance 10]
+      Exits 1 when decision latency p95 or the longest loop block got worse by more
+      than the tolerance (percent). Feed it the --json output of two runs.
+
+Capture format (see components/fingerprint_doorbell/link_capture.h): "FPCAP", a
+version byte and two reserved bytes, then records of
+ts_us(4, LE) | dir(1, 0 = TX to the sensor, 1 = RX from it) | len(1) | bytes.
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+MAGIC = b"FPCAP"
+FORMAT_VERSION = 1
+DIR_TX = 0
+DIR_RX = 1
+
+COMMAND_PACKET = 0x01
+DATA_PACKET = 0x02
+ACK_PACKET = 0x07
+END_DATA_PACKET = 0x08
+
+CMD_GET_IMAGE = 0x01
+CMD_MATCH = 0x03
+CMD_SEARCH = 0x04
+CMD_AURA_LED = 0x35
+
+# Same names as SensorLink::command_name()
+COMMAND_NAMES = {
+    0x01: "get_image",
+    0x02: "image2tz",
+    0x03: "match",
+    0x04: "search",
+    0x05: "reg_model",
+    0x06: "store",
+    0x07: "load_char",
+    0x08: "up_char",
+    0x09: "down_char",
+    0x0A: "up_image",
+    0x0C: "delete",
+    0x0D: "empty",
+    0x0F: "read_sys_param",
+    0x12: "set_password",
+    0x13: "verify_password",
+    0x1D: "template_count",
+    0x1F: "read_index_table",
+    0x30: "cancel",
+    0x31: "auto_enroll",
+    0x35: "aura_led",
+    0x40: "handshake",
+}
+
+
+def command_name(command):
+    return COMMAND_NAMES.get(command, f"0x{command:02X}")
+
+
+class Packet:
+    def __init__(self, direction, ptype, data, raw, start_us, end_us, valid):
+        self.direction = direction
+        self.type = ptype
+        self.data = data
+        self.raw = raw
+        self.start_us = start_us
+        self.end_us = end_us
+        self.valid = valid  # Checksum matched
+
+    @property
+    def command(self):
+        return self.data[0] if self.data else None
+
+
+class PacketParser:
+    """Byte-at-a-time R503 packet parser: EF01 | addr(4) | type | len(2) | data | checksum(2)."""
+
+    def __init__(self, direction):
+        self.direction = direction
+        self.buffer = bytearray()
+        self.start_us = 0
+        self.skipped = 0
+
+    def feed(self, byte, ts_us):
+        buf = self.buffer
+        if not buf:
+            self.start_us = ts_us
+        buf.append(byte)
+        if len(buf) == 1 and byte != 0xEF:
+            buf.clear()
+            self.skipped += 1
+            return None
+        if len(buf) == 2 and byte != 0x01:
+            self.skipped += 1
+            buf.clear()
+            if byte == 0xEF:
+                buf.append(byte)
+            else:
+                self.skipped += 1
+            return None
+        if len(buf) < 9:
+            return None
+        length = (buf[7] << 8) | buf[8]
+        if length < 2 or length > 258:
+            self.skipped += len(buf)
+            buf.clear()
+            return None
+        if len(buf) < 9 + length:
+            return None
+        ptype = buf[6]
+        data = bytes(buf[9 : 7 + length])
+        checksum = (buf[7 + length] << 8) | buf[8 + length]
+        valid = checksum == (ptype + buf[7] + buf[8] + sum(data)) & 0xFFFF
+        packet = Packet(self.direction, ptype, data, bytes(buf), self.start_us, ts_us, valid)
+        buf.clear()
+        return packet
+
+
+# ==================== CAPTURE FILES ====================
+
+
+def read_records(path):
+    """Yields (ts_us, direction, bytes) with timestamps unwrapped to 64 bits."""
+    with open(path, "rb") as f:
+        blob = f.read()
+    if len(blob) < 8 or blob[:5] != MAGIC:
+        raise ValueError(f"{path}: not a capture file")
+    if blob[5] != FORMAT_VERSION:
+        raise ValueError(f"{path}: unsupported capture version {blob[5]}")
+    pos = 8
+    last = None
+    now = 0
+    while pos + 6 <= len(blob):
+        ts, direction, length = struct.unpack_from("<IBB", blob, pos)
+        pos += 6
+        if pos + length > len(blob):
+            break  # Download cut short
+        now = ts if last is None else now + ((ts - last) & 0xFFFFFFFF)
+        last = ts
+        yield now, direction, blob[pos : pos + length]
+        pos += length
+
+
+def write_capture(path, records):
+    with open(path, "wb") as f:
+        f.write(MAGIC + bytes([FORMAT_VERSION, 0, 0]))
+        for ts_us, direction, data in records:
+            for i in range(0, len(data), 255):
+                f.write(struct.pack("<IBB", ts_us & 0xFFFFFFFF, direction, len(data[i : i + 255])))
+                f.write(data[i : i + 255])
+
+
+def parse_packets(records):
+    """Packets of both directions in time order, plus bytes skipped while resyncing."""
+    parsers = {DIR_TX: PacketParser(DIR_TX), DIR_RX: PacketParser(DIR_RX)}
+    packets = []
+    for ts_us, direction, data in records:
+        parser = parsers[direction]
+        for byte in data:
+            packet = parser.feed(byte, ts_us)
+            if packet is not None:
+                packets.append(packet)
+    return packets, parsers[DIR_TX].skipped + parsers[DIR_RX].skipped
+
+
+class Exchange:
+    """One command and everything that followed it until the next command."""
+
+    def __init__(self, command_packet):
+        self.command = command_packet
+        self.replies = []  # Sensor packets
+        self.host_data = []  # Data packets the firmware sent after the command (down_char)
+
+    @property
+    def name(self):
+        return command_name(self.command.command)
+
+    @property
+    def ack(self):
+        return next((p for p in self.replies if p.type == ACK_PACKET), None)
+
+    @property
+    def end_us(self):
+        last = self.replies[-1] if self.replies else self.command
+        if self.host_data and self.host_data[-1].end_us > last.end_us:
+            last = self.host_data[-1]
+        return last.end_us
+
+
+def group_exchanges(packets):
+    exchanges = []
+    for packet in packets:
+        if packet.direction == DIR_TX and packet.type == COMMAND_PACKET and packet.data:
+            exchanges.append(Exchange(packet))
+        elif exchanges:
+            target = exchanges[-1].replies if packet.direction == DIR_RX else exchanges[-1].host_data
+            target.append(packet)
+    return exchanges
+
+
+# ==================== METRICS ====================
+
+
+def summarize(values_ms):
+    if not values_ms:
+        return {"count": 0}
+    ordered = sorted(values_ms)
+
+    def pct(p):
+        return round(ordered[min(len(ordered) - 1, int(p / 100 * len(ordered)))], 2)
+
+    return {
+        "count": len(ordered),
+        "mean": round(sum(ordered) / len(ordered), 2),
+        "p50": pct(50),
+        "p95": pct(95),
+        "max": round(ordered[-1], 2),
+    }
+
+
+def loop_blocks(exchanges, idle_gap_us):
+    """Back-to-back sensor calls; the main loop is blocked for each span's duration."""
+    blocks = []
+    current = None
+    for exchange in exchanges:
+        start = exchange.command.start_us
+        if current is not None and start - current["end_us"] <= idle_gap_us:
+            current["end_us"] = max(current["end_us"], exchange.end_us)
+            current["commands"].append(exchange.name)
+        else:
+            current = {"start_us": start, "end_us": exchange.end_us, "commands": [exchange.name]}
+            blocks.append(current)
+    return blocks
+
+
+def decisions(exchanges):
+    """Finger read (get_image OK) -> first LED command after the search/match verdict."""
+    results = []
+    finger_at = None
+    verdict = None
+    for exchange in exchanges:
+        command = exchange.command.command
+        ack = exchange.ack
+        code = ack.data[0] if ack is not None and ack.data else None
+        if command == CMD_GET_IMAGE and code == 0:
+            finger_at = ack.end_us
+            verdict = None
+        elif command in (CMD_SEARCH, CMD_MATCH) and finger_at is not None and code is not None:
+            verdict = "match" if code == 0 else "no_match"
+        elif command == CMD_AURA_LED and finger_at is not None and verdict is not None:
+            results.append((verdict, (exchange.command.start_us - finger_at) / 1000))
+            finger_at = None
+            verdict = None
+    return results
+
+
+def compute_metrics(packets, skipped, idle_gap_ms):
+    exchanges = group_exchanges(packets)
+    commands = {}
+    codes = {}
+    for exchange in exchanges:
+        ack = exchange.ack
+        if ack is None:
+            commands.setdefault(exchange.name, []).append(None)
+            continue
+        commands.setdefault(exchange.name, []).append((ack.end_us - exchange.command.end_us) / 1000)
+        if ack.data:
+            key = f"{exchange.name}:0x{ack.data[0]:02X}"
+            codes[key] = codes.get(key, 0) + 1
+
+    command_stats = {}
+    for name, times in sorted(commands.items()):
+        answered = [t for t in times if t is not None]
+        stats = summarize(answered)
+        stats["unanswered"] = len(times) - len(answered)
+        command_stats[name] = stats
+
+    blocks = loop_blocks(exchanges, idle_gap_ms * 1000)
+    block_ms = [(b["end_us"] - b["start_us"]) / 1000 for b in blocks]
+    longest = sorted(blocks, key=lambda b: b["start_us"] - b["end_us"])[:5]
+    verdicts = decisions(exchanges)
+    duration = (packets[-1].end_us - packets[0].start_us) / 1e6 if packets else 0
+
+    return {
+        "duration_s": round(duration, 3),
+        "packets": len(packets),
+        "checksum_errors": sum(1 for p in packets if not p.valid),
+        "resync_bytes": skipped,
+        "commands": command_stats,
+        "result_codes": codes,
+        "loop_blocking_ms": summarize(block_ms),
+        "longest_blocks": [
+            {
+                "at_s": round((b["start_us"] - packets[0].start_us) / 1e6, 3),
+                "ms": round((b["end_us"] - b["start_us"]) / 1000, 2),
+                "commands": b["commands"],
+            }
+            for b in longest
+        ],
+        "decision_latency_ms": summarize([ms for _, ms in verdicts]),
+        "decision_latency_match_ms": summarize([ms for v, ms in verdicts if v == "match"]),
+        "decision_latency_no_match_ms": summarize([ms for v, ms in verdicts if v == "no_match"]),
+    }
+
+
+def print_report(metrics):
+    print(f"Duration {metrics['duration_s']} s, {metrics['packets']} packets, "
+          f"{metrics['checksum_errors']} checksum errors, {metrics['resync_bytes']} resync bytes")
+    if "unmatched_commands" in metrics:
+        print(f"Commands without a recorded answer: {metrics['unmatched_commands']}")
+    print()
+    print(f"{'command':<18}{'count':>7}{'mean ms':>10}{'p95 ms':>10}{'max ms':>10}{'no ack':>8}")
+    for name, stats in metrics["commands"].items():
+        print(f"{name:<18}{stats['count'] + stats['unanswered']:>7}{stats.get('mean', '-'):>10}"
+              f"{stats.get('p95', '-'):>10}{stats.get('max', '-'):>10}{stats['unanswered']:>8}")
+    print()
+    for key, label in (
+        ("loop_blocking_ms", "Loop blocking"),
+        ("decision_latency_ms", "Decision latency"),
+        ("decision_latency_match_ms", "  match"),
+        ("decision_latency_no_match_ms", "  no match"),
+    ):
+        stats = metrics[key]
+        if stats["count"] == 0:
+            print(f"{label:<18}none")
+        else:
+            print(f"{label:<18}n={stats['count']} p50={stats['p50']} ms p95={stats['p95']} ms max={stats['max']} ms")
+    if metrics["longest_blocks"]:
+        print()
+        print("Longest loop blocks:")
+        for block in metrics["longest_blocks"]:
+            print(f"  at {block['at_s']:>9} s  {block['ms']:>9} ms  {' '.join(block['commands'][:12])}"
+                  f"{' ...' if len(block['commands']) > 12 else ''}")
+
+
+# ==================== SENSOR EMULATION ====================
+
+
+def find_exchange(exchanges, start, packet, lookahead):
+    """Next recorded exchange for this command, preferring identical parameters."""
+    fallback = None
+    for i in range(start, min(len(exchanges), start + lookahead)):
+        recorded = exchanges[i].command
+        if recorded.command != packet.command:
+            continue
+        if recorded.data == packet.data:
+            return i
+        if fallback is None:
+            fallback = i
+    return fallback
+
+
+def emulate(args):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("emulate needs pyserial: pip install pyserial")
+
+    packets, _ = parse_packets(read_records(args.capture))
+    exchanges = group_exchanges(packets)
+    if not exchanges:
+        sys.exit(f"{args.capture}: no commands recorded")
+
+    port = serial.Serial(args.port, args.baud, timeout=0.001)
+    parser = PacketParser(DIR_TX)
+    session = []  # (ts_us, direction, bytes) as the firmware saw it, for the metrics
+    clock0 = time.monotonic()
+
+    def now_us():
+        return int((time.monotonic() - clock0) * 1e6)
+
+    index = 0
+    unmatched = 0
+    deadline = time.monotonic() + args.duration if args.duration else None
+    print(f"Replaying {len(exchanges)} recorded exchanges on {args.port}, Ctrl+C to stop", file=sys.stderr)
+    try:
+        while deadline is None or time.monotonic() < deadline:
+            chunk = port.read(256)
+            if not chunk:
+                continue
+            received_at = now_us()
+            session.append((received_at, DIR_TX, chunk))
+            for byte in chunk:
+                packet = parser.feed(byte, received_at)
+                if packet is None or packet.type != COMMAND_PACKET or not packet.data:
+                    continue
+                found = find_exchange(exchanges, index, packet, args.lookahead)
+                if found is None:
+                    # Left unanswered: the firmware sees a timeout, like a dropped packet
+                    unmatched += 1
+                    continue
+                recorded = exchanges[found]
+                index = found + 1
+                sent_from = time.monotonic()
+                for reply in recorded.replies:
+                    delay = (reply.start_us - recorded.command.end_us) / 1e6 / args.speed
+                    wait = sent_from + delay - time.monotonic()
+                    if wait > 0:
+                        time.sleep(wait)
+                    port.write(reply.raw)
+                    session.append((now_us(), DIR_RX, reply.raw))
+            if index >= len(exchanges):
+                if not args.loop:
+                    break
+                index = 0
+    except KeyboardInterrupt:
+        pass
+    finally:
+        port.close()
+
+    if args.save:
+        write_capture(args.save, session)
+    packets, skipped = parse_packets(session)
+    metrics = compute_metrics(packets, skipped, args.idle_gap)
+    metrics["unmatched_commands"] = unmatched
+    return metrics
+
+
+# ==================== COMMANDS ====================
+
+
+def cmd_analyze(args):
+    packets, skipped = parse_packets(read_records(args.capture))
+    return compute_metrics(packets, skipped, args.idle_gap)
+
+
+def cmd_compare(args):
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.current) as f:
+        current = json.load(f)
+    worse = False
+    for key, stat in (("decision_latency_ms", "p95"), ("loop_blocking_ms", "max"), ("loop_blocking_ms", "p95")):
+        old = baseline.get(key, {}).get(stat)
+        new = current.get(key, {}).get(stat)
+        if old is None or new is None:
+            print(f"{key}.{stat}: missing")
+            continue
+        change = (new - old) / old * 100 if old else 0.0
+        regressed = change > args.tolerance
+        worse |= regressed
+        print(f"{key}.{stat}: {old} -> {new} ms ({change:+.1f}%){'  REGRESSION' if regressed else ''}")
+    return 1 if worse else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    analyze = sub.add_parser("analyze", help="report on a capture")
+    analyze.add_argument("capture")
+
+    emu = sub.add_parser("emulate", help="play a capture as the sensor over a serial port")
+    emu.add_argument("capture")
+    emu.add_argument("--port", required=True)
+    emu.add_argument("--baud", type=int, default=57600)
+    emu.add_argument("--speed", type=float, default=1.0, help="reply delay divisor, 2 = answer twice as fast")
+    emu.add_argument("--lookahead", type=int, default=64, help="recorded exchanges searched per command")
+    emu.add_argument("--duration", type=float, help="stop after this many seconds")
+    emu.add_argument("--loop", action="store_true", help="start over at the end of the capture")
+    emu.add_argument("--save", help="write the replayed session as a capture file")
+
+    for p in (analyze, emu):
+        p.add_argument("--idle-gap", type=float, default=5.0,
+                       help="ms between sensor calls that still count as one loop block")
+        p.add_argument("--json", action="store_true", help="print metrics as JSON")
+
+    compare = sub.add_parser("compare", help="compare two --json outputs")
+    compare.add_argument("baseline")
+    compare.add_argument("current")
+    compare.add_argument("--tolerance", type=float, default=10.0, help="allowed regression in percent")
+
+    args = parser.parse_args()
+    if args.command == "compare":
+        sys.exit(cmd_compare(args))
+
+    metrics = cmd_analyze(args) if args.command == "analyze" else emulate(args)
+    if args.json:
+        json.dump(metrics, sys.stdout, indent=2)
+        print()
+    else:
+        print_report(metrics)
+
+
+if __name__ == "__main__":
+    main()
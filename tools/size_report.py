@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""Compare firmware size and static RAM across fingerprint_doorbell feature sets.
+
+  size_report.py example-device.yaml [--variant NAME:KEY=VALUE[,KEY=VALUE]] [--only NAME]
+
+Builds the device config once per feature set with `esphome compile` and prints
+the flash and static RAM use PlatformIO reports, next to the difference from the
+full build:
+
+  full                  everything the config enables
+  no_template_transfer  template_transfer: false
+  no_web_ui             web_ui: false
+  scan_and_ring         rest_api: false (scan, ring, unlock, Home Assistant actions)
+
+Each variant is a small YAML file next to the device config that includes it as a
+package and overrides keys of its fingerprint_doorbell block, which therefore has
+to be written as a single mapping (as in fingerprint-doorbell.yaml). Variants get
+their own device name, so their build directories do not collide. Static RAM does
+not include heap buffers such as trace_buffer_size or capture_buffer_size.
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+from pathlib import Path
+
+VARIANTS = {
+    "full": {},
+    "no_template_transfer": {"template_transfer": "false"},
+    "no_web_ui": {"web_ui": "false"},
+    "scan_and_ring": {"rest_api": "false"},
+}
+
+# PlatformIO: "RAM:   [=         ]  13.2% (used 43240 bytes from 327680 bytes)"
+USAGE_RE = re.compile(r"^(RAM|Flash):.*\(used (\d+) bytes from (\d+) bytes\)", re.MULTILINE)
+
+
+def parse_variant(text):
+    name, _, settings = text.partition(":")
+    overrides = {}
+    for setting in filter(None, settings.split(",")):
+        key, sep, value = setting.partition("=")
+        if not sep:
+            raise argparse.ArgumentTypeError(f"expected KEY=VALUE, got '{setting}'")
+        overrides[key.strip()] = value.strip()
+    if not name:
+        raise argparse.ArgumentTypeError("variant needs a name")
+    return name, overrides
+
+
+def device_name(config):
+    # Good enough for the plain `name:` line under `esphome:`; substitutions are kept
+    match = re.search(r"^esphome:\s*\n(?:[ \t]+.*\n)*?[ \t]+name:\s*(\S+)", config.read_text(), re.MULTILINE)
+    return match.group(1).strip("\"'") if match else config.stem
+
+
+def write_variant(config, name, overrides):
+    path = config.with_name(f".size-{name}.{config.name}")
+    lines = [
+        "packages:",
+        f"  device: !include {config.name}",
+        "esphome:",
+        f"  name: {device_name(config)}-size-{name.replace('_', '-')}",
+    ]
+    if overrides:
+        lines.append("fingerprint_doorbell:")
+        lines += [f"  {key}: {value}" for key, value in overrides.items()]
+    path.write_text("\n".join(lines) + "\n")
+    return path
+
+
+def build(esphome, config, name, overrides):
+    path = write_variant(config, name, overrides)
+    try:
+        result = subprocess.run([esphome, "compile", str(path)], capture_output=True, text=True)
+    finally:
+        path.unlink()
+    output = result.stdout + result.stderr
+    if result.returncode != 0:
+        sys.stderr.write(output[-4000:])
+        sys.exit(f"{name}: esphome compile failed")
+    usage = {kind: (int(used), int(total)) for kind, used, total in USAGE_RE.findall(output)}
+    if "RAM" not in usage or "Flash" not in usage:
+        sys.exit(f"{name}: no RAM/Flash summary in the build output")
+    return usage
+
+
+def delta(value, base):
+    return "" if value == base else f"{value - base:+d}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("config", type=Path, help="device YAML that builds the doorbell")
+    parser.add_argument("--variant", type=parse_variant, action="append", default=[],
+                        help="extra feature set, e.g. no_verify:template_verify_upload=false")
+    parser.add_argument("--only", action="append", help="build only these variants (full is always built)")
+    parser.add_argument("--esphome", default="esphome", help="esphome executable")
+    args = parser.parse_args()
+
+    variants = dict(VARIANTS)
+    variants.update(args.variant)
+    if args.only:
+        variants = {name: overrides for name, overrides in variants.items() if name == "full" or name in args.only}
+
+    config = args.config.resolve()
+    results = {}
+    for name, overrides in variants.items():
+        print(f"Building {name}...", file=sys.stderr)
+        results[name] = build(args.esphome, config, name, overrides)
+
+    base = results["full"]
+    print(f"{'variant':<22} {'flash':>9} {'delta':>8} {'static RAM':>11} {'delta':>8}")
+    for name, usage in results.items():
+        flash, ram = usage["Flash"][0], usage["RAM"][0]
+        print(f"{name:<22} {flash:>9} {delta(flash, base['Flash'][0]):>8} "
+              f"{ram:>11} {delta(ram, base['RAM'][0]):>8}")
+    print(f"\nof {base['Flash'][1]} bytes flash and {base['RAM'][1]} bytes RAM")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,382 @@
+// Host implementations of the ESP-IDF, ESPHome and Arduino pieces the component links
+// against, for scan_soak.cpp. Time is virtual: it only moves when the bench (or a
+// simulated sensor command) advances it.
+
+#include "soak_host.h"
+
+#include <Adafruit_Fingerprint.h>
+#include <esp_heap_caps.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <malloc.h>
+#include <mbedtls/md.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "esphome/components/web_server_base/web_server_base.h"
+#include "esphome/core/application.h"
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/preferences.h"
+
+// ==================== CLOCK ====================
+
+static uint64_t now_us = 1000000;
+
+namespace soak {
+void advance_us(uint64_t us) { now_us += us; }
+uint64_t clock_us() { return now_us; }
+}  // namespace soak
+
+namespace esphome {
+uint32_t millis() { return now_us / 1000; }
+uint32_t micros() { return now_us; }
+void delay(uint32_t ms) { now_us += (uint64_t) ms * 1000; }
+void delayMicroseconds(uint32_t us) { now_us += us; }
+}  // namespace esphome
+
+int64_t esp_timer_get_time() { return now_us; }
+TaskHandle_t xTaskGetCurrentTaskHandle() { return nullptr; }
+
+// ==================== ESPHOME CORE ====================
+
+namespace esphome {
+
+namespace setup_priority {
+const float WIFI = 250.0f;
+const float DATA = 600.0f;
+const float HARDWARE = 800.0f;
+}  // namespace setup_priority
+
+Application App;
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= (uint8_t) c;
+  }
+  return hash;
+}
+
+uint32_t random_uint32() {
+  static std::mt19937 rng(12345);
+  return rng();
+}
+
+uint16_t crc16(const uint8_t *data, uint16_t len, uint16_t crc, uint16_t reverse_poly, bool refin, bool refout) {
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = (crc & 1) ? (crc >> 1) ^ reverse_poly : crc >> 1;
+  }
+  return crc;
+}
+
+// Like the real scheduler: one heap item per set_timeout(), replaced by name
+struct SchedulerItem {
+  const Component *component;
+  std::string name;
+  uint64_t due_us;
+  std::function<void()> callback;
+};
+static std::vector<std::unique_ptr<SchedulerItem>> scheduler_items;
+
+void Component::set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {
+  if (!name.empty())
+    this->cancel_timeout(name);
+  scheduler_items.push_back(
+      std::unique_ptr<SchedulerItem>(new SchedulerItem{this, name, now_us + (uint64_t) timeout * 1000, std::move(f)}));
+}
+
+bool Component::cancel_timeout(const std::string &name) {
+  for (auto it = scheduler_items.begin(); it != scheduler_items.end(); ++it) {
+    if ((*it)->component == this && (*it)->name == name) {
+      scheduler_items.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Preferences: an in-memory map from key to the bytes last saved
+static std::map<uint32_t, std::vector<uint8_t>> preference_store;
+static ESPPreferences preferences;
+ESPPreferences *global_preferences = &preferences;
+
+bool soak_pref_save(uint32_t key, const void *data, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  std::vector<uint8_t> &stored = preference_store[key];
+  stored.assign(bytes, bytes + size);
+  return true;
+}
+
+bool soak_pref_load(uint32_t key, void *data, size_t size) {
+  auto it = preference_store.find(key);
+  if (it == preference_store.end() || it->second.size() != size)
+    return false;
+  memcpy(data, it->second.data(), size);
+  return true;
+}
+
+bool ESPPreferences::sync() { return true; }
+
+}  // namespace esphome
+
+namespace soak {
+size_t scheduler_items() { return esphome::scheduler_items.size(); }
+}  // namespace soak
+
+// ==================== ESP-IDF ====================
+
+size_t heap_caps_get_free_size(uint32_t caps) { return mallinfo2().fordblks; }
+size_t heap_caps_get_minimum_free_size(uint32_t caps) { return mallinfo2().fordblks; }
+size_t heap_caps_get_largest_free_block(uint32_t caps) { return mallinfo2().fordblks; }
+void *heap_caps_malloc(size_t size, uint32_t caps) { return malloc(size); }
+uint32_t esp_get_free_heap_size() { return mallinfo2().fordblks; }
+uint32_t esp_get_minimum_free_heap_size() { return mallinfo2().fordblks; }
+
+// One data partition in RAM, erased (0xFF) at first use
+static const size_t PARTITION_SIZE = 4 * 1024 * 1024;
+static esp_partition_t partition = {0x400000, PARTITION_SIZE, "cold"};
+static std::vector<uint8_t> partition_data;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t, const char *label) {
+  if (partition_data.empty())
+    partition_data.assign(PARTITION_SIZE, 0xFF);
+  return &partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *, size_t offset, void *dst, size_t size) {
+  if (offset + size > PARTITION_SIZE)
+    return -1;
+  memcpy(dst, partition_data.data() + offset, size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *, size_t offset, const void *src, size_t size) {
+  if (offset + size > PARTITION_SIZE)
+    return -1;
+  memcpy(partition_data.data() + offset, src, size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *, size_t offset, size_t size) {
+  if (offset + size > PARTITION_SIZE)
+    return -1;
+  memset(partition_data.data() + offset, 0xFF, size);
+  return ESP_OK;
+}
+
+// HMAC is not what the bench measures: the tag is all zeros
+const mbedtls_md_info_t *mbedtls_md_info_from_type(mbedtls_md_type_t) {
+  static int info;
+  return reinterpret_cast<const mbedtls_md_info_t *>(&info);
+}
+void mbedtls_md_init(mbedtls_md_context_t *ctx) { ctx->p = nullptr; }
+void mbedtls_md_free(mbedtls_md_context_t *) {}
+int mbedtls_md_setup(mbedtls_md_context_t *, const mbedtls_md_info_t *, int) { return 0; }
+int mbedtls_md_hmac(const mbedtls_md_info_t *, const unsigned char *, size_t, const unsigned char *, size_t,
+                    unsigned char *output) {
+  memset(output, 0, 32);
+  return 0;
+}
+int mbedtls_md_hmac_starts(mbedtls_md_context_t *, const unsigned char *, size_t) { return 0; }
+int mbedtls_md_hmac_update(mbedtls_md_context_t *, const unsigned char *, size_t) { return 0; }
+int mbedtls_md_hmac_finish(mbedtls_md_context_t *, unsigned char *output) {
+  memset(output, 0, 32);
+  return 0;
+}
+int mbedtls_md_hmac_reset(mbedtls_md_context_t *) { return 0; }
+
+// No web server on the host: setup_web_server() finds none and skips the handler
+namespace esphome {
+namespace web_server_base {
+WebServerBase *global_web_server_base = nullptr;
+}  // namespace web_server_base
+}  // namespace esphome
+esp_err_t httpd_resp_set_status(httpd_req_t *, const char *) { return ESP_OK; }
+esp_err_t httpd_resp_set_type(httpd_req_t *, const char *) { return ESP_OK; }
+esp_err_t httpd_resp_set_hdr(httpd_req_t *, const char *, const char *) { return ESP_OK; }
+esp_err_t httpd_resp_send_chunk(httpd_req_t *, const char *, ssize_t) { return ESP_OK; }
+esp_err_t httpd_resp_send(httpd_req_t *, const char *, ssize_t) { return ESP_OK; }
+
+// ==================== ADAFRUIT FINGERPRINT ====================
+// The parts of Adafruit-Fingerprint-Sensor-Library 2.1 the component calls, with the
+// library's packet framing and timeout behaviour
+
+Adafruit_Fingerprint::Adafruit_Fingerprint(Stream *serial, uint32_t password)
+    : mySerial(serial), thePassword(password) {}
+
+void Adafruit_Fingerprint::begin(uint32_t baud) {}
+
+void Adafruit_Fingerprint::writeStructuredPacket(const Adafruit_Fingerprint_Packet &packet) {
+  mySerial->write((uint8_t) (packet.start_code >> 8));
+  mySerial->write((uint8_t) (packet.start_code & 0xFF));
+  for (uint8_t byte : packet.address)
+    mySerial->write(byte);
+  mySerial->write(packet.type);
+  uint16_t wire_length = packet.length + 2;
+  mySerial->write((uint8_t) (wire_length >> 8));
+  mySerial->write((uint8_t) (wire_length & 0xFF));
+  uint16_t sum = (wire_length >> 8) + (wire_length & 0xFF) + packet.type;
+  for (uint16_t i = 0; i < packet.length; i++) {
+    mySerial->write(packet.data[i]);
+    sum += packet.data[i];
+  }
+  mySerial->write((uint8_t) (sum >> 8));
+  mySerial->write((uint8_t) (sum & 0xFF));
+}
+
+uint8_t Adafruit_Fingerprint::getStructuredPacket(Adafruit_Fingerprint_Packet *packet, uint16_t timeout) {
+  uint16_t idx = 0, timer = 0;
+  while (true) {
+    while (!mySerial->available()) {
+      esphome::delay(1);
+      timer++;
+      if (timer >= timeout)
+        return FINGERPRINT_TIMEOUT;
+    }
+    uint8_t byte = mySerial->read();
+    switch (idx) {
+      case 0:
+        if (byte != (FINGERPRINT_STARTCODE >> 8))
+          continue;
+        packet->start_code = (uint16_t) byte << 8;
+        break;
+      case 1:
+        packet->start_code |= byte;
+        if (packet->start_code != FINGERPRINT_STARTCODE)
+          return FINGERPRINT_BADPACKET;
+        break;
+      case 2:
+      case 3:
+      case 4:
+      case 5:
+        packet->address[idx - 2] = byte;
+        break;
+      case 6:
+        packet->type = byte;
+        break;
+      case 7:
+        packet->length = (uint16_t) byte << 8;
+        break;
+      case 8:
+        packet->length |= byte;
+        break;
+      default:
+        packet->data[idx - 9] = byte;
+        if ((idx - 8) == packet->length)
+          return FINGERPRINT_OK;
+        break;
+    }
+    idx++;
+    if ((idx + 9) >= sizeof(packet->data))
+      return FINGERPRINT_BADPACKET;
+  }
+}
+
+// The library's SEND_CMD_PACKET: send, wait for the ack, return its confirmation code
+#define SEND_CMD_PACKET(...) \
+  uint8_t data[] = {__VA_ARGS__}; \
+  Adafruit_Fingerprint_Packet packet(FINGERPRINT_COMMANDPACKET, sizeof(data), data); \
+  this->writeStructuredPacket(packet); \
+  if (this->getStructuredPacket(&packet) != FINGERPRINT_OK) \
+    return FINGERPRINT_PACKETRECIEVEERR; \
+  if (packet.type != FINGERPRINT_ACKPACKET) \
+    return FINGERPRINT_PACKETRECIEVEERR; \
+  return packet.data[0];
+
+#define GET_CMD_PACKET(...) \
+  uint8_t data[] = {__VA_ARGS__}; \
+  Adafruit_Fingerprint_Packet packet(FINGERPRINT_COMMANDPACKET, sizeof(data), data); \
+  this->writeStructuredPacket(packet); \
+  if (this->getStructuredPacket(&packet) != FINGERPRINT_OK) \
+    return FINGERPRINT_PACKETRECIEVEERR; \
+  if (packet.type != FINGERPRINT_ACKPACKET) \
+    return FINGERPRINT_PACKETRECIEVEERR; \
+  if (packet.data[0] != FINGERPRINT_OK) \
+    return packet.data[0];
+
+bool Adafruit_Fingerprint::verifyPassword(void) { return this->checkPassword() == FINGERPRINT_OK; }
+
+uint8_t Adafruit_Fingerprint::checkPassword(void) {
+  GET_CMD_PACKET(FINGERPRINT_VERIFYPASSWORD, (uint8_t) (thePassword >> 24), (uint8_t) (thePassword >> 16),
+                 (uint8_t) (thePassword >> 8), (uint8_t) (thePassword & 0xFF));
+  return FINGERPRINT_OK;
+}
+
+uint8_t Adafruit_Fingerprint::getParameters(void) {
+  GET_CMD_PACKET(FINGERPRINT_READSYSPARAM);
+  status_reg = ((uint16_t) packet.data[1] << 8) | packet.data[2];
+  system_id = ((uint16_t) packet.data[3] << 8) | packet.data[4];
+  capacity = ((uint16_t) packet.data[5] << 8) | packet.data[6];
+  security_level = ((uint16_t) packet.data[7] << 8) | packet.data[8];
+  device_addr = ((uint32_t) packet.data[9] << 24) | ((uint32_t) packet.data[10] << 16) |
+                ((uint32_t) packet.data[11] << 8) | (uint32_t) packet.data[12];
+  packet_len = ((uint16_t) packet.data[13] << 8) | packet.data[14];
+  packet_len = 32 << packet_len;
+  baud_rate = (((uint16_t) packet.data[15] << 8) | packet.data[16]) * 9600;
+  return packet.data[0];
+}
+
+uint8_t Adafruit_Fingerprint::getImage(void) { SEND_CMD_PACKET(FINGERPRINT_GETIMAGE); }
+uint8_t Adafruit_Fingerprint::image2Tz(uint8_t slot) { SEND_CMD_PACKET(FINGERPRINT_IMAGE2TZ, slot); }
+uint8_t Adafruit_Fingerprint::createModel(void) { SEND_CMD_PACKET(FINGERPRINT_REGMODEL); }
+uint8_t Adafruit_Fingerprint::emptyDatabase(void) { SEND_CMD_PACKET(FINGERPRINT_EMPTY); }
+
+uint8_t Adafruit_Fingerprint::storeModel(uint16_t location, uint8_t slot) {
+  SEND_CMD_PACKET(FINGERPRINT_STORE, slot, (uint8_t) (location >> 8), (uint8_t) (location & 0xFF));
+}
+
+uint8_t Adafruit_Fingerprint::loadModel(uint16_t location, uint8_t slot) {
+  SEND_CMD_PACKET(FINGERPRINT_LOAD, slot, (uint8_t) (location >> 8), (uint8_t) (location & 0xFF));
+}
+
+uint8_t Adafruit_Fingerprint::getModel(void) { SEND_CMD_PACKET(FINGERPRINT_UPLOAD, 0x01); }
+
+uint8_t Adafruit_Fingerprint::deleteModel(uint16_t location) {
+  SEND_CMD_PACKET(FINGERPRINT_DELETE, (uint8_t) (location >> 8), (uint8_t) (location & 0xFF), 0x00, 0x01);
+}
+
+uint8_t Adafruit_Fingerprint::fingerFastSearch(void) {
+  GET_CMD_PACKET(FINGERPRINT_HISPEEDSEARCH, 0x01, 0x00, 0x00, 0x00, 0xA3);
+  fingerID = ((uint16_t) packet.data[1] << 8) | packet.data[2];
+  confidence = ((uint16_t) packet.data[3] << 8) | packet.data[4];
+  return packet.data[0];
+}
+
+uint8_t Adafruit_Fingerprint::fingerSearch(uint8_t slot) {
+  GET_CMD_PACKET(FINGERPRINT_SEARCH, slot, 0x00, 0x00, (uint8_t) (capacity >> 8), (uint8_t) (capacity & 0xFF));
+  fingerID = ((uint16_t) packet.data[1] << 8) | packet.data[2];
+  confidence = ((uint16_t) packet.data[3] << 8) | packet.data[4];
+  return packet.data[0];
+}
+
+uint8_t Adafruit_Fingerprint::getTemplateCount(void) {
+  GET_CMD_PACKET(FINGERPRINT_TEMPLATECOUNT);
+  templateCount = ((uint16_t) packet.data[1] << 8) | packet.data[2];
+  return packet.data[0];
+}
+
+uint8_t Adafruit_Fingerprint::setPassword(uint32_t password) {
+  SEND_CMD_PACKET(FINGERPRINT_SETPASSWORD, (uint8_t) (password >> 24), (uint8_t) (password >> 16),
+                  (uint8_t) (password >> 8), (uint8_t) (password & 0xFF));
+}
+
+uint8_t Adafruit_Fingerprint::LEDcontrol(bool on) {
+  if (on) {
+    SEND_CMD_PACKET(FINGERPRINT_LEDON);
+  } else {
+    SEND_CMD_PACKET(FINGERPRINT_LEDOFF);
+  }
+}
+
+uint8_t Adafruit_Fingerprint::LEDcontrol(uint8_t control, uint8_t speed, uint8_t coloridx, uint8_t count) {
+  SEND_CMD_PACKET(FINGERPRINT_AURALEDCONFIG, control, speed, coloridx, count);
+}
@@ -0,0 +1,407 @@
+// Host soak bench for the scan/publish path: the real component code, a simulated R503
+// behind the UART and a counting operator new. After a warm-up that touches every path
+// once (connect, every enrolled finger, unknown fingers, template refresh, heartbeats,
+// touch ring on and off), it runs millions of scans and fails unless the steady state
+// made no heap allocation and left the heap exactly as it found it.
+//
+// Build and run from the repository root:
+//
+//   g++ -std=gnu++17 -O2 -Itools/soak -Itools/soak/stubs -Icomponents/fingerprint_doorbell tools/soak/scan_soak.cpp tools/soak/host_stubs.cpp components/fingerprint_doorbell/*.cpp -o /tmp/scan_soak && /tmp/scan_soak [scans]
+//
+// scans defaults to 2000000. To cover more paths, add -DUSE_FINGERPRINT_DOORBELL_REST
+// (queue polling), -DUSE_FINGERPRINT_DOORBELL_MULTICAST (datagrams to 127.0.0.1) or
+// -DUSE_FINGERPRINT_DOORBELL_TIERED -DUSE_FINGERPRINT_DOORBELL_TEMPLATE_IO (in-RAM
+// partition, no cold templates). Logging is compiled out; the sensor answers at once
+// but the clock advances by a typical duration per command.
+
+#include <malloc.h>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "fingerprint_doorbell.h"
+#include "soak_host.h"
+
+using namespace esphome;
+using namespace esphome::fingerprint_doorbell;
+
+// ==================== ALLOCATION COUNTER ====================
+
+struct HeapCounters {
+  uint64_t allocations{0};
+  uint64_t frees{0};
+  int64_t live_blocks{0};
+  int64_t live_bytes{0};
+};
+static HeapCounters heap;
+
+static void *counted_alloc(size_t size) {
+  void *p = malloc(size != 0 ? size : 1);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  heap.allocations++;
+  heap.live_blocks++;
+  heap.live_bytes += malloc_usable_size(p);
+  return p;
+}
+
+static void counted_free(void *p) {
+  if (p == nullptr)
+    return;
+  heap.frees++;
+  heap.live_blocks--;
+  heap.live_bytes -= malloc_usable_size(p);
+  free(p);
+}
+
+void *operator new(size_t size) { return counted_alloc(size); }
+void *operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void *p) noexcept { counted_free(p); }
+void operator delete[](void *p) noexcept { counted_free(p); }
+void operator delete(void *p, size_t) noexcept { counted_free(p); }
+void operator delete[](void *p, size_t) noexcept { counted_free(p); }
+
+// ==================== SIMULATED SENSOR ====================
+
+static const uint16_t ENROLLED = 20;  // IDs 1..20 are in the library
+static const uint16_t CAPACITY = 200;
+static const uint64_t VISIT_PERIOD_US = 3000000;  // A finger arrives every 3 s...
+static const uint64_t VISIT_TOUCH_US = 700000;    // ...and stays for 0.7 s
+static const uint64_t LOOP_INTERVAL_US = 16000;   // ESPHome's default loop interval
+
+// An R503 that answers every command at once, with the finger from the current visit:
+// three visits out of four bring enrolled fingers in turn, the fourth an unknown one
+class SimulatedSensor : public uart::UARTComponent {
+ public:
+  struct Counters {
+    uint64_t commands{0};
+    uint64_t get_images{0};
+    uint64_t matches{0};
+    uint64_t not_found{0};
+    uint64_t stores{0};
+    uint64_t handshakes{0};
+    uint64_t leds{0};
+    uint64_t other{0};
+  };
+
+  static uint64_t visit() { return soak::clock_us() / VISIT_PERIOD_US; }
+  static bool finger_present() { return soak::clock_us() % VISIT_PERIOD_US < VISIT_TOUCH_US; }
+  static uint16_t finger_id() { return visit() % 4 == 3 ? 0 : 1 + visit() % ENROLLED; }
+
+  void write_array(const uint8_t *data, size_t len) override {
+    for (size_t i = 0; i < len; i++)
+      this->on_tx(data[i]);
+  }
+  bool read_array(uint8_t *data, size_t len) override {
+    if (this->rx_count_ < len)
+      return false;
+    for (size_t i = 0; i < len; i++) {
+      data[i] = this->rx_[this->rx_head_];
+      this->rx_head_ = (this->rx_head_ + 1) % this->rx_.size();
+      this->rx_count_--;
+    }
+    return true;
+  }
+  bool peek_byte(uint8_t *data) override {
+    if (this->rx_count_ == 0)
+      return false;
+    *data = this->rx_[this->rx_head_];
+    return true;
+  }
+  int available() override { return this->rx_count_; }
+
+  const Counters &counters() const { return this->counters_; }
+
+ protected:
+  void on_tx(uint8_t byte) {
+    if (this->tx_len_ == 0 && byte != 0xEF)
+      return;
+    this->tx_[this->tx_len_++] = byte;
+    if (this->tx_len_ < 9)
+      return;
+    size_t total = 9 + ((this->tx_[7] << 8) | this->tx_[8]);
+    if (total > this->tx_.size()) {
+      this->tx_len_ = 0;
+      return;
+    }
+    if (this->tx_len_ < total)
+      return;
+    this->tx_len_ = 0;
+    if (this->tx_[6] == FINGERPRINT_COMMANDPACKET)
+      this->on_command(this->tx_.data() + 9);
+  }
+
+  void on_command(const uint8_t *data) {
+    this->counters_.commands++;
+    switch (data[0]) {
+      case FINGERPRINT_VERIFYPASSWORD:
+        this->reply(FINGERPRINT_OK);
+        break;
+      case FINGERPRINT_READSYSPARAM: {
+        // status, system id, capacity, security level, address, packet size 128, 57600 baud
+        const uint8_t params[16] = {0, 0, 0, 0, CAPACITY >> 8, CAPACITY & 0xFF, 0, 3, 0xFF, 0xFF, 0xFF, 0xFF, 0, 2,
+                                    0, 6};
+        this->reply(FINGERPRINT_OK, params, sizeof(params));
+        break;
+      }
+      case FINGERPRINT_TEMPLATECOUNT: {
+        const uint8_t count[2] = {0, ENROLLED};
+        this->reply(FINGERPRINT_OK, count, sizeof(count));
+        break;
+      }
+      case 0x1F: {  // ReadIndexTable: IDs 1..ENROLLED on page 0
+        uint8_t table[32] = {};
+        for (uint16_t id = 1; data[1] == 0 && id <= ENROLLED; id++)
+          table[id / 8] |= 1 << (id % 8);
+        this->reply(FINGERPRINT_OK, table, sizeof(table));
+        break;
+      }
+      case FINGERPRINT_GETIMAGE:
+        this->counters_.get_images++;
+        if (finger_present()) {
+          soak::advance_us(45000);
+          this->reply(FINGERPRINT_OK);
+        } else {
+          soak::advance_us(8000);
+          this->reply(FINGERPRINT_NOFINGER);
+        }
+        break;
+      case FINGERPRINT_IMAGE2TZ:
+        soak::advance_us(120000);
+        this->reply(FINGERPRINT_OK);
+        break;
+      case FINGERPRINT_SEARCH: {
+        soak::advance_us(25000);
+        uint16_t id = finger_id();
+        if (id == 0) {
+          this->counters_.not_found++;
+          this->reply(FINGERPRINT_NOTFOUND);
+          break;
+        }
+        this->counters_.matches++;
+        const uint8_t result[4] = {(uint8_t) (id >> 8), (uint8_t) (id & 0xFF), 0, 180};
+        this->reply(FINGERPRINT_OK, result, sizeof(result));
+        break;
+      }
+      case FINGERPRINT_LOAD:
+      case FINGERPRINT_REGMODEL:
+        soak::advance_us(40000);
+        this->reply(FINGERPRINT_OK);
+        break;
+      case FINGERPRINT_STORE:
+        soak::advance_us(60000);
+        this->counters_.stores++;
+        this->reply(FINGERPRINT_OK);
+        break;
+      case FINGERPRINT_AURALEDCONFIG:
+        soak::advance_us(3000);
+        this->counters_.leds++;
+        this->reply(FINGERPRINT_OK);
+        break;
+      case 0x40:  // HandShake
+        this->counters_.handshakes++;
+        this->reply(FINGERPRINT_OK);
+        break;
+      default:
+        this->counters_.other++;
+        this->reply(FINGERPRINT_PACKETRECIEVEERR);
+        break;
+    }
+  }
+
+  void reply(uint8_t code, const uint8_t *extra = nullptr, size_t size = 0) {
+    uint16_t length = size + 3;  // code + payload + checksum
+    uint8_t header[10] = {0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, FINGERPRINT_ACKPACKET, (uint8_t) (length >> 8),
+                          (uint8_t) (length & 0xFF), code};
+    uint16_t sum = FINGERPRINT_ACKPACKET + (length >> 8) + (length & 0xFF) + code;
+    for (uint8_t byte : header)
+      this->push(byte);
+    for (size_t i = 0; i < size; i++) {
+      this->push(extra[i]);
+      sum += extra[i];
+    }
+    this->push(sum >> 8);
+    this->push(sum & 0xFF);
+  }
+
+  void push(uint8_t byte) {
+    if (this->rx_count_ == this->rx_.size())
+      return;  // Overrun, like a full UART FIFO
+    this->rx_[(this->rx_head_ + this->rx_count_) % this->rx_.size()] = byte;
+    this->rx_count_++;
+  }
+
+  std::array<uint8_t, 256> tx_{};
+  size_t tx_len_{0};
+  std::array<uint8_t, 512> rx_{};
+  size_t rx_head_{0};
+  size_t rx_count_{0};
+  Counters counters_;
+};
+
+// Touch ring wired to the simulated finger: LOW while touched
+class TouchPin : public GPIOPin {
+ public:
+  bool digital_read() override { return !SimulatedSensor::finger_present(); }
+};
+
+class OutputPin : public GPIOPin {
+ public:
+  void digital_write(bool value) override {
+    if (value && !this->state)
+      this->rises++;
+    this->state = value;
+  }
+  bool state{false};
+  uint64_t rises{0};
+};
+
+// Exposes the counters the bench reports
+class SoakDoorbell : public FingerprintDoorbell {
+ public:
+  using FingerprintDoorbell::link_down_count_;
+  using FingerprintDoorbell::publish_stats_;
+  using FingerprintDoorbell::sensor_connected_;
+  using FingerprintDoorbell::unlock_count_;
+};
+
+// ==================== BENCH ====================
+
+struct HeapSnapshot {
+  HeapCounters counters;
+  size_t arena;
+  size_t in_use;
+  size_t free;
+  size_t scheduler_items;
+};
+
+static HeapSnapshot snapshot() {
+  struct mallinfo2 info = mallinfo2();
+  return {heap, info.arena, info.uordblks, info.fordblks, soak::scheduler_items()};
+}
+
+static void store_name(uint16_t id, const char *name) {
+  std::array<char, 32> entry{};
+  snprintf(entry.data(), entry.size(), "%s", name);
+  char key[16];
+  snprintf(key, sizeof(key), "fp_%u", (unsigned) id);
+  soak_pref_save(fnv1_hash(key), &entry, sizeof(entry));
+}
+
+int main(int argc, char **argv) {
+  uint64_t target_scans = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+
+  SimulatedSensor sensor;
+  TouchPin touch_pin;
+  OutputPin doorbell_pin, unlock_pin;
+  sensor::Sensor match_id, confidence;
+  text_sensor::TextSensor match_name, last_action, enroll_status;
+  binary_sensor::BinarySensor ring, finger, unlocked;
+
+  SoakDoorbell doorbell;
+  doorbell.set_uart_parent(&sensor);
+  doorbell.set_touch_pin(&touch_pin);
+  doorbell.set_doorbell_pin(&doorbell_pin);
+  doorbell.set_unlock_pin(&unlock_pin);
+  doorbell.set_unlock_duration(2000);
+  doorbell.add_access_window(ACCESS_ALL_DAYS, 0, 0, {});
+  doorbell.set_match_id_sensor(&match_id);
+  doorbell.set_confidence_sensor(&confidence);
+  doorbell.set_match_name_sensor(&match_name);
+  doorbell.set_ring_sensor(&ring);
+  doorbell.set_finger_sensor(&finger);
+  doorbell.set_unlock_sensor(&unlocked);
+  doorbell.set_enroll_status_sensor(&enroll_status);
+  doorbell.set_last_action_sensor(&last_action);
+  doorbell.set_template_refresh(true);
+  doorbell.set_template_refresh_min_confidence(100);
+  doorbell.set_template_refresh_interval(60000);
+#ifdef USE_FINGERPRINT_DOORBELL_MULTICAST
+  doorbell.set_api_token("soak");
+  doorbell.set_event_multicast("127.0.0.1", 47068);
+#endif
+#ifdef USE_FINGERPRINT_DOORBELL_TIERED
+  doorbell.set_cold_storage_partition("cold");
+  doorbell.set_hot_slots(170);
+  doorbell.set_cache_slots(10);
+#endif
+  for (uint16_t id = 1; id <= ENROLLED; id++) {
+    char name[32];
+    snprintf(name, sizeof(name), "Resident %u with a long name", (unsigned) id);
+    store_name(id, name);
+  }
+
+  doorbell.setup();
+
+  // Every visit kind and both touch ring modes, several times over
+  uint64_t loops = 0;
+  auto run_until = [&](auto done) {
+    while (!done()) {
+      soak::advance_us(LOOP_INTERVAL_US);
+      // Alternate touch ring and no-touch-ring (every loop a GetImage) every 50 visits
+      doorbell.set_ignore_touch_ring_state(SimulatedSensor::visit() / 50 % 2 == 1);
+      doorbell.loop();
+      loops++;
+    }
+  };
+  uint64_t warmup_end = soak::clock_us() + 400 * VISIT_PERIOD_US;
+  run_until([&] { return soak::clock_us() >= warmup_end; });
+
+  if (!doorbell.sensor_connected_) {
+    printf("FAIL: the simulated sensor never connected\n");
+    return 1;
+  }
+
+  HeapSnapshot before = snapshot();
+  SimulatedSensor::Counters start = sensor.counters();
+  uint64_t start_loops = loops, start_us = soak::clock_us();
+  uint64_t start_rises = doorbell_pin.rises, start_unlocks = unlock_pin.rises;
+  PublishStats start_publish = doorbell.publish_stats_;
+
+  run_until([&] { return sensor.counters().get_images - start.get_images >= target_scans; });
+
+  HeapSnapshot after = snapshot();
+  const SimulatedSensor::Counters &end = sensor.counters();
+  uint64_t allocations = after.counters.allocations - before.counters.allocations;
+  uint64_t frees = after.counters.frees - before.counters.frees;
+
+  printf("Scans:        %" PRIu64 " (GetImage) in %" PRIu64 " loops, %.1f simulated hours\n",
+         end.get_images - start.get_images, loops - start_loops, (soak::clock_us() - start_us) / 3.6e9);
+  printf("Events:       %" PRIu64 " matches, %" PRIu64 " rings, %" PRIu64 " unlocks, %" PRIu64
+         " template refreshes, %" PRIu64 " heartbeats, %" PRIu64 " LED commands\n",
+         end.matches - start.matches, doorbell_pin.rises - start_rises, unlock_pin.rises - start_unlocks,
+         end.stores - start.stores, end.handshakes - start.handshakes, end.leds - start.leds);
+  printf("Publishes:    %u sent, %u suppressed, %u coalesced, %u deferred\n",
+         (unsigned) (doorbell.publish_stats_.published - start_publish.published),
+         (unsigned) (doorbell.publish_stats_.suppressed - start_publish.suppressed),
+         (unsigned) (doorbell.publish_stats_.coalesced - start_publish.coalesced),
+         (unsigned) (doorbell.publish_stats_.deferred - start_publish.deferred));
+  printf("Allocations:  %" PRIu64 " during warm-up, %" PRIu64 " new / %" PRIu64 " delete during the soak\n",
+         before.counters.allocations, allocations, frees);
+  printf("Live heap:    %" PRId64 " -> %" PRId64 " blocks, %" PRId64 " -> %" PRId64 " bytes\n",
+         before.counters.live_blocks, after.counters.live_blocks, before.counters.live_bytes,
+         after.counters.live_bytes);
+  printf("malloc arena: %zu -> %zu bytes, in use %zu -> %zu, free %zu -> %zu\n", before.arena, after.arena,
+         before.in_use, after.in_use, before.free, after.free);
+
+  bool ok = true;
+  auto check = [&](bool condition, const char *what) {
+    if (!condition) {
+      printf("FAIL: %s\n", what);
+      ok = false;
+    }
+  };
+  check(allocations == 0 && frees == 0, "the scan path allocated after warm-up");
+  check(after.counters.live_blocks == before.counters.live_blocks &&
+            after.counters.live_bytes == before.counters.live_bytes,
+        "live heap changed");
+  check(after.arena == before.arena && after.in_use == before.in_use && after.free == before.free,
+        "malloc arena changed (fragmentation)");
+  check(after.scheduler_items == before.scheduler_items, "scheduler items were added");
+  check(doorbell.link_down_count_ == 0, "the link went down");
+  check(end.matches > start.matches && doorbell_pin.rises > start_rises && end.stores > start.stores,
+        "a scan outcome was never exercised");
+  printf("%s\n", ok ? "SOAK OK" : "SOAK FAILED");
+  return ok ? 0 : 1;
+}
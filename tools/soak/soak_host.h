@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Bench-side controls of the host stubs (host_stubs.cpp)
+namespace soak {
+
+// Virtual clock behind millis(), micros(), delay() and esp_timer_get_time()
+void advance_us(uint64_t us);
+uint64_t clock_us();
+
+// set_timeout()/defer() items currently held by the stub scheduler
+size_t scheduler_items();
+
+}  // namespace soak
@@ -0,0 +1,98 @@
+#pragma once
+#include "Arduino.h"
+#define FINGERPRINT_OK 0x00
+#define FINGERPRINT_PACKETRECIEVEERR 0x01
+#define FINGERPRINT_NOFINGER 0x02
+#define FINGERPRINT_IMAGEFAIL 0x03
+#define FINGERPRINT_IMAGEMESS 0x06
+#define FINGERPRINT_FEATUREFAIL 0x07
+#define FINGERPRINT_NOMATCH 0x08
+#define FINGERPRINT_NOTFOUND 0x09
+#define FINGERPRINT_ENROLLMISMATCH 0x0A
+#define FINGERPRINT_BADLOCATION 0x0B
+#define FINGERPRINT_DBREADFAIL 0x0C
+#define FINGERPRINT_UPLOADFEATUREFAIL 0x0D
+#define FINGERPRINT_PACKETRESPONSEFAIL 0x0E
+#define FINGERPRINT_UPLOADFAIL 0x0F
+#define FINGERPRINT_DELETEFAIL 0x10
+#define FINGERPRINT_DBCLEARFAIL 0x11
+#define FINGERPRINT_PASSFAIL 0x13
+#define FINGERPRINT_INVALIDIMAGE 0x15
+#define FINGERPRINT_FLASHERR 0x18
+#define FINGERPRINT_INVALIDREG 0x1A
+#define FINGERPRINT_ADDRCODE 0x20
+#define FINGERPRINT_PASSVERIFY 0x21
+#define FINGERPRINT_STARTCODE 0xEF01
+#define FINGERPRINT_COMMANDPACKET 0x1
+#define FINGERPRINT_DATAPACKET 0x2
+#define FINGERPRINT_ACKPACKET 0x7
+#define FINGERPRINT_ENDDATAPACKET 0x8
+#define FINGERPRINT_TIMEOUT 0xFF
+#define FINGERPRINT_BADPACKET 0xFE
+#define FINGERPRINT_GETIMAGE 0x01
+#define FINGERPRINT_IMAGE2TZ 0x02
+#define FINGERPRINT_SEARCH 0x04
+#define FINGERPRINT_REGMODEL 0x05
+#define FINGERPRINT_STORE 0x06
+#define FINGERPRINT_LOAD 0x07
+#define FINGERPRINT_UPLOAD 0x08
+#define FINGERPRINT_DELETE 0x0C
+#define FINGERPRINT_EMPTY 0x0D
+#define FINGERPRINT_READSYSPARAM 0x0F
+#define FINGERPRINT_SETPASSWORD 0x12
+#define FINGERPRINT_VERIFYPASSWORD 0x13
+#define FINGERPRINT_HISPEEDSEARCH 0x1B
+#define FINGERPRINT_TEMPLATECOUNT 0x1D
+#define FINGERPRINT_AURALEDCONFIG 0x35
+#define FINGERPRINT_LEDON 0x50
+#define FINGERPRINT_LEDOFF 0x51
+#define FINGERPRINT_LED_BREATHING 0x01
+#define FINGERPRINT_LED_FLASHING 0x02
+#define FINGERPRINT_LED_ON 0x03
+#define FINGERPRINT_LED_OFF 0x04
+#define FINGERPRINT_LED_GRADUAL_ON 0x05
+#define FINGERPRINT_LED_GRADUAL_OFF 0x06
+#define FINGERPRINT_LED_RED 0x01
+#define FINGERPRINT_LED_BLUE 0x02
+#define FINGERPRINT_LED_PURPLE 0x03
+#define DEFAULTTIMEOUT 1000
+struct Adafruit_Fingerprint_Packet {
+  Adafruit_Fingerprint_Packet(uint8_t type, uint16_t length, uint8_t *data) { this->start_code = FINGERPRINT_STARTCODE; this->type = type; this->length = length; address[0]=address[1]=address[2]=address[3]=0xFF; if (length < 64) memcpy(this->data, data, length); else memcpy(this->data, data, 64); }
+  uint16_t start_code; uint8_t address[4]; uint8_t type; uint16_t length; uint8_t data[64];
+};
+class Adafruit_Fingerprint {
+ public:
+  Adafruit_Fingerprint(HardwareSerial *hs, uint32_t password = 0x0);
+  Adafruit_Fingerprint(Stream *serial, uint32_t password = 0x0);
+  void begin(uint32_t baud);
+  bool verifyPassword(void);
+  uint8_t getParameters(void);
+  uint8_t getImage(void);
+  uint8_t image2Tz(uint8_t slot = 1);
+  uint8_t createModel(void);
+  uint8_t emptyDatabase(void);
+  uint8_t storeModel(uint16_t id, uint8_t slot = 1);
+  uint8_t loadModel(uint16_t id, uint8_t slot = 1);
+  uint8_t getModel(void);
+  uint8_t deleteModel(uint16_t id);
+  uint8_t fingerFastSearch(void);
+  uint8_t fingerSearch(uint8_t slot = 1);
+  uint8_t getTemplateCount(void);
+  uint8_t setPassword(uint32_t password);
+  uint8_t LEDcontrol(bool on);
+  uint8_t LEDcontrol(uint8_t control, uint8_t speed, uint8_t coloridx, uint8_t count = 0);
+  uint8_t setBaudRate(uint8_t baudrate);
+  uint8_t setSecurityLevel(uint8_t level);
+  uint8_t setPacketSize(uint8_t size);
+  void writeStructuredPacket(const Adafruit_Fingerprint_Packet &p);
+  uint8_t getStructuredPacket(Adafruit_Fingerprint_Packet *p, uint16_t timeout = DEFAULTTIMEOUT);
+  uint16_t fingerID; uint16_t confidence; uint16_t templateCount;
+  uint16_t status_reg = 0x0; uint16_t system_id = 0x0; uint16_t capacity = 64; uint16_t security_level = 0;
+  uint32_t device_addr = 0xFFFFFFFF; uint16_t packet_len = 64; uint16_t baud_rate = 57600;
+
+ private:
+  uint8_t checkPassword(void);
+  Stream *mySerial{nullptr};
+  uint32_t thePassword;
+  uint32_t theAddress{0xFFFFFFFF};
+};
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <sys/types.h>
+#define SERIAL_8N1 0x800001c
+class Print { public: virtual size_t write(uint8_t) = 0; virtual size_t write(const uint8_t *buffer, size_t size) { size_t n = 0; while (size--) n += write(*buffer++); return n; } size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); } virtual void flush() {} };
+class Stream : public Print { public: virtual int available() = 0; virtual int read() = 0; virtual int peek() = 0; using Print::write; };
+class HardwareSerial : public Stream { public: void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {} void end() {} size_t setRxBufferSize(size_t) { return 0; } int available() override { return 0; } int read() override { return -1; } int peek() override { return -1; } size_t write(uint8_t) override { return 1; } size_t write(const uint8_t *b, size_t s) override { return s; } using Print::write; };
+extern HardwareSerial Serial2;
+uint32_t esp_get_free_heap_size(); uint32_t esp_get_minimum_free_heap_size();
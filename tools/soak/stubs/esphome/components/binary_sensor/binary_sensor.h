@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+namespace esphome {
+namespace binary_sensor {
+class BinarySensor {
+ public:
+  void publish_state(bool state) {
+    this->state = state;
+    this->publish_count++;
+  }
+  bool has_state() const { return this->publish_count > 0; }
+  bool state{false};
+  uint32_t publish_count{0};
+};
+}  // namespace binary_sensor
+}  // namespace esphome
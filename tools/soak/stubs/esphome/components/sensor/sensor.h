@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+namespace esphome {
+namespace sensor {
+class Sensor {
+ public:
+  void publish_state(float state) {
+    this->state = state;
+    this->publish_count++;
+  }
+  bool get_force_update() const { return false; }
+  bool has_state() const { return this->publish_count > 0; }
+  float state{0};
+  uint32_t publish_count{0};
+};
+}  // namespace sensor
+}  // namespace esphome
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <string>
+namespace esphome {
+namespace text_sensor {
+// Like the real entity, the state is a std::string member that is assigned on publish
+class TextSensor {
+ public:
+  void publish_state(const std::string &state) {
+    this->state = state;
+    this->publish_count++;
+  }
+  bool has_state() const { return this->publish_count > 0; }
+  std::string state;
+  uint32_t publish_count{0};
+};
+}  // namespace text_sensor
+}  // namespace esphome
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "esphome/core/component.h"
+namespace esphome {
+namespace uart {
+
+// Virtual so the bench can put a simulated sensor behind it
+class UARTComponent {
+ public:
+  virtual ~UARTComponent() = default;
+  virtual void write_array(const uint8_t *data, size_t len) = 0;
+  virtual bool read_array(uint8_t *data, size_t len) = 0;
+  virtual bool peek_byte(uint8_t *data) = 0;
+  virtual bool read_byte(uint8_t *data) { return this->read_array(data, 1); }
+  virtual int available() = 0;
+  virtual void flush() {}
+  uint32_t get_baud_rate() const { return 57600; }
+  size_t get_rx_buffer_size() { return 256; }
+};
+
+class UARTDevice {
+ public:
+  UARTDevice() = default;
+  UARTDevice(UARTComponent *parent) : parent_(parent) {}
+  void set_uart_parent(UARTComponent *parent) { this->parent_ = parent; }
+  void write_byte(uint8_t data) { this->parent_->write_array(&data, 1); }
+  void write_array(const uint8_t *data, size_t len) { this->parent_->write_array(data, len); }
+  bool read_byte(uint8_t *data) { return this->parent_->read_byte(data); }
+  bool peek_byte(uint8_t *data) { return this->parent_->peek_byte(data); }
+  bool read_array(uint8_t *data, size_t len) { return this->parent_->read_array(data, len); }
+  int available() { return this->parent_->available(); }
+  void flush() { this->parent_->flush(); }
+  void check_uart_settings(uint32_t, uint8_t = 1, int = 0, uint8_t = 8) {}
+
+ protected:
+  UARTComponent *parent_{nullptr};
+};
+
+}  // namespace uart
+}  // namespace esphome
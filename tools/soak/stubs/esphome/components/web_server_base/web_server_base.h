@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include "esphome/core/optional.h"
+typedef int esp_err_t;
+struct httpd_req; typedef struct httpd_req httpd_req_t;
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status);
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type);
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value);
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t len);
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t len);
+#define ESP_OK 0
+#define HTTPD_RESP_USE_STRLEN -1
+enum http_method { HTTP_DELETE = 0, HTTP_GET = 1, HTTP_HEAD = 2, HTTP_POST = 3, HTTP_PUT = 4, HTTP_OPTIONS = 6 };
+namespace esphome { namespace web_server_idf {
+class AsyncWebParameter { public: const std::string &value() const { return v_; } std::string v_; };
+class AsyncWebServerResponse { public: void addHeader(const char *name, const char *value) {} };
+class AsyncResponseStream : public AsyncWebServerResponse { public: void print(const char *) {} void print(const std::string &) {} void printf(const char *fmt, ...) {} void write(const uint8_t *, size_t) {} };
+class AsyncWebServerRequest {
+ public:
+  http_method method() const { return HTTP_GET; }
+  std::string url() const { return ""; }
+  size_t contentLength() const { return 0; }
+  void send(AsyncWebServerResponse *r) {}
+  void send(int code, const char *content_type = nullptr, const char *content = nullptr) {}
+  AsyncWebServerResponse *beginResponse(int code, const char *content_type) { return nullptr; }
+  AsyncWebServerResponse *beginResponse(int code, const char *content_type, const std::string &content) { return nullptr; }
+  AsyncWebServerResponse *beginResponse(int code, const char *content_type, const uint8_t *data, const size_t data_size) { return nullptr; }
+  AsyncResponseStream *beginResponseStream(const char *content_type) { return nullptr; }
+  bool hasParam(const std::string &name) { return false; }
+  AsyncWebParameter *getParam(const std::string &name) { return nullptr; }
+  bool hasArg(const char *name) { return false; }
+  std::string arg(const std::string &name) { return ""; }
+  optional<std::string> get_header(const char *name) const { return {}; }
+  bool hasHeader(const char *name) const { return false; }
+  operator httpd_req_t *() const { return nullptr; }
+};
+class AsyncWebHandler { public: virtual ~AsyncWebHandler() {} virtual bool canHandle(AsyncWebServerRequest *request) const { return false; } virtual void handleRequest(AsyncWebServerRequest *request) {} virtual void handleUpload(AsyncWebServerRequest *request, const std::string &filename, size_t index, uint8_t *data, size_t len, bool final) {} virtual void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {} virtual bool isRequestHandlerTrivial() const { return true; } };
+} 
+namespace web_server_base { class WebServerBase { public: void init() {} void add_handler(web_server_idf::AsyncWebHandler *) {} }; extern WebServerBase *global_web_server_base; }
+using web_server_idf::AsyncWebHandler; using web_server_idf::AsyncWebServerRequest; using web_server_idf::AsyncWebServerResponse; using web_server_idf::AsyncResponseStream; using web_server_idf::AsyncWebParameter;
+}
@@ -0,0 +1,3 @@
+#pragma once
+#include <cstdint>
+namespace esphome { class Application { public: void feed_wdt() {} }; extern Application App; }
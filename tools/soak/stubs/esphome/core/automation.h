@@ -0,0 +1,10 @@
+#pragma once
+#include "esphome/core/component.h"
+#include <functional>
+namespace esphome {
+template<typename T, typename... X> class TemplatableValue { public: TemplatableValue() {} TemplatableValue(T v) : v_(v) {} T value(X... x) { return v_; } bool has_value() const { return true; } T v_{}; };
+#define TEMPLATABLE_VALUE_(type, name) protected: TemplatableValue<type, Ts...> name##_{}; public: template<typename V> void set_##name(V name) { this->name##_ = name; }
+#define TEMPLATABLE_VALUE(type, name) TEMPLATABLE_VALUE_(type, name)
+template<typename... Ts> class Action { public: virtual void play(Ts... x) = 0; };
+template<typename... Ts> class Trigger { public: void trigger(Ts... x) {} };
+}
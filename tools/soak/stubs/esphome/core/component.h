@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <array>
+#include <vector>
+#include "esphome/core/optional.h"
+namespace esphome {
+namespace setup_priority { extern const float WIFI; extern const float DATA; extern const float HARDWARE; }
+class Component {
+ public:
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0; }
+  // Scheduler items are kept on the heap like the real scheduler's (host_stubs.cpp) but
+  // never run: the scan path must not create any
+  void set_timeout(uint32_t timeout, std::function<void()> &&f) { this->set_timeout("", timeout, std::move(f)); }
+  void set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f);
+  bool cancel_timeout(const std::string &name);
+  void set_interval(uint32_t interval, std::function<void()> &&f) { this->set_timeout("", interval, std::move(f)); }
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {
+    this->set_timeout(name, interval, std::move(f));
+  }
+  bool cancel_interval(const std::string &name) { return this->cancel_timeout(name); }
+  void defer(std::function<void()> &&f) { this->set_timeout("", 0, std::move(f)); }
+  void defer(const std::string &name, std::function<void()> &&f) { this->set_timeout(name, 0, std::move(f)); }
+  void status_set_warning(const char *m = nullptr) {}
+  void status_clear_warning() {}
+  void mark_failed() {}
+};
+template<typename T> class Parented { public: void set_parent(T *p) { parent_ = p; } protected: T *parent_; };
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Arduino.h"
+namespace esphome {
+uint32_t millis(); uint32_t micros(); void delay(uint32_t); void delayMicroseconds(uint32_t);
+namespace gpio { enum Flags : uint8_t { FLAG_NONE=0, FLAG_INPUT=1, FLAG_OUTPUT=2, FLAG_PULLUP=4, FLAG_PULLDOWN=8 }; }
+class GPIOPin { public: virtual void setup() {} virtual void pin_mode(int) {} virtual bool digital_read() { return false; } virtual void digital_write(bool) {} virtual std::string dump_summary() const { return ""; } };
+}
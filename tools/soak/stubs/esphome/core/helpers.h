@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+namespace esphome {
+uint32_t fnv1_hash(const std::string &str);
+uint32_t random_uint32();
+uint16_t crc16(const uint8_t *data, uint16_t len, uint16_t crc = 0xffff, uint16_t reverse_poly = 0xa001, bool refin = false, bool refout = false);
+std::string str_sprintf(const char *fmt, ...);
+std::string format_hex(const uint8_t *data, size_t length);
+template<typename T> class RAMAllocator { public: T *allocate(size_t n) { return new T[n]; } void deallocate(T *p, size_t n) { delete[] p; } };
+class HighFrequencyLoopRequester { public: void start() {} void stop() {} };
+}
+namespace esphome {
+class Mutex { public: Mutex() {} void lock() {} bool try_lock() { return true; } void unlock() {} };
+class LockGuard { public: LockGuard(Mutex &mutex) : mutex_(mutex) { mutex.lock(); } ~LockGuard() { mutex_.unlock(); } private: Mutex &mutex_; };
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdio>
+
+// The bench measures the component, not the logger: log calls are format-checked and dropped
+__attribute__((format(printf, 1, 2))) inline void soak_log(const char *, ...) {}
+
+#define ESP_LOGE(tag, ...) soak_log(__VA_ARGS__)
+#define ESP_LOGW(tag, ...) soak_log(__VA_ARGS__)
+#define ESP_LOGI(tag, ...) soak_log(__VA_ARGS__)
+#define ESP_LOGD(tag, ...) soak_log(__VA_ARGS__)
+#define ESP_LOGV(tag, ...) soak_log(__VA_ARGS__)
+#define ESP_LOGVV(tag, ...) soak_log(__VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) soak_log(__VA_ARGS__)
+#define YESNO(b) ((b) ? "YES" : "NO")
+#define ONOFF(b) ((b) ? "ON" : "OFF")
+#define LOG_PIN(prefix, pin) do { (void)(pin); } while (0)
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+namespace esphome {
+
+// In-memory store keyed by the preference hash (host_stubs.cpp)
+bool soak_pref_save(uint32_t key, const void *data, size_t size);
+bool soak_pref_load(uint32_t key, void *data, size_t size);
+
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  explicit ESPPreferenceObject(uint32_t key) : key_(key) {}
+  template<typename T> bool save(const T *src) { return soak_pref_save(this->key_, src, sizeof(T)); }
+  template<typename T> bool load(T *dest) { return soak_pref_load(this->key_, dest, sizeof(T)); }
+
+ protected:
+  uint32_t key_{0};
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash = false) {
+    return ESPPreferenceObject(type);
+  }
+  bool sync();
+};
+
+extern ESPPreferences *global_preferences;
+
+}  // namespace esphome